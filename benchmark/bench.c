@@ -0,0 +1,527 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Benchmark for libt3config. A config and a matching schema are generated from the parameters
+   given on the command line, using a fixed pseudo-random sequence such that the same parameters
+   always produce the same input. The results are printed as a single JSON object, such that they
+   can be compared between releases. */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <t3config/config.h>
+
+/* This header must be included after all the others to prevent issues with the
+   definition of _. */
+/* clang-format off */
+#include "optionMacros.h"
+/* clang-format on */
+
+static int option_width = 10;
+static int option_children = 2;
+static int option_depth = 4;
+static int option_list_length = 5;
+static int option_strings = 50;
+static int option_includes = 0;
+static int option_iterations = 20;
+static int option_lookups = 1000000;
+static int option_seed = 1;
+
+#ifdef __GNUC__
+void fatal(const char *fmt, ...) __attribute__((noreturn));
+#endif
+void fatal(const char *fmt, ...) {
+  va_list args;
+
+  va_start(args, fmt);
+  vfprintf(stderr, fmt, args);
+  va_end(args);
+  exit(EXIT_FAILURE);
+}
+
+/* clang-format off */
+static PARSE_FUNCTION(parse_args)
+  OPTIONS
+    OPTION('w', "width", REQUIRED_ARG)
+      PARSE_INT(option_width, 0, 10000);
+    END_OPTION
+    OPTION('c', "children", REQUIRED_ARG)
+      PARSE_INT(option_children, 0, 1000);
+    END_OPTION
+    OPTION('d', "depth", REQUIRED_ARG)
+      PARSE_INT(option_depth, 1, 64);
+    END_OPTION
+    OPTION('l', "list-length", REQUIRED_ARG)
+      PARSE_INT(option_list_length, 0, 100000);
+    END_OPTION
+    OPTION('s', "strings", REQUIRED_ARG)
+      PARSE_INT(option_strings, 0, 100);
+    END_OPTION
+    OPTION('I', "includes", REQUIRED_ARG)
+      PARSE_INT(option_includes, 0, 10000);
+    END_OPTION
+    OPTION('n', "iterations", REQUIRED_ARG)
+      PARSE_INT(option_iterations, 1, 1000000);
+    END_OPTION
+    OPTION('L', "lookups", REQUIRED_ARG)
+      PARSE_INT(option_lookups, 1, 1000000000);
+    END_OPTION
+    OPTION('S', "seed", REQUIRED_ARG)
+      PARSE_INT(option_seed, 0, 1000000000);
+    END_OPTION
+    OPTION('h', "help", NO_ARG)
+      printf("Usage: bench [<options>]\n"
+        "  -w<n>,--width=<n>          Number of values in each section (default 10)\n"
+        "  -c<n>,--children=<n>       Number of sub-sections in each section (default 2)\n"
+        "  -d<n>,--depth=<n>          Nesting depth of the sections (default 4)\n"
+        "  -l<n>,--list-length=<n>    Number of items in the list in each section (default 5)\n"
+        "  -s<n>,--strings=<n>        Percentage of the values that are strings (default 50)\n"
+        "  -I<n>,--includes=<n>       Number of included files (default 0)\n"
+        "  -n<n>,--iterations=<n>     Number of times each operation is repeated (default 20)\n"
+        "  -L<n>,--lookups=<n>        Number of lookups to time (default 1000000)\n"
+        "  -S<n>,--seed=<n>           Seed for generating the config (default 1)\n"
+      );
+      exit(EXIT_SUCCESS);
+    END_OPTION
+    DOUBLE_DASH
+      NO_MORE_OPTIONS;
+    END_OPTION
+
+    fatal("No such option " OPTFMT "\n", OPTPRARG);
+  NO_OPTION
+    fatal("Invalid argument %s\n", optcurrent);
+  END_OPTIONS
+END_FUNCTION
+/* clang-format on */
+
+/*==================== Memory accounting ====================*/
+
+/* Every block is preceded by its size, such that the number of bytes in use can be tracked. */
+typedef union {
+  size_t size;
+  /* Make sure the returned memory is suitably aligned for any type. */
+  long double align_float;
+  void *align_pointer;
+  uint64_t align_integer;
+} block_header_t;
+
+static size_t bytes_in_use, peak_bytes_in_use;
+
+static void *bench_allocate(size_t size, void *data) {
+  block_header_t *block;
+
+  (void)data;
+  if ((block = malloc(sizeof(block_header_t) + size)) == NULL) {
+    return NULL;
+  }
+  block->size = size;
+  bytes_in_use += size;
+  if (bytes_in_use > peak_bytes_in_use) {
+    peak_bytes_in_use = bytes_in_use;
+  }
+  return block + 1;
+}
+
+static void *bench_reallocate(void *ptr, size_t size, void *data) {
+  block_header_t *block;
+  size_t old_size;
+
+  if (ptr == NULL) {
+    return bench_allocate(size, data);
+  }
+  block = (block_header_t *)ptr - 1;
+  old_size = block->size;
+  if ((block = realloc(block, sizeof(block_header_t) + size)) == NULL) {
+    return NULL;
+  }
+  block->size = size;
+  bytes_in_use = bytes_in_use - old_size + size;
+  if (bytes_in_use > peak_bytes_in_use) {
+    peak_bytes_in_use = bytes_in_use;
+  }
+  return block + 1;
+}
+
+static void bench_release(void *ptr, void *data) {
+  block_header_t *block = (block_header_t *)ptr - 1;
+
+  (void)data;
+  bytes_in_use -= block->size;
+  free(block);
+}
+
+static const t3_config_allocator_t bench_allocator = {bench_allocate, bench_reallocate,
+                                                      bench_release, NULL};
+
+/*==================== Config generation ====================*/
+
+typedef struct {
+  char *data;
+  size_t length, size;
+} buffer_t;
+
+static void append(buffer_t *buffer, const char *fmt, ...) {
+  va_list args;
+  int length;
+
+  for (;;) {
+    va_start(args, fmt);
+    length = vsnprintf(buffer->data + buffer->length, buffer->size - buffer->length, fmt, args);
+    va_end(args);
+    if (length < 0) {
+      fatal("Error formatting config\n");
+    }
+    if ((size_t)length < buffer->size - buffer->length) {
+      buffer->length += length;
+      return;
+    }
+    buffer->size = buffer->size == 0 ? 4096 : buffer->size * 2;
+    if ((buffer->data = realloc(buffer->data, buffer->size)) == NULL) {
+      fatal("Out of memory\n");
+    }
+  }
+}
+
+static uint64_t random_state;
+
+/* xorshift64*, which is good enough for generating test data, and the same on every platform. */
+static uint32_t next_random(void) {
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return (uint32_t)((random_state * UINT64_C(2685821657736338717)) >> 32);
+}
+
+/* The type of each value is determined by its index, such that all sections have the same
+   layout, and can be described by the generated schema. */
+static const char *value_type(int index) {
+  if ((index * 37) % 100 < option_strings) {
+    return "string";
+  }
+  return index % 2 == 0 ? "int" : "number";
+}
+
+static void generate_section(buffer_t *buffer, int level, int indent) {
+  const char *type;
+  int i;
+
+  for (i = 0; i < option_width; i++) {
+    type = value_type(i);
+    if (strcmp(type, "string") == 0) {
+      append(buffer, "%*sk%d = \"value %08x\"\n", indent, "", i, next_random());
+    } else if (strcmp(type, "int") == 0) {
+      append(buffer, "%*sk%d = %d\n", indent, "", i, (int)(next_random() % 100000));
+    } else {
+      append(buffer, "%*sk%d = %u.%03u\n", indent, "", i, next_random() % 1000,
+             next_random() % 1000);
+    }
+  }
+  if (option_list_length > 0) {
+    append(buffer, "%*sl = (", indent, "");
+    for (i = 0; i < option_list_length; i++) {
+      append(buffer, i == 0 ? " %u" : ", %u", next_random() % 1000);
+    }
+    append(buffer, " )\n");
+  }
+  if (level + 1 < option_depth) {
+    for (i = 0; i < option_children; i++) {
+      append(buffer, "%*ss%d {\n", indent, "", i);
+      generate_section(buffer, level + 1, indent + 2);
+      append(buffer, "%*s}\n", indent, "");
+    }
+  }
+}
+
+/* Included files contain the sections of the second level, or of the first if there is only
+   one level. */
+static int include_level(void) { return option_depth > 1 ? 1 : 0; }
+
+static void generate_schema_keys(buffer_t *buffer, int level, int indent) {
+  int i;
+
+  for (i = 0; i < option_width; i++) {
+    append(buffer, "%*sk%d { type = \"%s\" }\n", indent, "", i, value_type(i));
+  }
+  if (option_list_length > 0) {
+    append(buffer, "%*sl { type = \"list\"; item-type = \"int\" }\n", indent, "");
+  }
+  if (level + 1 < option_depth) {
+    for (i = 0; i < option_children; i++) {
+      append(buffer, "%*ss%d { type = \"level%d\" }\n", indent, "", i, level + 1);
+    }
+  }
+}
+
+static void generate_schema(buffer_t *buffer) {
+  int level, i;
+
+  append(buffer, "types {\n");
+  for (level = 0; level < option_depth; level++) {
+    append(buffer, "  level%d {\n    type = \"section\"\n    allowed-keys {\n", level);
+    generate_schema_keys(buffer, level, 6);
+    append(buffer, "    }\n");
+    if (option_width > 0) {
+      append(buffer, "    %%constraint = \"k0\"\n");
+    }
+    append(buffer, "  }\n");
+  }
+  append(buffer, "}\nallowed-keys {\n");
+  generate_schema_keys(buffer, 0, 2);
+  for (i = 0; i < option_includes; i++) {
+    append(buffer, "  inc%d { type = \"level%d\" }\n", i, include_level());
+  }
+  append(buffer, "}\n");
+}
+
+static char include_dir[] = "/tmp/t3config-bench-XXXXXX";
+
+static void include_name(char *name, size_t size, int index) {
+  snprintf(name, size, "%s/inc%d.cfg", include_dir, index);
+}
+
+/** Write the included files, and add the include statements to @p buffer.
+    @return The total size of the included files.
+*/
+static size_t generate_includes(buffer_t *buffer) {
+  buffer_t contents = {NULL, 0, 0};
+  char name[sizeof(include_dir) + 32];
+  size_t total = 0;
+  FILE *file;
+  int i;
+
+  if (option_includes > 0 && mkdtemp(include_dir) == NULL) {
+    fatal("Could not create directory for included files\n");
+  }
+  for (i = 0; i < option_includes; i++) {
+    contents.length = 0;
+    generate_section(&contents, include_level(), 0);
+    include_name(name, sizeof(name), i);
+    if ((file = fopen(name, "w")) == NULL ||
+        fwrite(contents.data, 1, contents.length, file) != contents.length || fclose(file) != 0) {
+      fatal("Could not write %s\n", name);
+    }
+    total += contents.length;
+    append(buffer, "inc%d {\n  %%include = \"inc%d.cfg\"\n}\n", i, i);
+  }
+  free(contents.data);
+  return total;
+}
+
+static void remove_includes(void) {
+  char name[sizeof(include_dir) + 32];
+  int i;
+
+  if (option_includes == 0) {
+    return;
+  }
+  for (i = 0; i < option_includes; i++) {
+    include_name(name, sizeof(name), i);
+    unlink(name);
+  }
+  rmdir(include_dir);
+}
+
+/*==================== Benchmarks ====================*/
+
+static double now(void) {
+  struct timespec time;
+
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+static void read_failed(const char *what, const t3_config_error_t *error) {
+  fatal("%s:%d: %s: %s\n", what, error->line_number, t3_config_strerror(error->error),
+        error->extra == NULL ? "" : error->extra);
+}
+
+typedef struct {
+  const t3_config_t **sections;
+  size_t count, size;
+} section_list_t;
+
+static void collect_sections(section_list_t *list, const t3_config_t *section) {
+  const t3_config_t *item;
+
+  if (list->count == list->size) {
+    list->size = list->size == 0 ? 64 : list->size * 2;
+    if ((list->sections = realloc(list->sections, list->size * sizeof(t3_config_t *))) == NULL) {
+      fatal("Out of memory\n");
+    }
+  }
+  list->sections[list->count++] = section;
+  for (item = t3_config_get(section, NULL); item != NULL; item = t3_config_get_next(item)) {
+    if (t3_config_get_type(item) == T3_CONFIG_SECTION) {
+      collect_sections(list, item);
+    }
+  }
+}
+
+/** Time looking up random values in random sections of @p config.
+    @return The average time per lookup in nanoseconds.
+*/
+static double time_lookups(const t3_config_t *config) {
+  section_list_t list = {NULL, 0, 0};
+  char (*names)[16];
+  size_t found = 0;
+  double start, result;
+  int i;
+
+  if (option_width == 0) {
+    return 0.0;
+  }
+  collect_sections(&list, config);
+  if ((names = malloc(option_width * sizeof(*names))) == NULL) {
+    fatal("Out of memory\n");
+  }
+  for (i = 0; i < option_width; i++) {
+    snprintf(names[i], sizeof(names[i]), "k%d", i);
+  }
+
+  random_state = (uint64_t)option_seed * 2 + 1;
+  start = now();
+  for (i = 0; i < option_lookups; i++) {
+    uint32_t value = next_random();
+    if (t3_config_get(list.sections[value % list.count], names[(value >> 16) % option_width]) !=
+        NULL) {
+      found++;
+    }
+  }
+  result = (now() - start) * 1e9 / option_lookups;
+  /* Every section contains all values, which prevents the compiler from removing the lookups. */
+  if (found != (size_t)option_lookups) {
+    fatal("Lookup benchmark failed\n");
+  }
+  free(names);
+  free(list.sections);
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  buffer_t config_text = {NULL, 0, 0}, schema_text = {NULL, 0, 0};
+  const char *include_path[2] = {include_dir, NULL};
+  t3_config_t *config = NULL, *frozen;
+  t3_config_schema_t *schema;
+  t3_config_error_t error;
+  t3_config_opts_t opts;
+  t3_config_stats_t stats;
+  t3_config_memory_t usage;
+  size_t input_bytes, write_bytes = 0, base_bytes, peak_parse_bytes = 0;
+  double start, parse_time = 0.0, validate_time, schema_time, write_time, lookup_time,
+                frozen_lookup_time;
+  FILE *output;
+  int i;
+
+  parse_args(argc, argv);
+
+  /* The allocator must be set before anything is allocated by the library. */
+  t3_config_set_allocator(&bench_allocator);
+
+  random_state = (uint64_t)option_seed * 2 + 1;
+  generate_section(&config_text, 0, 0);
+  input_bytes = config_text.length + generate_includes(&config_text);
+  generate_schema(&schema_text);
+
+  opts.flags = T3_CONFIG_VERBOSE_ERROR | T3_CONFIG_INCLUDE_DFLT | T3_CONFIG_STATS;
+  opts.include_callback.dflt.path = include_path;
+  opts.include_callback.dflt.flags = 0;
+  opts.stats = &stats;
+
+  for (i = 0; i < option_iterations; i++) {
+    t3_config_delete(config);
+    base_bytes = bytes_in_use;
+    peak_bytes_in_use = bytes_in_use;
+    start = now();
+    if ((config = t3_config_read_buffer(config_text.data, config_text.length, &error, &opts)) ==
+        NULL) {
+      read_failed("config", &error);
+    }
+    parse_time += now() - start;
+    peak_parse_bytes = peak_bytes_in_use - base_bytes;
+  }
+  parse_time /= option_iterations;
+
+  start = now();
+  if ((schema = t3_config_read_schema_buffer(schema_text.data, schema_text.length, &error,
+                                             NULL)) == NULL) {
+    read_failed("schema", &error);
+  }
+  schema_time = now() - start;
+
+  start = now();
+  for (i = 0; i < option_iterations; i++) {
+    if (!t3_config_validate(config, schema, &error, T3_CONFIG_VERBOSE_ERROR)) {
+      read_failed("validation", &error);
+    }
+  }
+  validate_time = (now() - start) / option_iterations;
+
+  lookup_time = time_lookups(config);
+  if ((frozen = t3_config_freeze(config, &error.error)) == NULL) {
+    fatal("Could not freeze config: %s\n", t3_config_strerror(error.error));
+  }
+  frozen_lookup_time = time_lookups(frozen);
+
+  if ((output = tmpfile()) == NULL) {
+    fatal("Could not create temporary file\n");
+  }
+  start = now();
+  for (i = 0; i < option_iterations; i++) {
+    rewind(output);
+    if (t3_config_write_file(config, output) != T3_ERR_SUCCESS) {
+      fatal("Could not write config\n");
+    }
+    fflush(output);
+    write_bytes = (size_t)ftell(output);
+  }
+  write_time = (now() - start) / option_iterations;
+  fclose(output);
+
+  if (t3_config_memory_usage(config, &usage) != T3_ERR_SUCCESS) {
+    fatal("Could not determine memory usage\n");
+  }
+
+  printf("{\n");
+  printf("  \"width\": %d,\n  \"children\": %d,\n  \"depth\": %d,\n", option_width,
+         option_children, option_depth);
+  printf("  \"list_length\": %d,\n  \"strings\": %d,\n  \"includes\": %d,\n", option_list_length,
+         option_strings, option_includes);
+  printf("  \"seed\": %d,\n  \"iterations\": %d,\n", option_seed, option_iterations);
+  printf("  \"input_bytes\": %lu,\n  \"items\": %lu,\n", (unsigned long)input_bytes,
+         (unsigned long)stats.items);
+  printf("  \"parse_seconds\": %.9f,\n", parse_time);
+  printf("  \"parse_mb_per_second\": %.3f,\n", input_bytes / parse_time / 1e6);
+  printf("  \"parse_items_per_second\": %.0f,\n", stats.items / parse_time);
+  printf("  \"parse_peak_bytes\": %lu,\n", (unsigned long)peak_parse_bytes);
+  printf("  \"config_bytes\": %lu,\n", (unsigned long)usage.total_bytes);
+  printf("  \"lookup_nanoseconds\": %.2f,\n", lookup_time);
+  printf("  \"frozen_lookup_nanoseconds\": %.2f,\n", frozen_lookup_time);
+  printf("  \"schema_load_seconds\": %.9f,\n", schema_time);
+  printf("  \"validate_seconds\": %.9f,\n", validate_time);
+  printf("  \"write_bytes\": %lu,\n", (unsigned long)write_bytes);
+  printf("  \"write_mb_per_second\": %.3f\n", write_bytes / write_time / 1e6);
+  printf("}\n");
+
+  t3_config_delete(frozen);
+  t3_config_delete(config);
+  t3_config_delete_schema(schema);
+  remove_includes();
+  free(config_text.data);
+  free(schema_text.data);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,27 @@
+#!/bin/bash
+# Run the benchmark with a few standard parameter sets. Any arguments are passed
+# to each run, for example to change the number of iterations.
+
+make -q || make
+
+run() {
+	LD_LIBRARY_PATH=../src/.libs ./bench "$@"
+}
+
+echo "["
+echo "{ \"name\": \"small\", \"result\":"
+run -w5 -c2 -d3 -l3 "$@"
+echo "},"
+echo "{ \"name\": \"wide\", \"result\":"
+run -w200 -c1 -d2 -l10 "$@"
+echo "},"
+echo "{ \"name\": \"deep\", \"result\":"
+run -w8 -c2 -d10 -l2 "$@"
+echo "},"
+echo "{ \"name\": \"strings\", \"result\":"
+run -w20 -c3 -d4 -s100 "$@"
+echo "},"
+echo "{ \"name\": \"includes\", \"result\":"
+run -w10 -c2 -d4 -I32 "$@"
+echo "}"
+echo "]"
@@ -0,0 +1,743 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <ctype.h>
+#include <errno.h>
+#include <locale.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <t3config/config.h>
+
+#ifdef USE_GETTEXT
+#include <libintl.h>
+#define _(x) gettext(x)
+#else
+#define _(x) (x)
+#endif
+
+/* This header must be included after all the others to prevent issues with the
+   definition of _. */
+/* clang-format off */
+#include "optionMacros.h"
+/* clang-format on */
+
+const char *option_schema;
+const char *option_prefix;
+const char *option_output;
+
+/* The C representation of a value described by the schema. */
+typedef enum {
+  KIND_BOOL,
+  KIND_INT,
+  KIND_NUMBER,
+  KIND_STRING,
+  /* A section with allowed-keys or item-type, stored as a struct. */
+  KIND_STRUCT,
+  /* A list with item-type, stored as an array. */
+  KIND_LIST,
+  /* Anything else, stored as a pointer to the (sub-)config. */
+  KIND_CONFIG
+} kind_t;
+
+typedef struct struct_t struct_t;
+
+typedef struct value_t {
+  kind_t kind;
+  /* For KIND_CONFIG: the required type, or T3_CONFIG_NONE if any type is allowed. */
+  t3_config_type_t type;
+  struct_t *structure;
+  struct value_t *item;
+} value_t;
+
+typedef struct {
+  const char *key;
+  char *ident;
+  value_t *value;
+} field_t;
+
+struct struct_t {
+  char *name;
+  /* The part of the schema describing the section. */
+  const t3_config_t *schema;
+  field_t *fields;
+  size_t field_count;
+  /* The type of the items not in allowed-keys, or NULL if there is no item-type. */
+  value_t *entries;
+  /* 0 if not emitted yet, 1 while being emitted, 2 when done. */
+  int state;
+  struct_t *next;
+};
+
+static const t3_config_t *types;
+static struct_t *structs, **structs_tail = &structs;
+
+#ifdef __GNUC__
+void fatal(const char *fmt, ...) __attribute__((noreturn));
+#endif
+void fatal(const char *fmt, ...) {
+  va_list args;
+
+  va_start(args, fmt);
+  vfprintf(stderr, fmt, args);
+  va_end(args);
+  exit(EXIT_FAILURE);
+}
+
+static void *safe_calloc(size_t count, size_t size) {
+  void *result;
+
+  if ((result = calloc(count, size)) == NULL) {
+    fatal(_("Out of memory\n"));
+  }
+  return result;
+}
+
+/** Allocate a string containing the formatted text. */
+static char *format(const char *fmt, ...) {
+  va_list args;
+  char *result;
+  int length;
+
+  va_start(args, fmt);
+  length = vsnprintf(NULL, 0, fmt, args);
+  va_end(args);
+  if (length < 0 || (result = malloc(length + 1)) == NULL) {
+    fatal(_("Out of memory\n"));
+  }
+  va_start(args, fmt);
+  vsnprintf(result, length + 1, fmt, args);
+  va_end(args);
+  return result;
+}
+
+/** Convert a key or type name into a C identifier. */
+static char *make_ident(const char *name) {
+  /* The keywords of C (up to C23) and C++ (up to C++20), including the alternative tokens of
+     C++, such that the generated header can be used from both. */
+  static const char *keywords[] = {
+      "_Alignas", "alignas", "_Alignof", "alignof", "and", "and_eq", "asm", "_Atomic", "auto",
+      "bitand", "_BitInt", "bitor", "_Bool", "bool", "break", "case", "catch", "char", "char16_t",
+      "char32_t", "char8_t", "class", "co_await", "co_return", "co_yield", "compl", "_Complex",
+      "concept", "const", "const_cast", "consteval", "constexpr", "constinit", "continue",
+      "_Decimal128", "_Decimal32", "_Decimal64", "decltype", "default", "delete", "do", "double",
+      "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float", "for",
+      "friend", "_Generic", "goto", "if", "_Imaginary", "inline", "int", "long", "mutable",
+      "namespace", "new", "noexcept", "_Noreturn", "not", "not_eq", "nullptr", "operator", "or",
+      "or_eq", "private", "protected", "public", "register", "reinterpret_cast", "requires",
+      "restrict", "return", "short", "signed", "sizeof", "static", "_Static_assert",
+      "static_assert", "static_cast", "struct", "switch", "template", "this", "_Thread_local",
+      "thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "typeof",
+      "typeof_unqual", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t",
+      "while", "xor", "xor_eq"};
+  char *result = format("%s%s_", isdigit((unsigned char)name[0]) ? "_" : "", name), *ptr;
+  size_t i;
+
+  for (ptr = result; *ptr != 0; ptr++) {
+    if (!isalnum((unsigned char)*ptr)) {
+      *ptr = '_';
+    }
+  }
+  /* The trailing underscore is only kept for keywords. */
+  ptr[-1] = 0;
+  for (i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+    if (strcmp(result, keywords[i]) == 0) {
+      ptr[-1] = '_';
+      break;
+    }
+  }
+  return result;
+}
+
+static value_t *make_value(const char *type_name, const t3_config_t *schema, const char *path);
+static char *declaration(const value_t *value, const char *name, int indent);
+
+/** Get the name for a section or list item nested in the one named @p path. */
+static char *join_path(const char *path, const char *name) {
+  return path[0] == 0 ? format("%s", name) : format("%s_%s", path, name);
+}
+
+/** Retrieve the struct for the section described by @p schema, creating it if necessary. */
+static struct_t *get_struct(const t3_config_t *schema, const char *name) {
+  const t3_config_t *allowed_keys, *key, *item_type;
+  struct_t *result, *other;
+  size_t i, j;
+
+  for (result = structs; result != NULL; result = result->next) {
+    if (result->schema == schema) {
+      return result;
+    }
+  }
+
+  result = safe_calloc(1, sizeof(struct_t));
+  result->name = format("%s_%s", option_prefix, name);
+  for (other = structs; other != NULL; other = other->next) {
+    if (strcmp(other->name, result->name) == 0) {
+      fatal(_("%s: more than one struct would be named %s\n"), option_schema, result->name);
+    }
+  }
+  result->schema = schema;
+  *structs_tail = result;
+  structs_tail = &result->next;
+
+  allowed_keys = t3_config_get(schema, "allowed-keys");
+  result->field_count = (size_t)t3_config_get_length(allowed_keys);
+  result->fields = safe_calloc(result->field_count + 1, sizeof(field_t));
+  for (key = t3_config_get(allowed_keys, NULL), i = 0; key != NULL;
+       key = t3_config_get_next(key), i++) {
+    result->fields[i].key = t3_config_get_name(key);
+    result->fields[i].ident = make_ident(t3_config_get_name(key));
+    if (strcmp(result->fields[i].ident, "entries") == 0 ||
+        strncmp(result->fields[i].ident, "has_", 4) == 0) {
+      fatal(_("%s: key %s can not be used as a C identifier\n"), option_schema,
+            result->fields[i].key);
+    }
+    for (j = 0; j < i; j++) {
+      if (strcmp(result->fields[i].ident, result->fields[j].ident) == 0) {
+        fatal(_("%s: keys %s and %s map to the same C identifier\n"), option_schema,
+              result->fields[j].key, result->fields[i].key);
+      }
+    }
+    result->fields[i].value = make_value(t3_config_get_string(t3_config_get(key, "type")), key,
+                                         join_path(name, result->fields[i].ident));
+  }
+  if ((item_type = t3_config_get(schema, "item-type")) != NULL) {
+    result->entries = make_value(t3_config_get_string(item_type), NULL, join_path(name, "item"));
+  }
+  return result;
+}
+
+/** Determine the C representation of the value of type @p type_name.
+    @param schema The part of the schema describing the value, if @p type_name is a basic type.
+    @param path The name used for the struct, if the value is a section defined in place.
+*/
+static value_t *make_value(const char *type_name, const t3_config_t *schema, const char *path) {
+  value_t *result = safe_calloc(1, sizeof(value_t));
+  const t3_config_t *type_schema;
+
+  /* Follow the chain of type definitions down to a basic type, like the validator does. */
+  while ((type_schema = t3_config_get(types, type_name)) != NULL) {
+    schema = type_schema;
+    path = make_ident(type_name);
+    type_name = t3_config_get_string(t3_config_get(type_schema, "type"));
+  }
+
+  if (strcmp(type_name, "bool") == 0) {
+    result->kind = KIND_BOOL;
+  } else if (strcmp(type_name, "int") == 0) {
+    result->kind = KIND_INT;
+  } else if (strcmp(type_name, "number") == 0) {
+    result->kind = KIND_NUMBER;
+  } else if (strcmp(type_name, "string") == 0) {
+    result->kind = KIND_STRING;
+  } else if (strcmp(type_name, "section") == 0) {
+    if (schema != NULL &&
+        (t3_config_get(schema, "allowed-keys") != NULL ||
+         t3_config_get(schema, "item-type") != NULL)) {
+      result->kind = KIND_STRUCT;
+      result->structure = get_struct(schema, path);
+    } else {
+      result->kind = KIND_CONFIG;
+      result->type = T3_CONFIG_SECTION;
+    }
+  } else if (strcmp(type_name, "list") == 0) {
+    if (schema != NULL && t3_config_get(schema, "item-type") != NULL) {
+      result->kind = KIND_LIST;
+      result->item = make_value(t3_config_get_string(t3_config_get(schema, "item-type")), NULL,
+                                join_path(path, "item"));
+    } else {
+      result->kind = KIND_CONFIG;
+      result->type = T3_CONFIG_LIST;
+    }
+  } else {
+    result->kind = KIND_CONFIG;
+    result->type = T3_CONFIG_NONE;
+  }
+  return result;
+}
+
+/** Get the C type used to store @p value, for a declaration indented by @p indent levels. */
+static char *c_type(const value_t *value, int indent) {
+  switch (value->kind) {
+    case KIND_BOOL:
+      return format("t3_bool");
+    case KIND_INT:
+      return format("int64_t");
+    case KIND_NUMBER:
+      return format("double");
+    case KIND_STRING:
+      return format("const char *");
+    case KIND_STRUCT:
+      return format("%s_t", value->structure->name);
+    case KIND_LIST:
+      return format("struct {\n%*ssize_t count;\n%*s%s\n%*s}", indent * 2 + 2, "",
+                    indent * 2 + 2, "", declaration(value->item, "*items", indent + 1),
+                    indent * 2, "");
+    default:
+      return format("const t3_config_t *");
+  }
+}
+
+/** Get the declaration of @p name, which stores @p value. */
+static char *declaration(const value_t *value, const char *name, int indent) {
+  char *type = c_type(value, indent);
+  return format("%s%s%s;", type, type[strlen(type) - 1] == '*' ? "" : " ", name);
+}
+
+/** Check whether the storage of @p value has a flag indicating whether it was present. */
+static int has_flag(const value_t *value) {
+  return value->kind != KIND_STRING && value->kind != KIND_CONFIG;
+}
+
+static void emit_struct(FILE *file, struct_t *structure);
+
+/** Emit the definitions of the structs that @p value stores by value. */
+static void emit_dependencies(FILE *file, const value_t *value) {
+  /* Arrays only store pointers, for which a declaration suffices. */
+  if (value->kind == KIND_STRUCT) {
+    emit_struct(file, value->structure);
+  }
+}
+
+static void emit_struct(FILE *file, struct_t *structure) {
+  size_t i;
+
+  if (structure->state == 2) {
+    return;
+  } else if (structure->state == 1) {
+    fatal(_("%s: %s contains itself\n"), option_schema, structure->name);
+  }
+  structure->state = 1;
+  for (i = 0; i < structure->field_count; i++) {
+    emit_dependencies(file, structure->fields[i].value);
+  }
+  if (structure->entries != NULL) {
+    emit_dependencies(file, structure->entries);
+  }
+
+  fprintf(file, "struct %s_t {\n", structure->name);
+  for (i = 0; i < structure->field_count; i++) {
+    if (has_flag(structure->fields[i].value)) {
+      fprintf(file, "  t3_bool has_%s;\n", structure->fields[i].ident);
+    }
+    fprintf(file, "  %s\n", declaration(structure->fields[i].value, structure->fields[i].ident, 1));
+  }
+  if (structure->entries != NULL) {
+    fprintf(file,
+            "  /* The items not listed in allowed-keys. */\n"
+            "  struct {\n    size_t count;\n    struct {\n      const char *name;\n      %s\n"
+            "    } *items;\n  } entries;\n",
+            declaration(structure->entries, "value", 3));
+  }
+  if (structure->field_count == 0 && structure->entries == NULL) {
+    fprintf(file, "  char unused;\n");
+  }
+  fprintf(file, "};\n\n");
+  structure->state = 2;
+}
+
+/* Text of a function body under construction, and the nesting depth of the loops in it. */
+typedef struct {
+  char *text;
+  size_t length;
+  int max_depth;
+} body_t;
+
+static void append(body_t *body, int indent, const char *fmt, ...) {
+  va_list args;
+  char *line;
+  int length;
+
+  va_start(args, fmt);
+  length = vsnprintf(NULL, 0, fmt, args);
+  va_end(args);
+  if (length < 0 || (body->text = realloc(body->text, body->length + indent * 2 + length + 1)) ==
+                        NULL) {
+    fatal(_("Out of memory\n"));
+  }
+  line = body->text + body->length;
+  memset(line, ' ', indent * 2);
+  va_start(args, fmt);
+  vsnprintf(line + indent * 2, length + 1, fmt, args);
+  va_end(args);
+  body->length += indent * 2 + length;
+}
+
+/** Emit the code to fill @p target from the (sub-)config @p source. */
+static void emit_load(body_t *body, int indent, const value_t *value, const char *target,
+                      const char *source, int depth) {
+  static const char *checks[] = {"t3_config_get_type(%s) != T3_CONFIG_BOOL",
+                                 "t3_config_get_type(%s) != T3_CONFIG_INT",
+                                 "t3_config_get_type(%s) != T3_CONFIG_NUMBER",
+                                 "t3_config_get_type(%s) != T3_CONFIG_STRING"};
+  static const char *getters[] = {"t3_config_get_bool", "t3_config_get_int64",
+                                  "t3_config_get_number", "t3_config_get_string"};
+
+  switch (value->kind) {
+    case KIND_BOOL:
+    case KIND_INT:
+    case KIND_NUMBER:
+    case KIND_STRING:
+      append(body, indent, "if (");
+      append(body, 0, checks[value->kind], source);
+      append(body, 0, ") {\n");
+      append(body, indent + 1, "return T3_ERR_INVALID_KEY_TYPE;\n");
+      append(body, indent, "}\n");
+      append(body, indent, "%s = %s(%s);\n", target, getters[value->kind], source);
+      break;
+    case KIND_STRUCT:
+      append(body, indent, "if ((error = load_%s(&%s, %s)) != T3_ERR_SUCCESS) {\n",
+             value->structure->name, target, source);
+      append(body, indent + 1, "return error;\n");
+      append(body, indent, "}\n");
+      break;
+    case KIND_LIST:
+      if (depth + 1 > body->max_depth) {
+        body->max_depth = depth + 1;
+      }
+      append(body, indent, "if (!t3_config_is_list(%s)) {\n", source);
+      append(body, indent + 1, "return T3_ERR_INVALID_KEY_TYPE;\n");
+      append(body, indent, "}\n");
+      append(body, indent, "%s.count = (size_t)t3_config_get_length(%s);\n", target, source);
+      append(body, indent, "if (%s.count > 0 &&\n", target);
+      append(body, indent + 2, "(%s.items = calloc(%s.count, sizeof(*%s.items))) == NULL) {\n",
+             target, target, target);
+      append(body, indent + 1, "%s.count = 0;\n", target);
+      append(body, indent + 1, "return T3_ERR_OUT_OF_MEMORY;\n");
+      append(body, indent, "}\n");
+      append(body, indent,
+             "for (item%d = t3_config_get(%s, NULL), i%d = 0; item%d != NULL;\n", depth + 1,
+             source, depth + 1, depth + 1);
+      append(body, indent + 2, "item%d = t3_config_get_next(item%d), i%d++) {\n", depth + 1,
+             depth + 1, depth + 1);
+      emit_load(body, indent + 1, value->item, format("%s.items[i%d]", target, depth + 1),
+                format("item%d", depth + 1), depth + 1);
+      append(body, indent, "}\n");
+      break;
+    default:
+      if (value->type == T3_CONFIG_SECTION) {
+        append(body, indent, "if (t3_config_get_type(%s) != T3_CONFIG_SECTION) {\n", source);
+        append(body, indent + 1, "return T3_ERR_INVALID_KEY_TYPE;\n");
+        append(body, indent, "}\n");
+      } else if (value->type == T3_CONFIG_LIST) {
+        append(body, indent, "if (!t3_config_is_list(%s)) {\n", source);
+        append(body, indent + 1, "return T3_ERR_INVALID_KEY_TYPE;\n");
+        append(body, indent, "}\n");
+      }
+      append(body, indent, "%s = %s;\n", target, source);
+      break;
+  }
+}
+
+/** Emit the code to release the memory allocated for @p target. */
+static void emit_free(body_t *body, int indent, const value_t *value, const char *target,
+                      int depth) {
+  if (value->kind == KIND_STRUCT) {
+    append(body, indent, "free_%s(&%s);\n", value->structure->name, target);
+  } else if (value->kind == KIND_LIST) {
+    if (value->item->kind == KIND_STRUCT || value->item->kind == KIND_LIST) {
+      if (depth + 1 > body->max_depth) {
+        body->max_depth = depth + 1;
+      }
+      append(body, indent, "for (i%d = 0; i%d < %s.count; i%d++) {\n", depth + 1, depth + 1,
+             target, depth + 1);
+      emit_free(body, indent + 1, value->item, format("%s.items[i%d]", target, depth + 1),
+                depth + 1);
+      append(body, indent, "}\n");
+    }
+    append(body, indent, "free(%s.items);\n", target);
+  }
+}
+
+static void emit_loader(FILE *file, const struct_t *structure) {
+  body_t body = {NULL, 0, 0};
+  size_t i;
+  int depth;
+
+  for (i = 0; i < structure->field_count; i++) {
+    append(&body, 2, "%sif (strcmp(name, \"%s\") == 0) {\n", i == 0 ? "" : "} else ",
+           structure->fields[i].key);
+    if (has_flag(structure->fields[i].value)) {
+      append(&body, 3, "result->has_%s = t3_true;\n", structure->fields[i].ident);
+    }
+    emit_load(&body, 3, structure->fields[i].value,
+              format("result->%s", structure->fields[i].ident), "item0", 0);
+  }
+  if (structure->entries != NULL) {
+    if (structure->field_count > 0) {
+      append(&body, 2, "} else {\n");
+    }
+    append(&body, structure->field_count > 0 ? 3 : 2,
+           "result->entries.items[result->entries.count++].name = name;\n");
+    emit_load(&body, structure->field_count > 0 ? 3 : 2, structure->entries,
+              "result->entries.items[result->entries.count - 1].value", "item0", 0);
+  } else if (structure->field_count > 0) {
+    append(&body, 2, "} else {\n");
+    append(&body, 3, "return T3_ERR_INVALID_KEY;\n");
+  } else {
+    /* Without allowed-keys and item-type, the schema allows any key. */
+    append(&body, 2, "(void)name;\n");
+  }
+  if (structure->field_count > 0) {
+    append(&body, 2, "}\n");
+  }
+
+  fprintf(file, "static int load_%s(%s_t *result, const t3_config_t *config) {\n",
+          structure->name, structure->name);
+  fprintf(file, "  const t3_config_t *item0");
+  for (depth = 1; depth <= body.max_depth; depth++) {
+    fprintf(file, ", *item%d", depth);
+  }
+  fprintf(file, ";\n");
+  for (depth = 1; depth <= body.max_depth; depth++) {
+    fprintf(file, "%s i%d", depth == 1 ? "  size_t" : ",", depth);
+  }
+  fprintf(file, "%s  const char *name;\n  int error = T3_ERR_SUCCESS;\n\n",
+          body.max_depth > 0 ? ";\n" : "");
+  fprintf(file,
+          "  (void)error;\n"
+          "  if (t3_config_get_type(config) != T3_CONFIG_SECTION) {\n"
+          "    return T3_ERR_INVALID_KEY_TYPE;\n"
+          "  }\n");
+  if (structure->entries != NULL) {
+    /* The number of entries is not known in advance, so room is made for all items. */
+    fprintf(file,
+            "  if (t3_config_get_length(config) > 0 &&\n"
+            "      (result->entries.items =\n"
+            "           calloc(t3_config_get_length(config), sizeof(*result->entries.items))) =="
+            " NULL) {\n"
+            "    return T3_ERR_OUT_OF_MEMORY;\n"
+            "  }\n");
+  }
+  fprintf(file,
+          "  for (item0 = t3_config_get(config, NULL); item0 != NULL;"
+          " item0 = t3_config_get_next(item0)) {\n"
+          "    name = t3_config_get_name(item0);\n"
+          "%s  }\n"
+          "  return T3_ERR_SUCCESS;\n"
+          "}\n\n",
+          body.text == NULL ? "" : body.text);
+  free(body.text);
+}
+
+static void emit_free_function(FILE *file, const struct_t *structure) {
+  body_t body = {NULL, 0, 0};
+  size_t i;
+  int depth;
+
+  for (i = 0; i < structure->field_count; i++) {
+    emit_free(&body, 1, structure->fields[i].value,
+              format("value->%s", structure->fields[i].ident), 0);
+  }
+  if (structure->entries != NULL) {
+    if (structure->entries->kind == KIND_STRUCT || structure->entries->kind == KIND_LIST) {
+      body.max_depth = body.max_depth < 1 ? 1 : body.max_depth;
+      append(&body, 1, "for (i1 = 0; i1 < value->entries.count; i1++) {\n");
+      emit_free(&body, 2, structure->entries, "value->entries.items[i1].value", 1);
+      append(&body, 1, "}\n");
+    }
+    append(&body, 1, "free(value->entries.items);\n");
+  }
+
+  fprintf(file, "static void free_%s(%s_t *value) {\n", structure->name, structure->name);
+  for (depth = 1; depth <= body.max_depth; depth++) {
+    fprintf(file, "%s i%d", depth == 1 ? "  size_t" : ",", depth);
+  }
+  fprintf(file, "%s%s%s}\n\n", body.max_depth > 0 ? ";\n\n" : "",
+          body.text == NULL ? "  (void)value;\n" : "", body.text == NULL ? "" : body.text);
+  free(body.text);
+}
+
+/** Write the header declaring the structs and the functions to fill them. */
+static void write_header(FILE *file, const char *guard, struct_t *root) {
+  struct_t *structure;
+
+  fprintf(file,
+          "/* Generated by t3config-codegen from %s. Do not edit. */\n"
+          "#ifndef %s\n#define %s\n\n"
+          "#include <stddef.h>\n#include <stdint.h>\n#include <t3config/config.h>\n\n"
+          "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n",
+          option_schema, guard, guard);
+  for (structure = structs; structure != NULL; structure = structure->next) {
+    fprintf(file, "typedef struct %s_t %s_t;\n", structure->name, structure->name);
+  }
+  fprintf(file, "\n");
+  for (structure = structs; structure != NULL; structure = structure->next) {
+    emit_struct(file, structure);
+  }
+  fprintf(file,
+          "/* Fill @p result from @p config, which should have been validated against the\n"
+          "   schema. String values and sub-configs stored as pointers refer to @p config, which\n"
+          "   must therefore remain valid while @p result is used. Returns T3_ERR_SUCCESS, or\n"
+          "   the error that was found, in which case @p result has been released already. */\n"
+          "int %s_load(%s_t *result, const t3_config_t *config);\n"
+          "/* Release the memory allocated by %s_load. */\n"
+          "void %s_free(%s_t *value);\n\n"
+          "#ifdef __cplusplus\n} /* extern \"C\" */\n#endif\n#endif\n",
+          option_prefix, root->name, option_prefix, option_prefix, root->name);
+}
+
+/** Write the source defining the functions to fill the structs. */
+static void write_source(FILE *file, const char *header_name, struct_t *root) {
+  struct_t *structure;
+
+  fprintf(file,
+          "/* Generated by t3config-codegen from %s. Do not edit. */\n"
+          "#include <stdlib.h>\n#include <string.h>\n\n#include \"%s\"\n\n",
+          option_schema, header_name);
+  for (structure = structs; structure != NULL; structure = structure->next) {
+    fprintf(file, "static int load_%s(%s_t *result, const t3_config_t *config);\n",
+            structure->name, structure->name);
+    fprintf(file, "static void free_%s(%s_t *value);\n", structure->name, structure->name);
+  }
+  fprintf(file, "\n");
+  for (structure = structs; structure != NULL; structure = structure->next) {
+    emit_loader(file, structure);
+    emit_free_function(file, structure);
+  }
+  fprintf(file,
+          "int %s_load(%s_t *result, const t3_config_t *config) {\n"
+          "  int error;\n\n"
+          "  memset(result, 0, sizeof(*result));\n"
+          "  if ((error = load_%s(result, config)) != T3_ERR_SUCCESS) {\n"
+          "    free_%s(result);\n"
+          "    memset(result, 0, sizeof(*result));\n"
+          "  }\n"
+          "  return error;\n"
+          "}\n\n"
+          "void %s_free(%s_t *value) { free_%s(value); }\n",
+          option_prefix, root->name, root->name, root->name, option_prefix, root->name,
+          root->name);
+}
+
+/* clang-format off */
+static PARSE_FUNCTION(parse_args)
+  OPTIONS
+    OPTION('p', "prefix", REQUIRED_ARG)
+      option_prefix = optArg;
+    END_OPTION
+    OPTION('o', "output", REQUIRED_ARG)
+      option_output = optArg;
+    END_OPTION
+    OPTION('h', "help", NO_ARG)
+      printf("Usage: t3config_codegen [<options>] <schema>\n"
+        "  -o<name>,--output=<name>        Write <name>.h and <name>.c\n"
+        "  -p<prefix>,--prefix=<prefix>    Start all generated names with <prefix>\n"
+      );
+      exit(EXIT_SUCCESS);
+    END_OPTION
+    DOUBLE_DASH
+      NO_MORE_OPTIONS;
+    END_OPTION
+
+    fatal(_("No such option %.*s\n"), OPTPRARG);
+  NO_OPTION
+    if (option_schema != NULL) {
+      fatal(_("Only one schema allowed\n"));
+    }
+    option_schema = optcurrent;
+  END_OPTIONS
+
+  if (option_schema == NULL) {
+    fatal(_("No schema selected\n"));
+  }
+  if (option_output == NULL) {
+    fatal(_("No output name selected\n"));
+  }
+END_FUNCTION
+/* clang-format on */
+
+static void print_error(const char *fmt, t3_config_error_t *error) {
+  fprintf(stderr, fmt, error->file_name != NULL ? error->file_name : option_schema,
+          error->line_number, t3_config_strerror(error->error), error->extra ? error->extra : "");
+  free(error->extra);
+  free(error->file_name);
+}
+
+/** Read the schema as a config, after checking that it is a valid schema. */
+static t3_config_t *read_schema(void) {
+  t3_config_schema_t *schema;
+  t3_config_t *config;
+  t3_config_error_t error;
+  t3_config_opts_t opts;
+  FILE *file;
+
+  if ((file = fopen(option_schema, "r")) == NULL) {
+    fatal(_("%s: Could not open schema: %s\n"), option_schema, strerror(errno));
+  }
+  opts.flags = T3_CONFIG_VERBOSE_ERROR | T3_CONFIG_ERROR_FILE_NAME;
+  if ((schema = t3_config_read_schema_file(file, &error, &opts)) == NULL) {
+    print_error(_("%s:%d: Could not load schema: %s: %s\n"), &error);
+    exit(EXIT_FAILURE);
+  }
+  t3_config_delete_schema(schema);
+
+  /* The structure of the schema is not accessible through the schema API. */
+  rewind(file);
+  if ((config = t3_config_read_file(file, &error, &opts)) == NULL) {
+    print_error(_("%s:%d: Could not load schema: %s: %s\n"), &error);
+    exit(EXIT_FAILURE);
+  }
+  fclose(file);
+  return config;
+}
+
+int main(int argc, char *argv[]) {
+  t3_config_t *schema;
+  struct_t *root;
+  char *header_name, *source_name, *guard, *ptr;
+  const char *base_name;
+  FILE *file;
+
+#ifdef USE_GETTEXT
+  setlocale(LC_ALL, "");
+  bindtextdomain("t3highlight", LOCALEDIR);
+  textdomain("t3highlight");
+#endif
+
+  parse_args(argc, argv);
+  option_prefix = option_prefix == NULL ? "config" : make_ident(option_prefix);
+
+  schema = read_schema();
+  types = t3_config_get(schema, "types");
+  root = get_struct(schema, "");
+  /* The struct for the whole config is named after the prefix alone. */
+  root->name[strlen(option_prefix)] = 0;
+
+  header_name = format("%s.h", option_output);
+  source_name = format("%s.c", option_output);
+  base_name = (base_name = strrchr(header_name, '/')) == NULL ? header_name : base_name + 1;
+  guard = make_ident(base_name);
+  for (ptr = guard; *ptr != 0; ptr++) {
+    *ptr = (char)toupper((unsigned char)*ptr);
+  }
+
+  if ((file = fopen(header_name, "w")) == NULL) {
+    fatal(_("%s: Could not open output: %s\n"), header_name, strerror(errno));
+  }
+  write_header(file, guard, root);
+  if (fclose(file) != 0) {
+    fatal(_("%s: Could not write output: %s\n"), header_name, strerror(errno));
+  }
+  if ((file = fopen(source_name, "w")) == NULL) {
+    fatal(_("%s: Could not open output: %s\n"), source_name, strerror(errno));
+  }
+  write_source(file, base_name, root);
+  if (fclose(file) != 0) {
+    fatal(_("%s: Could not write output: %s\n"), source_name, strerror(errno));
+  }
+
+  t3_config_delete(schema);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,345 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <ctype.h>
+#include <errno.h>
+#include <locale.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <t3config/config.h>
+
+#ifdef USE_GETTEXT
+#include <libintl.h>
+#define _(x) gettext(x)
+#else
+#define _(x) (x)
+#endif
+
+/* This header must be included after all the others to prevent issues with the
+   definition of _. */
+/* clang-format off */
+#include "optionMacros.h"
+/* clang-format on */
+
+int option_verbose;
+int option_dump;
+const char *option_schema;
+const char *option_output;
+const char *option_input;
+const char *option_c_name;
+
+/* The directories to search for included files, terminated by NULL. */
+static const char **include_dirs;
+static size_t include_dir_count;
+
+#ifdef __GNUC__
+void fatal(const char *fmt, ...) __attribute__((noreturn));
+#endif
+void fatal(const char *fmt, ...) {
+  va_list args;
+
+  va_start(args, fmt);
+  vfprintf(stderr, fmt, args);
+  va_end(args);
+  exit(EXIT_FAILURE);
+}
+
+static void add_include_dir(const char *dir) {
+  if ((include_dirs = realloc(include_dirs, (include_dir_count + 2) * sizeof(char *))) == NULL) {
+    fatal(_("Out of memory\n"));
+  }
+  include_dirs[include_dir_count++] = dir;
+  include_dirs[include_dir_count] = NULL;
+}
+
+static int valid_identifier(const char *name) {
+  if (!isalpha((unsigned char)*name) && *name != '_') {
+    return 0;
+  }
+  for (name++; *name != 0; name++) {
+    if (!isalnum((unsigned char)*name) && *name != '_') {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* clang-format off */
+static PARSE_FUNCTION(parse_args)
+  OPTIONS
+    OPTION('v', "verbose", NO_ARG)
+      option_verbose = 1;
+    END_OPTION
+    OPTION('s', "schema", REQUIRED_ARG)
+      if (option_schema != NULL) {
+        fatal(_("Only one schema option allowed\n"));
+      }
+      option_schema = optArg;
+    END_OPTION
+    OPTION('I', "include", REQUIRED_ARG)
+      add_include_dir(optArg);
+    END_OPTION
+    OPTION('o', "output", REQUIRED_ARG)
+      option_output = optArg;
+    END_OPTION
+    OPTION('d', "dump", NO_ARG)
+      option_dump = 1;
+    END_OPTION
+    OPTION('c', "c-source", REQUIRED_ARG)
+      if (!valid_identifier(optArg)) {
+        fatal(_("Invalid C identifier %s\n"), optArg);
+      }
+      option_c_name = optArg;
+    END_OPTION
+    OPTION('h', "help", NO_ARG)
+      printf("Usage: t3config_compile [<options>] <config>\n"
+        "  -c<name>,--c-source=<name>      Write C source defining the function <name>\n"
+        "  -d,--dump                       Read an image and write it as text\n"
+        "  -I<dir>,--include=<dir>         Search <dir> for included files\n"
+        "  -o<file>,--output=<file>        Write the image to <file>\n"
+        "  -s<schema>,--schema=<schema>    Validate against the schema in <schema>\n"
+        "  -v,--verbose                    Enable verbose output mode\n"
+        "Included files are searched for in the directory of <config> if no include\n"
+        "directories are given. C source is written to standard output if no output\n"
+        "file is given.\n"
+      );
+      exit(EXIT_SUCCESS);
+    END_OPTION
+    DOUBLE_DASH
+      NO_MORE_OPTIONS;
+    END_OPTION
+
+    fatal(_("No such option %.*s\n"), OPTPRARG);
+  NO_OPTION
+    if (option_input != NULL) {
+      fatal(_("Only one config allowed\n"));
+    }
+    option_input = optcurrent;
+  END_OPTIONS
+
+  if (option_input == NULL) {
+    fatal(_("No config selected\n"));
+  }
+  if (option_dump && option_c_name != NULL) {
+    fatal(_("Options --dump and --c-source are mutually exclusive\n"));
+  }
+  if (!option_dump && option_c_name == NULL && option_output == NULL) {
+    fatal(_("No output file selected\n"));
+  }
+END_FUNCTION
+/* clang-format on */
+
+static void print_error(const char *fmt, const char *name, t3_config_error_t *error) {
+  fprintf(stderr, fmt, error->file_name != NULL ? error->file_name : name, error->line_number,
+          t3_config_strerror(error->error), error->extra ? error->extra : "");
+  free(error->extra);
+  free(error->file_name);
+}
+
+static t3_config_schema_t *read_schema(void) {
+  t3_config_schema_t *schema;
+  t3_config_error_t error;
+  t3_config_opts_t opts;
+  FILE *file;
+
+  if (option_schema == NULL) {
+    return NULL;
+  }
+  if ((file = fopen(option_schema, "r")) == NULL) {
+    fatal(_("%s: Could not open schema: %s\n"), option_schema, strerror(errno));
+  }
+  opts.flags = T3_CONFIG_VERBOSE_ERROR | T3_CONFIG_ERROR_FILE_NAME;
+  schema = t3_config_read_schema_file(file, &error, &opts);
+  fclose(file);
+  if (schema == NULL) {
+    print_error(_("%s:%d: Could not load schema: %s: %s\n"), option_schema, &error);
+    exit(EXIT_FAILURE);
+  }
+  return schema;
+}
+
+static t3_config_t *read_config(void) {
+  t3_config_t *config;
+  t3_config_error_t error;
+  t3_config_opts_t opts;
+  char *dir = NULL, *slash;
+  FILE *file;
+
+  if (include_dir_count == 0) {
+    if ((dir = malloc(strlen(option_input) + 1)) == NULL) {
+      fatal(_("Out of memory\n"));
+    }
+    strcpy(dir, option_input);
+    if ((slash = strrchr(dir, '/')) == NULL) {
+      strcpy(dir, ".");
+    } else {
+      slash[slash == dir ? 1 : 0] = 0;
+    }
+    add_include_dir(dir);
+  }
+
+  if ((file = fopen(option_input, "r")) == NULL) {
+    fatal(_("%s: Could not open config: %s\n"), option_input, strerror(errno));
+  }
+  opts.flags = T3_CONFIG_VERBOSE_ERROR | T3_CONFIG_ERROR_FILE_NAME | T3_CONFIG_INCLUDE_DFLT;
+  opts.include_callback.dflt.path = include_dirs;
+  opts.include_callback.dflt.flags = 0;
+  config = t3_config_read_file(file, &error, &opts);
+  fclose(file);
+  free(dir);
+  if (config == NULL) {
+    print_error(_("%s:%d: Could not load config: %s: %s\n"), option_input, &error);
+    exit(EXIT_FAILURE);
+  }
+  return config;
+}
+
+static t3_config_t *read_image(void) {
+  t3_config_t *config;
+  FILE *file;
+  int error;
+
+  if ((file = fopen(option_input, "rb")) == NULL) {
+    fatal(_("%s: Could not open image: %s\n"), option_input, strerror(errno));
+  }
+  config = t3_config_read_image(file, &error);
+  fclose(file);
+  if (config == NULL) {
+    fatal(_("%s: Could not load image: %s\n"), option_input,
+          error == T3_ERR_ERRNO ? strerror(errno) : t3_config_strerror(error));
+  }
+  return config;
+}
+
+static void write_image(t3_config_t *config) {
+  t3_config_write_file_t *output;
+  int error;
+
+  if ((output = t3_config_open_write(option_output)) == NULL) {
+    fatal(_("%s: Could not open output: %s\n"), option_output, strerror(errno));
+  }
+  if ((error = t3_config_write_image(config, t3_config_get_write_file(output))) !=
+      T3_ERR_SUCCESS) {
+    int saved_errno = errno;
+    t3_config_close_write(output, t3_true, t3_true);
+    fatal(_("%s: Could not write image: %s\n"), option_output,
+          error == T3_ERR_ERRNO ? strerror(saved_errno) : t3_config_strerror(error));
+  }
+  if (!t3_config_close_write(output, t3_false, t3_true)) {
+    fatal(_("%s: Could not write image: %s\n"), option_output, strerror(errno));
+  }
+}
+
+/** Write C source defining a function that returns @p config, without parsing it. */
+static void write_c_source(t3_config_t *config) {
+  FILE *image, *output = stdout;
+  long size, i;
+  int c, error;
+
+  /* The image is created in a temporary file, and written out as a byte array. */
+  if ((image = tmpfile()) == NULL) {
+    fatal(_("Could not create temporary file: %s\n"), strerror(errno));
+  }
+  if ((error = t3_config_write_image(config, image)) != T3_ERR_SUCCESS) {
+    fatal(_("Could not create image: %s\n"),
+          error == T3_ERR_ERRNO ? strerror(errno) : t3_config_strerror(error));
+  }
+  size = ftell(image);
+  rewind(image);
+
+  if (option_output != NULL && (output = fopen(option_output, "w")) == NULL) {
+    fatal(_("%s: Could not open output: %s\n"), option_output, strerror(errno));
+  }
+  fprintf(output, "/* Generated by t3config-compile from %s. Do not edit. */\n", option_input);
+  fprintf(output, "#include <stdint.h>\n#include <t3config/config.h>\n\n");
+  fprintf(output,
+          "/* The image is converted in place when it is first used, so it can not be const. */\n"
+          "static union {\n  unsigned char bytes[%ld];\n  uint64_t align;\n} %s_image = {{",
+          size, option_c_name);
+  for (i = 0; i < size && (c = getc(image)) != EOF; i++) {
+    fprintf(output, "%s0x%02x,", i % 12 == 0 ? "\n  " : " ", c);
+  }
+  if (i != size) {
+    fatal(_("Could not read temporary file: %s\n"), strerror(errno));
+  }
+  fprintf(output, "\n}};\n\n");
+  fprintf(output,
+          "/* Returns NULL if the image was created for a different version of libt3config. */\n"
+          "const t3_config_t *%s(void) {\n"
+          "  return t3_config_load_static(%s_image.bytes, sizeof(%s_image.bytes), NULL);\n"
+          "}\n",
+          option_c_name, option_c_name, option_c_name);
+  fclose(image);
+  if (fflush(output) != 0 || (output != stdout && fclose(output) != 0)) {
+    fatal(_("%s: Could not write C source: %s\n"),
+          option_output != NULL ? option_output : _("<stdout>"), strerror(errno));
+  }
+}
+
+static void write_text(t3_config_t *config) {
+  FILE *output = stdout;
+
+  if (option_output != NULL && (output = fopen(option_output, "w")) == NULL) {
+    fatal(_("%s: Could not open output: %s\n"), option_output, strerror(errno));
+  }
+  if (t3_config_write_file(config, output) != T3_ERR_SUCCESS || fflush(output) != 0 ||
+      (output != stdout && fclose(output) != 0)) {
+    fatal(_("%s: Could not write config: %s\n"),
+          option_output != NULL ? option_output : _("<stdout>"), strerror(errno));
+  }
+}
+
+int main(int argc, char *argv[]) {
+  t3_config_schema_t *schema;
+  t3_config_t *config;
+  t3_config_error_t error;
+
+#ifdef USE_GETTEXT
+  setlocale(LC_ALL, "");
+  bindtextdomain("t3highlight", LOCALEDIR);
+  textdomain("t3highlight");
+#endif
+
+  parse_args(argc, argv);
+
+  schema = read_schema();
+  config = option_dump ? read_image() : read_config();
+
+  if (schema != NULL &&
+      !t3_config_validate(config, schema, &error,
+                          T3_CONFIG_VERBOSE_ERROR | T3_CONFIG_ERROR_FILE_NAME)) {
+    print_error(_("%s:%d: Validation of the config failed: %s: %s\n"), option_input, &error);
+    exit(EXIT_FAILURE);
+  }
+
+  if (option_dump) {
+    write_text(config);
+  } else if (option_c_name != NULL) {
+    write_c_source(config);
+  } else {
+    write_image(config);
+    if (option_verbose) {
+      t3_config_memory_t usage;
+      if (t3_config_memory_usage(config, &usage) == T3_ERR_SUCCESS) {
+        printf(_("%s: %lu items compiled to %s\n"), option_input, (unsigned long)usage.items,
+               option_output);
+      }
+    }
+  }
+
+  t3_config_delete(config);
+  t3_config_delete_schema(schema);
+  return EXIT_SUCCESS;
+}
@@ -11,10 +11,15 @@
    You should have received a copy of the GNU General Public License
    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <errno.h>
+#include <glob.h>
 #include <locale.h>
+#include <pthread.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <t3config/config.h>
 
 /* FIXME: allow using a path to search for includes. */
@@ -33,8 +38,19 @@
 /* clang-format on */
 
 int option_verbose;
+int option_jobs = 1;
 const char *option_schema;
-const char *option_config;
+
+/* The result of checking a single config file. */
+typedef struct {
+  const char *name;
+  /* The error message, or NULL if the config is valid. */
+  char *message;
+  double seconds;
+} check_t;
+
+static check_t *checks;
+static size_t check_count, checks_allocated;
 
 #ifdef __GNUC__
 void fatal(const char *fmt, ...) __attribute__((noreturn));
@@ -48,6 +64,88 @@ void fatal(const char *fmt, ...) {
   exit(EXIT_FAILURE);
 }
 
+static char *safe_strdup(const char *str) {
+  char *result;
+
+  if ((result = malloc(strlen(str) + 1)) == NULL) {
+    fatal(_("Out of memory\n"));
+  }
+  strcpy(result, str);
+  return result;
+}
+
+/** Allocate a string containing the formatted message. */
+static char *format_message(const char *fmt, ...) {
+  va_list args;
+  char *result;
+  int length;
+
+  va_start(args, fmt);
+  length = vsnprintf(NULL, 0, fmt, args);
+  va_end(args);
+  if (length < 0 || (result = malloc(length + 1)) == NULL) {
+    fatal(_("Out of memory\n"));
+  }
+  va_start(args, fmt);
+  vsnprintf(result, length + 1, fmt, args);
+  va_end(args);
+  return result;
+}
+
+/** Add a config file to check. @p name must remain valid until the program exits. */
+static void add_config(const char *name) {
+  if (check_count == checks_allocated) {
+    checks_allocated = checks_allocated == 0 ? 16 : checks_allocated * 2;
+    if ((checks = realloc(checks, checks_allocated * sizeof(check_t))) == NULL) {
+      fatal(_("Out of memory\n"));
+    }
+  }
+  checks[check_count].name = name;
+  checks[check_count].message = NULL;
+  checks[check_count].seconds = 0.0;
+  check_count++;
+}
+
+/** Add the config files matching @p pattern, for shells that do not expand wildcards. */
+static void add_config_pattern(const char *pattern) {
+  glob_t matches;
+  size_t i;
+
+  if (strpbrk(pattern, "*?[") == NULL || glob(pattern, 0, NULL, &matches) != 0) {
+    /* Patterns without matches are checked as file names, which reports them as missing. */
+    add_config(pattern);
+    return;
+  }
+  for (i = 0; i < matches.gl_pathc; i++) {
+    add_config(safe_strdup(matches.gl_pathv[i]));
+  }
+  globfree(&matches);
+}
+
+/** Add the config files listed in @p name, one per line. A @p name of - means standard input. */
+static void add_config_list(const char *name) {
+  FILE *file = strcmp(name, "-") == 0 ? stdin : fopen(name, "r");
+  char *line = NULL;
+  size_t line_size = 0;
+  ssize_t length;
+
+  if (file == NULL) {
+    fatal(_("Could not open file list %s: %s\n"), name, strerror(errno));
+  }
+  while ((length = getline(&line, &line_size, file)) >= 0) {
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+      line[--length] = 0;
+    }
+    if (length > 0) {
+      add_config(safe_strdup(line));
+    }
+  }
+  free(line);
+  if (file != stdin) {
+    fclose(file);
+  }
+}
+
 /* clang-format off */
 static PARSE_FUNCTION(parse_args)
   OPTIONS
@@ -61,16 +159,23 @@ static PARSE_FUNCTION(parse_args)
       option_schema = optArg;
     END_OPTION
     OPTION('c', "config", REQUIRED_ARG)
-      if (option_config != NULL || option_config != NULL) {
-        fatal(_("Only one config option allowed\n"));
-      }
-      option_config = optArg;
+      add_config_pattern(optArg);
+    END_OPTION
+    OPTION('f', "file-list", REQUIRED_ARG)
+      add_config_list(optArg);
+    END_OPTION
+    OPTION('j', "jobs", REQUIRED_ARG)
+      PARSE_INT(option_jobs, 1, 1024);
     END_OPTION
     OPTION('h', "help", NO_ARG)
-      printf("Usage: t3config_test [<options>]\n"
+      printf("Usage: t3config_test [<options>] [<config>...]\n"
         "  -c<config>,--config=<config>    Load config from <config>\n"
+        "  -f<file>,--file-list=<file>     Load the configs listed in <file> (- for stdin)\n"
+        "  -j<jobs>,--jobs=<jobs>          Check <jobs> configs in parallel\n"
         "  -s<schema>,--schema=<schema>    Load schema from <schema>\n"
         "  -v,--verbose                    Enable verbose output mode\n"
+        "Config names may contain wildcards, which are expanded if the shell has not\n"
+        "done so already.\n"
       );
       exit(EXIT_SUCCESS);
     END_OPTION
@@ -80,21 +185,90 @@ static PARSE_FUNCTION(parse_args)
 
     fatal(_("No such option %.*s\n"), OPTPRARG);
   NO_OPTION
-    fatal(_("Invalid argument %s\n"), optArg);
+    add_config_pattern(optcurrent);
   END_OPTIONS
 
-  if (!option_schema && !option_config) {
+  if (!option_schema && check_count == 0) {
     fatal(_("Nothing to do (no schema or config selected)."));
   }
 END_FUNCTION
 /* clang-format on */
 
+static double now(void) {
+  struct timespec time;
+
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+static t3_config_schema_t *schema;
+
+static char *error_message(const char *fmt, const char *name, t3_config_error_t *error) {
+  char *result = format_message(fmt, error->file_name != NULL ? error->file_name : name,
+                                error->line_number, t3_config_strerror(error->error),
+                                error->extra ? error->extra : "");
+  free(error->extra);
+  free(error->file_name);
+  return result;
+}
+
+static void check_config(check_t *check) {
+  t3_config_t *config;
+  t3_config_error_t error;
+  t3_config_opts_t opts;
+  double start = now();
+  FILE *file;
+
+  opts.flags = T3_CONFIG_VERBOSE_ERROR | T3_CONFIG_ERROR_FILE_NAME;
+  error.extra = NULL;
+  error.file_name = NULL;
+
+  if ((file = fopen(check->name, "r")) == NULL) {
+    check->message = format_message(_("%s: Could not open config: %s\n"), check->name,
+                                    strerror(errno));
+    return;
+  }
+  config = t3_config_read_file(file, &error, &opts);
+  fclose(file);
+  if (!config) {
+    check->message = error_message(_("%s:%d: Could not load config: %s: %s\n"), check->name,
+                                   &error);
+  } else if (schema && !t3_config_validate(config, schema, &error,
+                                           T3_CONFIG_VERBOSE_ERROR | T3_CONFIG_ERROR_FILE_NAME)) {
+    check->message = error_message(_("%s:%d: Validation of the config failed: %s: %s\n"),
+                                   check->name, &error);
+  }
+  t3_config_delete(config);
+  check->seconds = now() - start;
+}
+
+static pthread_mutex_t next_check_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t next_check;
+
+static void *check_configs(void *data) {
+  size_t i;
+
+  (void)data;
+  for (;;) {
+    pthread_mutex_lock(&next_check_lock);
+    i = next_check++;
+    pthread_mutex_unlock(&next_check_lock);
+    if (i >= check_count) {
+      return NULL;
+    }
+    check_config(&checks[i]);
+  }
+}
 
 int main(int argc, char *argv[]) {
-  t3_config_schema_t *schema = NULL;
-  t3_config_t *config = NULL;
+  pthread_t *threads;
   t3_config_error_t error;
   t3_config_opts_t opts;
+  size_t i, failed = 0;
+  double start;
+  /* Show a line for every config only if there is more than one, to keep the output of a single
+     check the same as it always was. */
+  int summary;
 
   opts.flags = T3_CONFIG_VERBOSE_ERROR | T3_CONFIG_ERROR_FILE_NAME;
 
@@ -105,28 +279,57 @@ int main(int argc, char *argv[]) {
 #endif
 
   parse_args(argc, argv);
+  summary = option_verbose || check_count > 1;
 
+  start = now();
   if (option_schema) {
     FILE *file = fopen(option_schema, "r");
+    if (file == NULL) {
+      fatal(_("%s: Could not open schema: %s\n"), option_schema, strerror(errno));
+    }
     schema = t3_config_read_schema_file(file, &error, &opts);
     if (!schema) {
       fatal(_("%s:%d: Could not load schema: %s: %s\n"), error.file_name, error.line_number, t3_config_strerror(error.error), error.extra ? error.extra : "");
     }
     fclose(file);
+    if (summary) {
+      printf(_("%s: schema loaded in %.3f s\n"), option_schema, now() - start);
+    }
   }
 
-  if (option_config) {
-    FILE *file = fopen(option_config, "r");
-    config = t3_config_read_file(file, &error, &opts);
-    if (!config) {
-      fatal(_("%s:%d: Could not load config: %s: %s\n"), error.file_name, error.line_number, t3_config_strerror(error.error), error.extra ? error.extra : "");
+  /* The schema is only read while validating, so it can be shared by all threads. */
+  if ((size_t)option_jobs > check_count) {
+    option_jobs = check_count == 0 ? 1 : (int)check_count;
+  }
+  if (option_jobs == 1) {
+    check_configs(NULL);
+  } else {
+    if ((threads = malloc(option_jobs * sizeof(pthread_t))) == NULL) {
+      fatal(_("Out of memory\n"));
     }
-    fclose(file);
-    if (schema) {
-      if (!t3_config_validate(config, schema, &error, T3_CONFIG_VERBOSE_ERROR | T3_CONFIG_ERROR_FILE_NAME)) {
-        fatal(_("%s:%d: Validation of the config failed: %s: %s\n"), error.file_name, error.line_number, t3_config_strerror(error.error), error.extra ? error.extra : "");
+    for (i = 0; i < (size_t)option_jobs; i++) {
+      if (pthread_create(&threads[i], NULL, check_configs, NULL) != 0) {
+        fatal(_("Could not create thread\n"));
       }
     }
+    for (i = 0; i < (size_t)option_jobs; i++) {
+      pthread_join(threads[i], NULL);
+    }
+    free(threads);
+  }
+
+  for (i = 0; i < check_count; i++) {
+    if (checks[i].message != NULL) {
+      failed++;
+      fputs(checks[i].message, stderr);
+    } else if (summary) {
+      printf(_("%s: OK (%.3f s)\n"), checks[i].name, checks[i].seconds);
+    }
+  }
+  if (summary) {
+    printf(_("%lu configs checked, %lu failed, in %.3f s\n"), (unsigned long)check_count,
+           (unsigned long)failed, now() - start);
   }
-  return 0;
+  t3_config_delete_schema(schema);
+  return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,270 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_internal.h"
+#include "util.h"
+
+/* A binding which still has to be resolved. The bindings are sorted by path, such that all
+   bindings below a section form a consecutive range, and each section in the config is visited
+   at most once. */
+typedef struct {
+  const t3_config_binding_t *binding;
+  /* The index of the binding in the caller's table. */
+  size_t index;
+  int status;
+} bind_entry_t;
+
+/* Bindings which have not been matched against the config yet. This value is never reported to
+   the caller: such bindings get their default value, or T3_ERR_MISSING_KEY. */
+#define NOT_FOUND 1
+
+#define END_OF_NAME(c) ((c) == 0 || (c) == '/')
+
+/* Order characters such that the end of a name sorts before all other characters. */
+static int path_char(char c) {
+  return c == 0 ? 0 : c == '/' ? 1 : (unsigned char)c + 1;
+}
+
+static int compare_entries(const void *a, const void *b) {
+  const char *path_a = ((const bind_entry_t *)a)->binding->path;
+  const char *path_b = ((const bind_entry_t *)b)->binding->path;
+
+  while (*path_a == *path_b && *path_a != 0) {
+    path_a++;
+    path_b++;
+  }
+  return path_char(*path_a) - path_char(*path_b);
+}
+
+/* Compare the first name in @p path with @p name, in the same order as compare_entries. */
+static int compare_name(const char *path, const char *name) {
+  while (!END_OF_NAME(*path) && *path == *name) {
+    path++;
+    name++;
+  }
+  if (END_OF_NAME(*path)) {
+    return *name == 0 ? 0 : -1;
+  }
+  return path_char(*path) - path_char(*name);
+}
+
+static t3_bool valid_binding(const t3_config_binding_t *binding) {
+  const char *ptr;
+
+  if (binding->type == T3_CONFIG_NONE || (unsigned)binding->type > T3_CONFIG_PLIST ||
+      binding->path == NULL || binding->path[0] == 0) {
+    return t3_false;
+  }
+  /* Empty names never match, so they are rejected to catch mistakes in the table. */
+  for (ptr = binding->path; *ptr != 0; ptr++) {
+    if (*ptr == '/' && (ptr == binding->path || END_OF_NAME(ptr[1]))) {
+      return t3_false;
+    }
+  }
+  return t3_true;
+}
+
+static int store_value(const t3_config_t *item, const t3_config_binding_t *binding, char *result) {
+  void *dest = result + binding->offset;
+
+  switch (binding->type) {
+    case T3_CONFIG_BOOL:
+      if (item->type != T3_CONFIG_BOOL) {
+        return T3_ERR_INVALID_KEY_TYPE;
+      }
+      *(t3_bool *)dest = item->value.boolean;
+      break;
+    case T3_CONFIG_INT:
+      if (item->type != T3_CONFIG_INT) {
+        return T3_ERR_INVALID_KEY_TYPE;
+      }
+      *(int64_t *)dest = item->value.integer;
+      break;
+    case T3_CONFIG_NUMBER:
+      /* Integers are accepted as well, as a number written without a fraction is an integer. */
+      if (item->type == T3_CONFIG_INT) {
+        *(double *)dest = (double)item->value.integer;
+      } else if (item->type == T3_CONFIG_NUMBER) {
+        *(double *)dest = item->value.number;
+      } else {
+        return T3_ERR_INVALID_KEY_TYPE;
+      }
+      break;
+    case T3_CONFIG_STRING:
+      if (item->type != T3_CONFIG_STRING) {
+        return T3_ERR_INVALID_KEY_TYPE;
+      }
+      *(const char **)dest = STRING_VALUE(item);
+      break;
+    case T3_CONFIG_LIST:
+    case T3_CONFIG_PLIST:
+      if (item->type != T3_CONFIG_LIST && item->type != T3_CONFIG_PLIST) {
+        return T3_ERR_INVALID_KEY_TYPE;
+      }
+      *(const t3_config_t **)dest = item;
+      break;
+    case T3_CONFIG_SECTION:
+      if (item->type != T3_CONFIG_SECTION) {
+        return T3_ERR_INVALID_KEY_TYPE;
+      }
+      *(const t3_config_t **)dest = item;
+      break;
+    default:
+      return T3_ERR_BAD_ARG;
+  }
+  return T3_ERR_SUCCESS;
+}
+
+static void store_default(const t3_config_binding_t *binding, char *result) {
+  void *dest = result + binding->offset;
+
+  switch (binding->type) {
+    case T3_CONFIG_BOOL:
+      *(t3_bool *)dest = binding->dflt.boolean;
+      break;
+    case T3_CONFIG_INT:
+      *(int64_t *)dest = binding->dflt.integer;
+      break;
+    case T3_CONFIG_NUMBER:
+      *(double *)dest = binding->dflt.number;
+      break;
+    case T3_CONFIG_STRING:
+      *(const char **)dest = binding->dflt.string;
+      break;
+    default:
+      *(const t3_config_t **)dest = NULL;
+      break;
+  }
+}
+
+/** Resolve the sorted @p entries against the items in @p section.
+    All paths in @p entries share their first @p offset characters, which name @p section.
+*/
+static void bind_section(const t3_config_t *section, bind_entry_t *entries, size_t count,
+                         size_t offset, char *result) {
+  const t3_config_t *item;
+  size_t low, high, mid = 0, end, sub;
+  int cmp;
+
+  for (item = section->value.list; item != NULL; item = item->next) {
+    /* Find any entry whose next name equals the name of the item. */
+    for (low = 0, high = count; low < high;) {
+      mid = low + (high - low) / 2;
+      if ((cmp = compare_name(entries[mid].binding->path + offset, item->name)) == 0) {
+        break;
+      } else if (cmp < 0) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    if (low >= high) {
+      continue;
+    }
+
+    /* Extend the match to the whole range of entries with this name. */
+    for (low = mid; low > 0 && compare_name(entries[low - 1].binding->path + offset,
+                                            item->name) == 0;
+         low--) {
+    }
+    for (end = mid + 1;
+         end < count && compare_name(entries[end].binding->path + offset, item->name) == 0;
+         end++) {
+    }
+
+    /* The entries ending at this name sort before those continuing below it. */
+    sub = offset + strlen(item->name);
+    for (; low < end && entries[low].binding->path[sub] == 0; low++) {
+      entries[low].status = store_value(item, entries[low].binding, result);
+    }
+    if (low == end) {
+      continue;
+    }
+    if (item->type == T3_CONFIG_SECTION) {
+      bind_section(item, entries + low, end - low, sub + 1, result);
+    } else {
+      for (; low < end; low++) {
+        entries[low].status = T3_ERR_INVALID_KEY_TYPE;
+      }
+    }
+  }
+}
+
+int t3_config_bind(const t3_config_t *config, const t3_config_binding_t *bindings, size_t count,
+                   void *result, int *status) {
+  bind_entry_t *entries;
+  size_t i, valid;
+  int retval = T3_ERR_SUCCESS;
+  size_t first_error = count;
+
+  if (config == NULL || config->type != T3_CONFIG_SECTION || (count > 0 && bindings == NULL) ||
+      result == NULL) {
+    return T3_ERR_BAD_ARG;
+  }
+  if (count == 0) {
+    return T3_ERR_SUCCESS;
+  }
+  if ((entries = _t3_config_mem_alloc(count * sizeof(bind_entry_t))) == NULL) {
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+
+  /* Invalid bindings are not included in the lookup, but reported at the end. */
+  for (i = 0, valid = 0; i < count; i++) {
+    if (valid_binding(&bindings[i])) {
+      entries[valid].binding = &bindings[i];
+      entries[valid].index = i;
+      entries[valid].status = NOT_FOUND;
+      valid++;
+    }
+  }
+
+  qsort(entries, valid, sizeof(bind_entry_t), compare_entries);
+  bind_section(config, entries, valid, 0, result);
+
+  for (i = 0; i < valid; i++) {
+    if (entries[i].status == NOT_FOUND) {
+      if (entries[i].binding->flags & T3_CONFIG_BIND_REQUIRED) {
+        entries[i].status = T3_ERR_MISSING_KEY;
+      } else {
+        store_default(entries[i].binding, result);
+        entries[i].status = T3_ERR_SUCCESS;
+      }
+    }
+    if (status != NULL) {
+      status[entries[i].index] = entries[i].status;
+    }
+    if (entries[i].status != T3_ERR_SUCCESS && entries[i].index < first_error) {
+      first_error = entries[i].index;
+      retval = entries[i].status;
+    }
+  }
+  _t3_config_mem_free(entries);
+
+  if (valid < count) {
+    for (i = 0; i < count; i++) {
+      if (!valid_binding(&bindings[i])) {
+        if (status != NULL) {
+          status[i] = T3_ERR_BAD_ARG;
+        }
+        if (i < first_error) {
+          first_error = i;
+          retval = T3_ERR_BAD_ARG;
+        }
+      }
+    }
+  }
+  return retval;
+}
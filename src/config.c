@@ -17,7 +17,9 @@
 
 #include "config_internal.h"
 #include "expression.h"
+#include "hash.h"
 #include "parser.h"
+#include "probes.h"
 #include "util.h"
 
 #ifdef USE_GETTEXT
@@ -27,29 +29,167 @@
 #define _(x) (x)
 #endif
 
+/* The counter from which the generations of top-level items are taken. A new value is taken for
+   every modification and for every new config, so generations are never reused. */
+static uint64_t generation = 1;
+
+uint64_t _t3_config_new_generation(void) {
+#ifdef __GNUC__
+  return __atomic_add_fetch(&generation, 1, __ATOMIC_RELAXED);
+#else
+  return ++generation;
+#endif
+}
+
+/* The first item of a shared list refers to its shared_list_t through a pointer with the lowest bit
+   set, which distinguishes it from a pointer to the owner. */
+#define TAG_SHARED(shared) ((t3_config_t *)((uintptr_t)(shared) | 1))
+
+/** Get the shared_list_t from the up pointer of the first item of a list, or NULL if @p up is
+    not tagged.
+*/
+static shared_list_t *untag_shared(const t3_config_t *up) {
+  return (uintptr_t)up & 1 ? (shared_list_t *)((uintptr_t)up & ~(uintptr_t)1) : NULL;
+}
+
+/** Get the shared_list_t of the list of items starting at @p first, or NULL if the list has never
+    been shared. The list is only shared with other sections or lists if the count in the
+    shared_list_t is non-zero.
+*/
+static shared_list_t *shared_list(const t3_config_t *first) {
+  return untag_shared(ATOMIC_LOAD(first->link.up));
+}
+
+/** Check whether the list of items starting at @p first is shared with other sections or lists. */
+t3_bool _t3_config_is_shared(const t3_config_t *first) {
+  shared_list_t *shared = shared_list(first);
+  return shared != NULL && ATOMIC_LOAD(shared->count) > 0;
+}
+
+/** Get the section or list containing @p config.
+    @param config The item to get the owner for, which must not be a top-level item.
+    @param shared The location to store whether the list containing @p config is shared.
+    @return The section or list, or NULL if it is not known.
+*/
+static t3_config_t *get_owner(const t3_config_t *config, t3_bool *shared) {
+  const t3_config_t *first = config->flags & T3_CONFIG_FIRST ? config : config->link.up;
+  t3_config_t *up = ATOMIC_LOAD(first->link.up);
+  shared_list_t *list;
+
+  *shared = t3_false;
+  if ((list = untag_shared(up)) == NULL) {
+    return up;
+  }
+  *shared = ATOMIC_LOAD(list->count) > 0;
+  return ATOMIC_LOAD(list->owner);
+}
+
+/** Get the generation of the top-level item above @p config (see t3_config_t::link).
+    @return The generation, or 0 if the path to the top-level item is not known. In that case no
+        list on the path can be modified before the path is known again.
+*/
+uint64_t _t3_config_generation(const t3_config_t *config) {
+  t3_bool shared;
+
+  while (!IS_TOP_LEVEL(config)) {
+    if ((config = get_owner(config, &shared)) == NULL) {
+      return 0;
+    }
+  }
+  return config->link.generation;
+}
+
+/** Record that @p config was modified, by giving the top-level item above it a new generation.
+    @p config must be modifiable (see _t3_config_writable), such
+    that the path to the top-level item is known.
+*/
+void _t3_config_modified(t3_config_t *config) {
+  t3_bool shared;
+
+  while (!IS_TOP_LEVEL(config)) {
+    if ((config = get_owner(config, &shared)) == NULL) {
+      return;
+    }
+  }
+  config->link.generation = _t3_config_new_generation();
+}
+
+/** Turn @p config, which is not or no longer part of a list of items, into a top-level item. */
+void _t3_config_make_top_level(t3_config_t *config) {
+  config->flags = (config->flags & ~T3_CONFIG_FIRST) | T3_CONFIG_TOP_LEVEL;
+  config->link.generation = _t3_config_new_generation();
+}
+
 t3_config_t *t3_config_new(void) {
   t3_config_t *result;
 
-  if ((result = malloc(sizeof(t3_config_t))) == NULL) {
+  if ((result = _t3_config_mem_alloc(sizeof(t3_config_t))) == NULL) {
     return NULL;
   }
   result->name = NULL;
   result->type = T3_CONFIG_SECTION;
   result->value.list = NULL;
   result->next = NULL;
-  result->file_name = NULL;
+  result->flags = T3_CONFIG_TOP_LEVEL;
+  result->link.generation = _t3_config_new_generation();
+  result->file_index = 0;
+  return result;
+}
+
+static t3_bool is_aggregate(const t3_config_t *config) {
+  return config->type == T3_CONFIG_SECTION || config->type == T3_CONFIG_LIST ||
+         config->type == T3_CONFIG_PLIST;
+}
+
+/** Set the up pointers of all items below @p config, after reading it. */
+static void link_tree(t3_config_t *config) {
+  t3_config_t *item;
+
+  _t3_config_link_items(config);
+  for (item = config->value.list; item != NULL; item = item->next) {
+    if (is_aggregate(item)) {
+      link_tree(item);
+    }
+  }
+}
+
+/** Compute the maximum nesting depth of the sections and lists in @p config. */
+static int max_depth(const t3_config_t *config) {
+  const t3_config_t *item;
+  int result = 0, depth;
+
+  for (item = config->value.list; item != NULL; item = item->next) {
+    if (item->type == T3_CONFIG_SECTION || item->type == T3_CONFIG_LIST ||
+        item->type == T3_CONFIG_PLIST) {
+      if ((depth = max_depth(item) + 1) > result) {
+        result = depth;
+      }
+    }
+  }
   return result;
 }
 
 /** Read config, either from file or from buffer. */
 static t3_config_t *config_read(parse_context_t *context, t3_config_error_t *error) {
+  double start = 0.0;
   int retval;
 
+  context->stats = NULL;
+  if (context->opts != NULL && (context->opts->flags & T3_CONFIG_STATS) &&
+      context->opts->stats != NULL) {
+    context->stats = context->opts->stats;
+    memset(context->stats, 0, sizeof(t3_config_stats_t));
+    start = _t3_config_time();
+  }
+
+  PROBE1(parse__start, context->scan_type);
+
   context->line_number = 1;
   context->result = NULL;
   context->constraint_parser = t3_false;
   context->error_extra = NULL;
   context->included = NULL;
+  _t3_config_string_table_init(&context->strings);
 
   /* Initialize lexer. */
   if (_t3_config_lex_init_extra(context, &context->scanner) != 0) {
@@ -65,6 +205,7 @@ static t3_config_t *config_read(parse_context_t *context, t3_config_error_t *err
         }
       }
     }
+    PROBE1(parse__done, T3_ERR_OUT_OF_MEMORY);
     return NULL;
   }
 
@@ -86,11 +227,42 @@ static t3_config_t *config_read(parse_context_t *context, t3_config_error_t *err
     t3_config_delete(context->result);
     /* ... and set context->config to NULL so we return NULL at the end. */
     context->result = NULL;
+  } else {
+    link_tree(context->result);
+    _t3_config_make_top_level(context->result);
+    if (context->opts != NULL && (context->opts->flags & T3_CONFIG_DEDUP)) {
+      /* The names are already shared through the table, so the table is reused for the values. */
+      if ((retval = _t3_config_dedup(context->result, &context->strings)) != T3_ERR_SUCCESS) {
+        if (error != NULL) {
+          error->error = retval;
+          error->line_number = 0;
+          if (context->opts->flags & T3_CONFIG_VERBOSE_ERROR) {
+            error->extra = NULL;
+          }
+          if (context->opts->flags & T3_CONFIG_ERROR_FILE_NAME) {
+            error->file_name = NULL;
+          }
+        }
+        t3_config_delete(context->result);
+        context->result = NULL;
+      }
+    }
   }
   /* Delete the chain of included files (if there still is one after an error). */
   t3_config_delete(context->included);
   /* Free memory allocated by lexer. */
   _t3_config_lex_destroy(context->scanner);
+  _t3_config_string_table_free(&context->strings);
+
+  if (context->stats != NULL) {
+    /* Lexing and opening included files happen during the parse, so they are not counted twice. */
+    context->stats->parse_time = _t3_config_time() - start - context->stats->lex_time -
+                                 context->stats->include_time;
+    if (context->result != NULL) {
+      context->stats->max_depth = max_depth(context->result);
+    }
+  }
+  PROBE1(parse__done, retval);
   return context->result;
 }
 
@@ -120,20 +292,77 @@ t3_config_t *t3_config_read_buffer(const char *buffer, size_t size, t3_config_er
   return config_read(&context, error);
 }
 
+/* The flags which describe how the string value of an item is stored. */
+#define STRING_FLAGS (T3_CONFIG_SHARED_STRING | T3_CONFIG_INLINE_STRING)
+
+/** Free the string value of @p config, which may be a shared string record or stored inline. */
+void _t3_config_free_string_value(t3_config_t *config) {
+  if (config->flags & T3_CONFIG_SHARED_STRING) {
+    _t3_config_release_string(config->value.string);
+  } else if (!(config->flags & T3_CONFIG_INLINE_STRING)) {
+    _t3_config_mem_free(config->value.string);
+  }
+  config->flags &= ~STRING_FLAGS;
+}
+
+/** Drop the reference of @p owner to its list of items.
+    @return ::t3_true if @p owner was the last owner, in which case the items must be deleted.
+*/
+static t3_bool release_items(t3_config_t *owner) {
+  shared_list_t *shared = shared_list(owner->value.list);
+
+  if (shared == NULL || ATOMIC_LOAD(shared->count) == 0) {
+    return t3_true;
+  }
+  /* The remaining owners only use the owner of the list after they have seen that the list is no
+     longer shared, so it can be cleared before the reference is dropped. */
+  if (ATOMIC_LOAD(shared->owner) == owner) {
+    ATOMIC_STORE(shared->owner, NULL);
+  }
+  if (ATOMIC_FETCH_ADD(shared->count, -1) > 0) {
+    return t3_false;
+  }
+  /* The other owners dropped their references concurrently, so this was the last reference. */
+  ATOMIC_STORE(shared->count, 0);
+  return t3_true;
+}
+
+/** Release the list of items in @p owner, deleting it if it is not shared. */
+void _t3_config_delete_items(t3_config_t *owner) {
+  if (owner->value.list != NULL && release_items(owner)) {
+    t3_config_delete(owner->value.list);
+  }
+  owner->value.list = NULL;
+}
+
 void t3_config_delete(t3_config_t *config) {
   t3_config_t *ptr = config;
+  shared_list_t *shared;
+
+  /* Frozen configs are released as a whole, when the top-level item is deleted. */
+  if (config != NULL && (config->flags & T3_CONFIG_FROZEN)) {
+    if (config->flags & T3_CONFIG_FROZEN_ROOT) {
+      _t3_config_delete_frozen(config);
+    }
+    return;
+  }
+
+  if (config != NULL && (config->flags & T3_CONFIG_FIRST) &&
+      (shared = shared_list(config)) != NULL) {
+    _t3_config_mem_free(shared);
+  }
 
   while (config != NULL) {
     config = ptr->next;
     switch ((int)ptr->type) {
       case T3_CONFIG_STRING:
-        free(ptr->value.string);
+        _t3_config_free_string_value(ptr);
         break;
       case T3_CONFIG_LIST:
       case T3_CONFIG_PLIST:
       case T3_CONFIG_SECTION:
       case T3_CONFIG_SCHEMA:
-        t3_config_delete(ptr->value.list);
+        _t3_config_delete_items(ptr);
         break;
       case T3_CONFIG_EXPRESSION:
         _t3_config_delete_expr(ptr->value.expr);
@@ -141,25 +370,301 @@ void t3_config_delete(t3_config_t *config) {
       default:
         break;
     }
-    _t3_config_unref_file_name(ptr);
-    free(ptr->name);
-    free(ptr);
+    _t3_config_release_string(ptr->name);
+    _t3_config_release_file_name(ptr->file_index);
+    _t3_config_mem_free(ptr);
     ptr = config;
   }
 }
 
+/** Set the up pointers of the items in the list of @p owner, which has never been shared. */
+void _t3_config_link_items(t3_config_t *owner) {
+  t3_config_t *first = owner->value.list, *item;
+
+  if (first == NULL) {
+    return;
+  }
+  first->flags = (first->flags & ~T3_CONFIG_TOP_LEVEL) | T3_CONFIG_FIRST;
+  first->link.up = owner;
+  for (item = first->next; item != NULL; item = item->next) {
+    item->flags &= ~(T3_CONFIG_FIRST | T3_CONFIG_TOP_LEVEL);
+    item->link.up = first;
+  }
+}
+
+/** Update the up pointers after the list of items of @p old_owner was moved to @p owner. */
+void _t3_config_move_items(t3_config_t *owner, const t3_config_t *old_owner) {
+  shared_list_t *shared;
+
+  if (owner->value.list == NULL || !is_aggregate(owner)) {
+    return;
+  }
+  if ((shared = shared_list(owner->value.list)) == NULL) {
+    _t3_config_link_items(owner);
+  } else if (ATOMIC_LOAD(shared->owner) == old_owner) {
+    ATOMIC_STORE(shared->owner, owner);
+  }
+}
+
+/** Add a reference to the list of items starting at @p first, for another section or list which
+    shares the list. If the list has not been shared before, its shared_list_t is allocated.
+*/
+int _t3_config_share_items(t3_config_t *first) {
+  t3_config_t *up = ATOMIC_LOAD(first->link.up);
+  shared_list_t *shared;
+
+  while ((shared = untag_shared(up)) == NULL) {
+    if ((shared = _t3_config_mem_alloc(sizeof(shared_list_t))) == NULL) {
+      return T3_ERR_OUT_OF_MEMORY;
+    }
+    shared->owner = up;
+    shared->count = 1;
+    /* Another thread may share the list at the same time, in which case its record is used. */
+    if (ATOMIC_CAS(first->link.up, up, TAG_SHARED(shared))) {
+      return T3_ERR_SUCCESS;
+    }
+    _t3_config_mem_free(shared);
+  }
+  ATOMIC_FETCH_ADD(shared->count, 1);
+  return T3_ERR_SUCCESS;
+}
+
+/** Record that none of the sections or lists sharing the list starting at @p first owns it.
+    The items in the list can then only be modified after one of them has copied or claimed the
+    list with _t3_config_unshare, as there is no owner to copy the path for.
+*/
+void _t3_config_disown_items(t3_config_t *first) {
+  shared_list_t *shared = shared_list(first);
+
+  if (shared != NULL) {
+    ATOMIC_STORE(shared->owner, NULL);
+  }
+}
+
+/** Create a copy of a single item.
+    The copy shares the list of sub-items (if any) with @p config.
+*/
+static t3_config_t *copy_item(const t3_config_t *config, int *error) {
+  t3_config_t *result;
+
+  if ((int)config->type == T3_CONFIG_EXPRESSION || (int)config->type == T3_CONFIG_SCHEMA) {
+    *error = T3_ERR_BAD_ARG;
+    return NULL;
+  }
+
+  if ((result = _t3_config_mem_alloc(sizeof(t3_config_t))) == NULL) {
+    *error = T3_ERR_OUT_OF_MEMORY;
+    return NULL;
+  }
+  *result = *config;
+  result->next = NULL;
+  _t3_config_make_top_level(result);
+
+  if (config->name != NULL && (result->name = _t3_config_ref_string(config->name)) == NULL) {
+    _t3_config_mem_free(result);
+    *error = T3_ERR_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  switch (config->type) {
+    case T3_CONFIG_STRING:
+      if (config->flags & T3_CONFIG_SHARED_STRING) {
+        result->value.string = _t3_config_ref_string(config->value.string);
+      } else if (!(config->flags & T3_CONFIG_INLINE_STRING) && config->value.string != NULL &&
+                 (result->value.string = _t3_config_strdup(config->value.string)) == NULL) {
+        _t3_config_release_string(result->name);
+        _t3_config_mem_free(result);
+        *error = T3_ERR_OUT_OF_MEMORY;
+        return NULL;
+      }
+      break;
+    case T3_CONFIG_LIST:
+    case T3_CONFIG_PLIST:
+    case T3_CONFIG_SECTION:
+      if (result->value.list != NULL &&
+          (*error = _t3_config_share_items(result->value.list)) != T3_ERR_SUCCESS) {
+        _t3_config_release_string(result->name);
+        _t3_config_mem_free(result);
+        return NULL;
+      }
+      break;
+    default:
+      break;
+  }
+  _t3_config_ref_file_name(result->file_index);
+  return result;
+}
+
+/** Make sure the list of items in @p config is not shared with any other (sub-)config.
+    If the list is shared, the items in it are copied. The sub-items of the copied items
+    remain shared, such that only a single level is copied. If the list was shared before, its
+    shared_list_t is freed, such that the up pointers in the list can be changed again.
+*/
+int _t3_config_unshare(t3_config_t *config) {
+  t3_config_t *first, *ptr, *result = NULL, **next_ptr = &result;
+  shared_list_t *shared;
+  int error;
+
+  if (config->flags & T3_CONFIG_FROZEN) {
+    return T3_ERR_BAD_ARG;
+  }
+  if (!is_aggregate(config) || (first = config->value.list) == NULL) {
+    return T3_ERR_SUCCESS;
+  }
+  if ((shared = shared_list(first)) == NULL) {
+    return T3_ERR_SUCCESS;
+  }
+
+  if (ATOMIC_LOAD(shared->count) > 0) {
+    for (ptr = first; ptr != NULL; ptr = ptr->next) {
+      if ((*next_ptr = copy_item(ptr, &error)) == NULL) {
+        t3_config_delete(result);
+        return error;
+      }
+      next_ptr = &(*next_ptr)->next;
+    }
+    if (!release_items(config)) {
+      config->value.list = result;
+      _t3_config_link_items(config);
+      /* The items below config are different items now, so cached lookups must not use them. */
+      _t3_config_modified(config);
+      return T3_ERR_SUCCESS;
+    }
+    /* The other owners released the list while it was copied, so the copy is not needed. */
+    t3_config_delete(result);
+  }
+  /* The other owners have released the list, so config claims it, which makes it private. */
+  _t3_config_mem_free(shared);
+  _t3_config_link_items(config);
+  return T3_ERR_SUCCESS;
+}
+
+/** Get a version of @p config which can be modified without affecting other configs.
+    If @p config is part of a shared list of items, or below an item in such a list, the lists on
+    the path from the top-level item to @p config are copied first, and the copy of @p config is
+    returned. A shared list belongs to its owner, the section or list it was first shared from, so
+    the path through the owners is copied. The other configs keep the original items.
+    @return The modifiable (copy of) @p config, or NULL if @p config is frozen, the owner of a
+        shared list on the path has released it, or there is insufficient memory.
+*/
+t3_config_t *_t3_config_writable(t3_config_t *config, int *error) {
+  t3_config_t *first, *owner, *writable_owner;
+  t3_bool shared;
+  int index = 0;
+
+  if (config->flags & T3_CONFIG_FROZEN) {
+    *error = T3_ERR_BAD_ARG;
+    return NULL;
+  }
+  if (IS_TOP_LEVEL(config)) {
+    return config;
+  }
+  if ((owner = get_owner(config, &shared)) == NULL) {
+    *error = T3_ERR_BAD_ARG;
+    return NULL;
+  }
+  if ((writable_owner = _t3_config_writable(owner, error)) == NULL) {
+    return NULL;
+  }
+  if (writable_owner == owner && !shared) {
+    return config;
+  }
+
+  /* Either the list containing config is shared, or its owner was copied and the copy shares the
+     list. In both cases the list is copied, and config is the item at the same position. */
+  first = config->flags & T3_CONFIG_FIRST ? config : config->link.up;
+  for (; first != config; first = first->next) {
+    index++;
+  }
+  if ((*error = _t3_config_unshare(writable_owner)) != T3_ERR_SUCCESS) {
+    return NULL;
+  }
+  for (config = writable_owner->value.list; index > 0; index--) {
+    config = config->next;
+  }
+  return config;
+}
+
+/** Replace the value of @p dest by the value of @p src, keeping the position and name of @p dest.
+    @p src is deleted.
+*/
+void _t3_config_replace_value(t3_config_t *dest, t3_config_t *src) {
+  t3_config_t tmp = *dest;
+
+  dest->type = src->type;
+  dest->line_number = src->line_number;
+  dest->file_index = src->file_index;
+  dest->value = src->value;
+  dest->flags = (dest->flags & ~STRING_FLAGS) | (src->flags & STRING_FLAGS);
+
+  src->type = tmp.type;
+  src->line_number = tmp.line_number;
+  src->file_index = tmp.file_index;
+  src->value = tmp.value;
+  src->flags = (src->flags & ~STRING_FLAGS) | (tmp.flags & STRING_FLAGS);
+  _t3_config_move_items(dest, src);
+  _t3_config_move_items(src, dest);
+  t3_config_delete(src);
+  _t3_config_modified(dest);
+}
+
+t3_config_t *t3_config_clone(const t3_config_t *config, int *error) {
+  t3_config_t *result;
+  int local_error;
+
+  if (config == NULL) {
+    if (error != NULL) {
+      *error = T3_ERR_BAD_ARG;
+    }
+    return NULL;
+  }
+
+  /* Frozen configs can not share their items, so they are copied completely. */
+  if (config->flags & T3_CONFIG_FROZEN) {
+    result = _t3_config_thaw(config, &local_error);
+  } else {
+    result = copy_item(config, &local_error);
+  }
+  if (result == NULL && error != NULL) {
+    *error = local_error;
+  }
+  return result;
+}
+
+t3_config_t *t3_config_get_mutable(t3_config_t *config, const char *name) {
+  int error;
+
+  if (config == NULL || (config = _t3_config_writable(config, &error)) == NULL ||
+      _t3_config_unshare(config) != T3_ERR_SUCCESS) {
+    return NULL;
+  }
+  return t3_config_get(config, name);
+}
+
+/** Check whether the item name @p item_name equals @p name, which has hash value @p hash.
+    Comparing the hash values first avoids most string comparisons.
+*/
+static t3_bool name_matches(const char *item_name, const char *name, uint32_t hash) {
+  return item_name == name || (STRING_HASH(item_name) == hash && strcmp(item_name, name) == 0);
+}
+
 t3_config_t *t3_config_unlink(t3_config_t *config, const char *name) {
   t3_config_t *ptr, *prev;
+  uint32_t hash;
+  int error;
 
-  if (config == NULL || config->type != T3_CONFIG_SECTION) {
+  if (config == NULL || config->type != T3_CONFIG_SECTION ||
+      (config = _t3_config_writable(config, &error)) == NULL ||
+      _t3_config_unshare(config) != T3_ERR_SUCCESS) {
     return NULL;
   }
 
   prev = NULL;
   ptr = config->value.list;
+  hash = _t3_config_hash_string(name, strlen(name));
 
   /* Find the named item in the list, keeping a reference to the item preceeding it. */
-  while (ptr != NULL && strcmp(ptr->name, name) != 0) {
+  while (ptr != NULL && !name_matches(ptr->name, name, hash)) {
     prev = ptr;
     ptr = ptr->next;
   }
@@ -170,41 +675,54 @@ t3_config_t *t3_config_unlink(t3_config_t *config, const char *name) {
 
   if (prev == NULL) {
     config->value.list = ptr->next;
+    _t3_config_link_items(config);
   } else {
     prev->next = ptr->next;
   }
   ptr->next = NULL;
+  _t3_config_make_top_level(ptr);
+  _t3_config_modified(config);
   return ptr;
 }
 
 t3_config_t *t3_config_unlink_from_list(t3_config_t *list, t3_config_t *item) {
   t3_config_t *ptr, *prev;
+  int index = 0, error;
 
-  if (list == NULL || (list->type != T3_CONFIG_SECTION && list->type != T3_CONFIG_LIST &&
-                       list->type != T3_CONFIG_PLIST)) {
+  if (list == NULL || !is_aggregate(list)) {
     return NULL;
   }
 
-  prev = NULL;
-  ptr = list->value.list;
-
-  /* Find the referenced item in the list, keeping a reference to the item preceeding it. */
-  while (ptr != NULL && ptr != item) {
-    prev = ptr;
-    ptr = ptr->next;
+  /* Find the referenced item in the list. */
+  for (ptr = list->value.list; ptr != NULL && ptr != item; ptr = ptr->next, index++) {
   }
 
   if (ptr == NULL) {
     return NULL;
   }
 
+  /* If the list is shared, or below a shared list, item refers to the shared copy. The item to
+     unlink is the one at the same position in the private copy. */
+  if ((list = _t3_config_writable(list, &error)) == NULL ||
+      _t3_config_unshare(list) != T3_ERR_SUCCESS) {
+    return NULL;
+  }
+
+  prev = NULL;
+  for (ptr = list->value.list; index > 0; ptr = ptr->next, index--) {
+    prev = ptr;
+  }
+
   if (prev == NULL) {
     list->value.list = ptr->next;
+    _t3_config_link_items(list);
   } else {
     prev->next = ptr->next;
   }
   ptr->next = NULL;
-  return item;
+  _t3_config_make_top_level(ptr);
+  _t3_config_modified(list);
+  return ptr;
 }
 
 void t3_config_erase(t3_config_t *config, const char *name) {
@@ -221,36 +739,41 @@ void t3_config_erase_from_list(t3_config_t *list, t3_config_t *item) {
 static t3_config_t *config_add(t3_config_t *config, const char *name, t3_config_type_t type) {
   t3_config_t *result;
 
-  if ((result = malloc(sizeof(t3_config_t))) == NULL) {
+  if ((result = _t3_config_mem_alloc(sizeof(t3_config_t))) == NULL) {
     return NULL;
   }
   if (name == NULL) {
     result->name = NULL;
   } else {
-    if ((result->name = _t3_config_strdup(name)) == NULL) {
-      free(result);
+    if ((result->name = _t3_config_new_string(name)) == NULL) {
+      _t3_config_mem_free(result);
       return NULL;
     }
   }
   result->type = type;
   result->next = NULL;
+  result->flags = 0;
   result->line_number = 0;
-  result->file_name = NULL;
+  result->file_index = 0;
 
   if (config->value.list == NULL) {
     config->value.list = result;
+    result->flags = T3_CONFIG_FIRST;
+    result->link.up = config;
   } else {
     t3_config_t *ptr = config->value.list;
     while (ptr->next != NULL) {
       ptr = ptr->next;
     }
     ptr->next = result;
+    result->link.up = config->value.list;
   }
 
   return result;
 }
 
-/** Check whether @p config is either ::T3_CONFIG_LIST, ::T3_CONFIG_PLIST or ::T3_CONFIG_SECTION .
+/** Check whether @p config is either ::T3_CONFIG_LIST, ::T3_CONFIG_PLIST or ::T3_CONFIG_SECTION ,
+    and @p name is set accordingly.
  */
 static t3_bool can_add(t3_config_t *config, const char *name) {
   return config != NULL &&
@@ -293,25 +816,33 @@ static t3_bool check_name(const char *name) {
 */
 static t3_config_t *add_or_replace(t3_config_t *config, const char *name, t3_config_type_t type) {
   t3_config_t *item;
+  if (_t3_config_unshare(config) != T3_ERR_SUCCESS) {
+    return NULL;
+  }
   if (name == NULL || (item = t3_config_get(config, name)) == NULL) {
-    return config_add(config, name, type);
+    if ((item = config_add(config, name, type)) != NULL) {
+      _t3_config_modified(item);
+    }
+    return item;
   }
 
   if (item->type == T3_CONFIG_STRING) {
-    free(item->value.string);
-  } else if (item->type == T3_CONFIG_SECTION || item->type == T3_CONFIG_LIST ||
-             item->type == T3_CONFIG_PLIST) {
-    t3_config_delete(item->value.list);
+    _t3_config_free_string_value(item);
+  } else if (is_aggregate(item)) {
+    _t3_config_delete_items(item);
   }
 
   item->type = type;
+  _t3_config_modified(item);
   return item;
 }
 
 #define ADD(name_type, arg_type, TYPE, value_set)                                         \
   int t3_config_add_##name_type(t3_config_t *config, const char *name, arg_type value) {  \
     t3_config_t *item;                                                                    \
+    int error;                                                                            \
     if (!can_add(config, name) || !check_name(name)) return T3_ERR_BAD_ARG;               \
+    if ((config = _t3_config_writable(config, &error)) == NULL) return error;             \
     if ((item = add_or_replace(config, name, TYPE)) == NULL) return T3_ERR_OUT_OF_MEMORY; \
     value_set return T3_ERR_SUCCESS;                                                      \
   }
@@ -326,7 +857,9 @@ ADD_SIMPLE(number, double, T3_CONFIG_NUMBER, number)
 
 int t3_config_add_string(t3_config_t *config, const char *name, const char *value) {
   t3_config_t *item;
-  char *value_copy;
+  char *value_copy = NULL;
+  size_t length;
+  int error;
 
   if (!can_add(config, name) || !check_name(name)) {
     return T3_ERR_BAD_ARG;
@@ -334,15 +867,25 @@ int t3_config_add_string(t3_config_t *config, const char *name, const char *valu
   if (strchr(value, '\n') != NULL) {
     return T3_ERR_BAD_ARG;
   }
-  if ((value_copy = _t3_config_strdup(value)) == NULL) {
+  if ((config = _t3_config_writable(config, &error)) == NULL) {
+    return error;
+  }
+  /* Short strings are stored in the item itself, and need no allocation. */
+  length = strlen(value);
+  if (!FITS_INLINE(length) && (value_copy = _t3_config_strdup(value)) == NULL) {
     return T3_ERR_OUT_OF_MEMORY;
   }
 
   if ((item = add_or_replace(config, name, T3_CONFIG_STRING)) == NULL) {
-    free(value_copy);
+    _t3_config_mem_free(value_copy);
     return T3_ERR_OUT_OF_MEMORY;
   }
-  item->value.string = value_copy;
+  if (value_copy == NULL) {
+    memcpy(item->value.short_string, value, length + 1);
+    item->flags |= T3_CONFIG_INLINE_STRING;
+  } else {
+    item->value.string = value_copy;
+  }
   return T3_ERR_SUCCESS;
 }
 
@@ -350,12 +893,20 @@ int t3_config_add_string(t3_config_t *config, const char *name, const char *valu
 static t3_config_t *t3_config_add_aggregate(t3_config_t *config, const char *name, int *error,
                                             t3_config_type_t type) {
   t3_config_t *item;
+  int local_error;
+
   if (!can_add(config, name) || !check_name(name)) {
     if (error != NULL) {
       *error = T3_ERR_BAD_ARG;
     }
     return NULL;
   }
+  if ((config = _t3_config_writable(config, &local_error)) == NULL) {
+    if (error != NULL) {
+      *error = local_error;
+    }
+    return NULL;
+  }
   if ((item = add_or_replace(config, name, type)) == NULL) {
     if (error != NULL) {
       *error = T3_ERR_OUT_OF_MEMORY;
@@ -377,43 +928,68 @@ ADD_AGGREGATE(section, T3_CONFIG_SECTION)
 
 int t3_config_add_existing(t3_config_t *config, const char *name, t3_config_t *value) {
   char *item_name = NULL;
-  if (!can_add(config, name) || !check_name(name) || value->next != NULL) {
+  int error;
+
+  if (!can_add(config, name) || !check_name(name) || value->next != NULL ||
+      !IS_TOP_LEVEL(value) || (value->flags & T3_CONFIG_FROZEN)) {
     return T3_ERR_BAD_ARG;
   }
+  if ((config = _t3_config_writable(config, &error)) == NULL) {
+    return error;
+  }
+  if (_t3_config_unshare(config) != T3_ERR_SUCCESS) {
+    return T3_ERR_OUT_OF_MEMORY;
+  }
 
-  if (name != NULL) {
-    if ((item_name = _t3_config_strdup(name)) == NULL) {
-      return T3_ERR_OUT_OF_MEMORY;
-    }
+  /* Keep the existing name record if the name does not change. */
+  if (name != NULL && value->name != NULL && strcmp(value->name, name) == 0) {
+    item_name = _t3_config_ref_string(value->name);
+  } else if (name != NULL) {
+    item_name = _t3_config_new_string(name);
+  }
+  if (name != NULL && item_name == NULL) {
+    return T3_ERR_OUT_OF_MEMORY;
   }
 
-  free(value->name);
+  _t3_config_release_string(value->name);
   value->name = item_name;
 
+  value->flags &= ~T3_CONFIG_TOP_LEVEL;
   if (config->value.list == NULL) {
     config->value.list = value;
+    value->flags |= T3_CONFIG_FIRST;
+    value->link.up = config;
   } else {
     t3_config_t *ptr = config->value.list;
     while (ptr->next != NULL) {
       ptr = ptr->next;
     }
     ptr->next = value;
+    value->link.up = config->value.list;
   }
 
+  _t3_config_modified(config);
   return T3_ERR_SUCCESS;
 }
 
 int t3_config_set_list_type(t3_config_t *config, t3_config_type_t type) {
+  int error;
+
   if (config == NULL || (config->type != T3_CONFIG_LIST && config->type != T3_CONFIG_PLIST) ||
       (type != T3_CONFIG_LIST && type != T3_CONFIG_PLIST)) {
     return T3_ERR_BAD_ARG;
   }
+  if ((config = _t3_config_writable(config, &error)) == NULL) {
+    return error;
+  }
   config->type = type;
+  _t3_config_modified(config);
   return T3_ERR_SUCCESS;
 }
 
 t3_config_t *t3_config_get(const t3_config_t *config, const char *name) {
   t3_config_t *result;
+  uint32_t hash;
   if (config == NULL ||
       (config->type != T3_CONFIG_SECTION && config->type != T3_CONFIG_LIST &&
        config->type != T3_CONFIG_PLIST && (int)config->type != T3_CONFIG_SCHEMA)) {
@@ -425,12 +1001,17 @@ t3_config_t *t3_config_get(const t3_config_t *config, const char *name) {
   if (name == NULL) {
     return config->value.list;
   }
+  if ((config->flags & T3_CONFIG_FROZEN) && config->value.list != NULL) {
+    return _t3_config_frozen_get(config, name);
+  }
 
-  result = config->value.list;
-  while (result != NULL && strcmp(result->name, name) != 0) {
-    result = result->next;
+  hash = _t3_config_hash_string(name, strlen(name));
+  for (result = config->value.list; result != NULL; result = result->next) {
+    if (name_matches(result->name, name, hash)) {
+      return result;
+    }
   }
-  return result;
+  return NULL;
 }
 
 t3_config_type_t t3_config_get_type(const t3_config_t *config) {
@@ -458,7 +1039,6 @@ GET(bool, t3_bool, T3_CONFIG_BOOL, boolean, t3_false)
 GET(int, t3_config_int_t, T3_CONFIG_INT, integer, 0)
 GET(int64, int64_t, T3_CONFIG_INT, integer, 0)
 GET(number, double, T3_CONFIG_NUMBER, number, 0.0)
-GET(string, const char *, T3_CONFIG_STRING, string, NULL)
 
 #define GET_DFLT(name_type, arg_type, TYPE, value_name)                                 \
   arg_type t3_config_get_##name_type##_dflt(const t3_config_t *config, arg_type dflt) { \
@@ -469,18 +1049,36 @@ GET_DFLT(bool, t3_bool, T3_CONFIG_BOOL, boolean)
 GET_DFLT(int, t3_config_int_t, T3_CONFIG_INT, integer)
 GET_DFLT(int64, int64_t, T3_CONFIG_INT, integer)
 GET_DFLT(number, double, T3_CONFIG_NUMBER, number)
-GET_DFLT(string, const char *, T3_CONFIG_STRING, string)
+
+const char *t3_config_get_string(const t3_config_t *config) {
+  return t3_config_get_string_dflt(config, NULL);
+}
+
+const char *t3_config_get_string_dflt(const t3_config_t *config, const char *dflt) {
+  return config != NULL && config->type == T3_CONFIG_STRING ? STRING_VALUE(config) : dflt;
+}
 
 char *t3_config_take_string(t3_config_t *config) {
   char *retval;
+  int error;
 
-  if (config == NULL || config->type != T3_CONFIG_STRING) {
+  if (config == NULL || config->type != T3_CONFIG_STRING ||
+      (config = _t3_config_writable(config, &error)) == NULL) {
     return NULL;
   }
 
-  retval = config->value.string;
+  if (config->flags & STRING_FLAGS) {
+    /* The caller will free the result, so it must be a plain copy. */
+    if ((retval = _t3_config_strdup(STRING_VALUE(config))) == NULL) {
+      return NULL;
+    }
+    _t3_config_free_string_value(config);
+  } else {
+    retval = config->value.string;
+  }
   config->value.string = NULL;
   config->type = T3_CONFIG_NONE;
+  _t3_config_modified(config);
   return retval;
 }
 
@@ -494,6 +1092,9 @@ int t3_config_get_length(const t3_config_t *config) {
                          config->type != T3_CONFIG_PLIST)) {
     return 0;
   }
+  if (config->flags & T3_CONFIG_FROZEN) {
+    return _t3_config_frozen_length(config);
+  }
   for (config = config->value.list; config != NULL; config = config->next, count++) {
   }
   return count;
@@ -549,6 +1150,12 @@ const char *t3_config_strerror(int error) {
       return _("recursive type definition");
     case T3_ERR_RECURSIVE_INCLUDE:
       return _("recursive include");
+    case T3_ERR_INVALID_IMAGE:
+      return _("invalid or incompatible config image");
+    case T3_ERR_MISSING_KEY:
+      return _("required key is missing");
+    case T3_ERR_TOO_MANY_FILES:
+      return _("too many distinct files read");
   }
 }
 
@@ -557,5 +1164,5 @@ int t3_config_get_line_number(const t3_config_t *config) {
 }
 
 const char *t3_config_get_file_name(const t3_config_t *config) {
-  return config != NULL && config->file_name != NULL ? config->file_name->file_name : NULL;
+  return config == NULL ? NULL : _t3_config_file_name(config->file_index);
 }
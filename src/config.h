@@ -73,6 +73,58 @@ typedef struct t3_config_t t3_config_t;
 */
 typedef struct t3_config_schema_t t3_config_schema_t;
 
+/** @struct t3_config_overlay_t
+    An opaque struct representing a stack of configs, viewed as a single config.
+*/
+typedef struct t3_config_overlay_t t3_config_overlay_t;
+
+/** @struct t3_config_path_t
+    An opaque struct representing a compiled path, see ::t3_config_path_compile.
+*/
+typedef struct t3_config_path_t t3_config_path_t;
+
+/** @struct t3_config_lookup_t
+    An opaque struct representing a compiled path with a cached result, see
+    ::t3_config_lookup_new.
+*/
+typedef struct t3_config_lookup_t t3_config_lookup_t;
+
+/** @struct t3_config_index_t
+    An opaque struct representing an index of the items in a list, see ::t3_config_index_by.
+*/
+typedef struct t3_config_index_t t3_config_index_t;
+
+/** @struct t3_config_query_t
+    An opaque struct representing a compiled query, see ::t3_config_query_compile.
+*/
+typedef struct t3_config_query_t t3_config_query_t;
+
+/** @struct t3_config_expr_t
+    An opaque struct representing a compiled expression, see ::t3_config_expr_compile.
+*/
+typedef struct t3_config_expr_t t3_config_expr_t;
+
+/** Statistics about reading a config or schema. See ::T3_CONFIG_STATS.
+
+    Times are in seconds. The time spent reading included files is counted as
+    lexing time, except for opening and closing them, which is counted as
+    include time. To keep the overhead low, the lexing time is estimated by
+    timing only a sample of the tokens, so it is not accurate for small
+    inputs.
+*/
+typedef struct {
+  size_t bytes_scanned;   /**< Number of bytes read, including included files. */
+  size_t tokens;          /**< Number of tokens read, including included files. */
+  size_t items;           /**< Number of items created. */
+  int includes;           /**< Number of included files. */
+  int max_depth;          /**< Maximum nesting depth of sections and lists in the result. */
+  double lex_time;        /**< Time spent splitting the input into tokens. */
+  double parse_time;      /**< Time spent parsing the tokens and building the config. */
+  double include_time;    /**< Time spent opening and closing included files. */
+  double constraint_time; /**< Time spent parsing the constraints of a schema. */
+  double validation_time; /**< Time spent checking a schema against the rules for schemas. */
+} t3_config_stats_t;
+
 /** Options struct used when reading a file. */
 typedef struct {
   int flags; /**< Set of flags, or @c 0 for defaults. */
@@ -91,6 +143,8 @@ typedef struct {
       void *data;                /**< Data passed to the callback function. */
     } user;
   } include_callback;
+  /** Location to store statistics about the read. Only used if ::T3_CONFIG_STATS is set. */
+  t3_config_stats_t *stats;
 } t3_config_opts_t;
 
 /** @name Flags for ::t3_config_opts_t. */
@@ -107,6 +161,12 @@ typedef struct {
 #define T3_CONFIG_INCLUDE_USER (1 << 2)
 /** Return the file name where the error occured in the ::t3_config_error_t struct. */
 #define T3_CONFIG_ERROR_FILE_NAME (1 << 3)
+/** Share identical string values and identical sub-configs after reading.
+    See ::t3_config_dedup for details. This flag is ignored when reading a schema. */
+#define T3_CONFIG_DEDUP (1 << 4)
+/** Store statistics about the read in the ::t3_config_stats_t pointed to by the @c stats member
+    of the ::t3_config_opts_t. The statistics are only collected when this flag is set. */
+#define T3_CONFIG_STATS (1 << 5)
 /*@}*/
 
 /** A structure representing an error, with line number.
@@ -144,6 +204,12 @@ typedef struct {
 #define T3_ERR_RECURSIVE_TYPE (-73)
 /** Error code: An included file includes itself, either directly or indirectly. */
 #define T3_ERR_RECURSIVE_INCLUDE (-72)
+/** Error code: The config image is damaged, or was created on an incompatible machine. */
+#define T3_ERR_INVALID_IMAGE (-71)
+/** Error code: A required key does not exist. */
+#define T3_ERR_MISSING_KEY (-70)
+/** Error code: The maximum number of distinct file names (65535) has been reached. */
+#define T3_ERR_TOO_MANY_FILES (-69)
 /*@}*/
 
 #if INT_MAX < 2147483647
@@ -158,6 +224,36 @@ typedef int t3_config_int_t;
 #define T3_CONFIG_INT_PRI ""
 #endif
 
+/** Functions used to allocate memory. See ::t3_config_set_allocator. */
+typedef struct {
+  /** Allocate @p size bytes, or return @c NULL if memory is exhausted. */
+  void *(*allocate)(size_t size, void *data);
+  /** Resize the memory pointed to by @p ptr to @p size bytes, like @c realloc. */
+  void *(*reallocate)(void *ptr, size_t size, void *data);
+  /** Release the memory pointed to by @p ptr. Never called with a @c NULL pointer. */
+  void (*release)(void *ptr, void *data);
+  void *data; /**< Passed to each of the functions. */
+} t3_config_allocator_t;
+
+/** Set the functions used by libt3config to allocate memory.
+    @param allocator The functions to use, or @c NULL to use @c malloc, @c realloc and @c free.
+
+    The allocator is used for all memory allocated by the library, including
+    memory returned to the caller, such as the result of ::t3_config_take_string
+    and the @c extra and @c file_name members of ::t3_config_error_t. Such memory
+    must be released through the allocator as well. Memory allocated through one
+    allocator can not be released through another, so the allocator must be set
+    before any configs, schemas or overlays are created, and can only be changed
+    when all of them have been deleted. The only exception are the file names
+    returned by ::t3_config_get_file_name, which are kept until the program exits
+    and are always allocated with @c malloc.
+
+    The allocator is global, rather than set per read through ::t3_config_opts_t,
+    because items may be moved between configs and are released without knowing
+    which config they were read as part of.
+*/
+T3_CONFIG_API void t3_config_set_allocator(const t3_config_allocator_t *allocator);
+
 /** Create a new config.
     @return A pointer to the new config or @c NULL if out of memory.
     Each config is a section. This function creates an empty section.
@@ -194,9 +290,173 @@ T3_CONFIG_API int t3_config_write_file(t3_config_t *config, FILE *file);
 */
 T3_CONFIG_API void t3_config_delete(t3_config_t *config);
 
-/** Unlink an item from a (sub-)config. */
+/** Create a copy of a (sub-)config.
+    @param config The (sub-)config to copy.
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return A pointer to the copy, or @c NULL on error.
+
+    The copy is made in constant time: the items in @p config are shared
+    between @p config and the copy until either of them is modified, at which
+    point only the items on the path to the modification are copied. The
+    shared items belong to @p config: modifying an item retrieved with
+    ::t3_config_get from @p config copies the path to it first, leaving the
+    copy unchanged. As the copy retrieves the same items, its deeper items must
+    be retrieved together with their parents using ::t3_config_get_mutable
+    before they are modified. Once @p config has been modified or deleted, the
+    items it no longer uses belong to no config, and the functions modifying
+    them directly fail with ::T3_ERR_BAD_ARG or return @c NULL.
+
+    The reference counts of the shared items are updated atomically, such that
+    the copies can be used and deleted from different threads, as long as each
+    copy is used by a single thread at a time. Shared items are never written,
+    not even to cache hashes. Without the GCC atomic builtins, copies must only
+    be used from a single thread. Copies of a schema can not be made. Copies of
+    a config created with ::t3_config_freeze do not share data, and can be
+    modified.
+*/
+T3_CONFIG_API t3_config_t *t3_config_clone(const t3_config_t *config, int *error);
+
+/** Create a read-only copy of a (sub-)config, optimized for lookups.
+    @param config The (sub-)config to copy.
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return A pointer to the frozen copy, or @c NULL on error.
+
+    The frozen copy is stored in a single block of memory, with the items of
+    each section or list stored consecutively. Items in large sections are
+    found through a perfect hash table rather than by comparing names one by
+    one. @p config is not modified, and can be deleted if it is no longer
+    needed.
+
+    All functions that retrieve data work on the frozen copy, but functions
+    that modify it fail. The frozen copy is released as a whole by passing the
+    result of this function to ::t3_config_delete; calling
+    ::t3_config_delete for any other item in it has no effect. Use
+    ::t3_config_clone to create a modifiable copy of a frozen config.
+*/
+T3_CONFIG_API t3_config_t *t3_config_freeze(const t3_config_t *config, int *error);
+
+/** Write a (sub-)config to a @c FILE as a binary image.
+    @param config The (sub-)config to write.
+    @param file The @c FILE to write to.
+    @retval ::T3_ERR_SUCCESS on success.
+    @retval ::T3_ERR_BAD_ARG if @p config or @p file is @c NULL, or @p config is a schema.
+    @retval ::T3_ERR_OUT_OF_MEMORY if memory is exhausted.
+    @retval ::T3_ERR_ERRNO if writing failed.
+
+    The image contains a frozen copy of @p config (see ::t3_config_freeze),
+    which can be loaded with ::t3_config_read_image without parsing. The
+    image can only be loaded on machines with the same byte order and type
+    sizes as the machine it was written on, and by the same version of the
+    library.
+*/
+T3_CONFIG_API int t3_config_write_image(const t3_config_t *config, FILE *file);
+/** Read a binary image written by ::t3_config_write_image from a @c FILE.
+    @param file The @c FILE to read from.
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return A pointer to the frozen config, or @c NULL on error.
+
+    The result is a frozen config, just like the result of
+    ::t3_config_freeze. The image is checked for consistency before it is
+    used, and ::T3_ERR_INVALID_IMAGE is returned if it is damaged or was
+    written on an incompatible machine. The names of the files stored in the
+    image are added to the file name table (see ::t3_config_get_file_name),
+    which fails with ::T3_ERR_TOO_MANY_FILES if the table is full.
+*/
+T3_CONFIG_API t3_config_t *t3_config_read_image(FILE *file, int *error);
+/** Read a binary image written by ::t3_config_write_image from memory.
+    @param buffer The buffer containing the image.
+    @param size The size of the buffer.
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return A pointer to the frozen config, or @c NULL on error.
+
+    See ::t3_config_read_image. The buffer is copied, and can be released
+    after this call.
+*/
+T3_CONFIG_API t3_config_t *t3_config_read_image_buffer(const void *buffer, size_t size,
+                                                       int *error);
+
+/** Use a binary image written by ::t3_config_write_image in place.
+    @param image The image, aligned to 8 bytes.
+    @param size The size of the image.
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return A pointer to the frozen config, or @c NULL on error.
+
+    This function is intended for images that are compiled into a program, for
+    example using the C source output of t3config-compile. The image is
+    checked and converted in place on the first call, and subsequent calls
+    return the same config. Because of this, the image can not be stored in
+    read-only memory, and it must not be modified or used with any other
+    function after it has been passed to this function. Concurrent calls for
+    the same image are safe.
+
+    The only memory allocated is for adding the names of the files stored in
+    the image to the file name table (see ::t3_config_get_file_name). This
+    happens before the image is converted, so if it fails with
+    ::T3_ERR_OUT_OF_MEMORY or ::T3_ERR_TOO_MANY_FILES, the image is left
+    unchanged and the call can be repeated.
+
+    The result can be used like the result of ::t3_config_freeze, except that
+    it is never released: passing it to ::t3_config_delete has no effect. The
+    names of its files therefore also remain in the file name table.
+*/
+T3_CONFIG_API t3_config_t *t3_config_load_static(void *image, size_t size, int *error);
+
+/** Share identical string values and identical parts of a (sub-)config.
+    @param config The (sub-)config to deduplicate.
+    @retval ::T3_ERR_SUCCESS on success.
+    @retval ::T3_ERR_BAD_ARG if @p config is @c NULL, a schema, or can not be modified (see
+        ::t3_config_clone).
+    @retval ::T3_ERR_OUT_OF_MEMORY if memory is exhausted. @p config may then be partially
+        deduplicated, but still has the same contents.
+
+    All string values with the same contents are replaced by a single shared
+    copy. Sections and lists which contain no sections or lists themselves,
+    and whose items have the same names, values, file names and line numbers,
+    are replaced by a single copy, shared in the same way as by
+    ::t3_config_clone. This is typically the case for the contents of a file
+    included more than once. Adding items to or removing items from a section
+    or list sharing its items copies them first, such that the others are not
+    affected. The shared items themselves, which are never sections or lists,
+    must be retrieved with ::t3_config_get_mutable before their values can be
+    taken with ::t3_config_take_string. Lists which are already shared with
+    other configs are left as they are. Items retrieved from @p config before
+    this call may have been released, and must be retrieved again.
+*/
+T3_CONFIG_API int t3_config_dedup(t3_config_t *config);
+
+/** Memory used by a (sub-)config or schema. See ::t3_config_memory_usage. */
+typedef struct {
+  size_t items;            /**< Number of items. */
+  size_t item_bytes;       /**< Bytes used by the items themselves. */
+  size_t name_bytes;       /**< Bytes used by item names. */
+  size_t string_bytes;     /**< Bytes used by string values not stored in the items. */
+  size_t expression_bytes; /**< Bytes used by the constraint expressions of a schema. */
+  size_t index_bytes;      /**< Bytes used by the lookup indices of a frozen config. */
+  size_t total_bytes;      /**< Sum of all of the above byte counts. */
+} t3_config_memory_t;
+
+/** Determine the memory used by a (sub-)config.
+    @param config The (sub-)config to measure.
+    @param usage Location to store the result.
+    @retval ::T3_ERR_SUCCESS on success.
+    @retval ::T3_ERR_BAD_ARG if @p config or @p usage is @c NULL.
+    @retval ::T3_ERR_OUT_OF_MEMORY if memory is exhausted.
+
+    Names, strings and lists of items that are shared, for example through
+    ::t3_config_clone or ::t3_config_dedup, are counted once, even if they
+    occur more than once in @p config. They are counted in full even if they
+    are also used by other configs. The counts are the sizes requested from
+    the allocator, and do not include the allocator's own overhead. Short
+    strings are stored in the items, and do not add to @c string_bytes.
+*/
+T3_CONFIG_API int t3_config_memory_usage(const t3_config_t *config, t3_config_memory_t *usage);
+
+/** Unlink an item from a (sub-)config.
+    Returns @c NULL if the item does not exist, or @p config can not be modified because it is
+    frozen or belongs to no config (see ::t3_config_clone). */
 T3_CONFIG_API t3_config_t *t3_config_unlink(t3_config_t *config, const char *name);
-/** Unlink an item from a (sub-)config or list. */
+/** Unlink an item from a (sub-)config or list.
+    See ::t3_config_unlink for details. */
 T3_CONFIG_API t3_config_t *t3_config_unlink_from_list(t3_config_t *list, t3_config_t *item);
 /** Erase an item from a (sub-)config.
     All memory related to the item and all sub-items is released. */
@@ -210,7 +470,9 @@ T3_CONFIG_API void t3_config_erase_from_list(t3_config_t *list, t3_config_t *ite
     @param name The name under which to add the item, or @c NULL if adding to a list.
     @param value The value to add.
     @retval ::T3_ERR_SUCCESS on successful addition.
-    @retval ::T3_ERR_BAD_ARG if @p config is not a list or section, or name is not set correctly.
+    @retval ::T3_ERR_BAD_ARG if @p config is not a list or section, name is not set correctly, or
+        @p config can not be modified because it is frozen or belongs to no config (see
+        ::t3_config_clone).
     @retval ::T3_ERR_OUT_OF_MEMORY .
 
     If an item with the given name already exists, it is replaced by the new
@@ -263,11 +525,109 @@ T3_CONFIG_API t3_config_t *t3_config_add_section(t3_config_t *config, const char
     The primary use of this function is to add complete sections created
     earlier from some source, or unlinked from elsewhere in the configuration.
     This should @b not be used to link the same configuration into the tree
-    multiple times.
+    multiple times. @p value must not be part of another (sub-)config.
 
     See ::t3_config_add_bool for details.
 */
 T3_CONFIG_API int t3_config_add_existing(t3_config_t *config, const char *name, t3_config_t *value);
+/** @name Flags for ::t3_config_merge. */
+/*@{*/
+/** Keep the existing value when both configs define a key, instead of using the new value. */
+#define T3_CONFIG_MERGE_KEEP_EXISTING (1 << 0)
+/** Treat sections like other values, instead of merging their contents. */
+#define T3_CONFIG_MERGE_REPLACE_SECTIONS (1 << 1)
+/** Append the items of lists to the existing list, instead of replacing the list. */
+#define T3_CONFIG_MERGE_APPEND_LISTS (1 << 2)
+/** Replace plists, instead of appending their items to the existing plist. */
+#define T3_CONFIG_MERGE_REPLACE_PLISTS (1 << 3)
+/*@}*/
+
+/** Merge a (sub-)config into another (sub-)config.
+    @param dest The (sub-)config to merge into.
+    @param src The (sub-)config to merge. This must not be part of another config.
+    @param flags A set of flags influencing the behaviour, or @c 0 for defaults.
+    @retval ::T3_ERR_SUCCESS on success.
+    @retval ::T3_ERR_BAD_ARG if @p dest and @p src are not both sections, lists or plists, or if
+        @p dest can not be modified (see ::t3_config_clone).
+    @retval ::T3_ERR_OUT_OF_MEMORY .
+
+    The items in @p src are moved into @p dest, rather than copied, and @p src
+    is deleted. This also happens if ::T3_ERR_OUT_OF_MEMORY is returned, in which
+    case @p dest may be partially merged. By default, values in @p src replace
+    values with the same name in @p dest, sections with the same name are merged
+    recursively, lists are replaced and the items of plists are appended to the
+    existing plist. The flags ::T3_CONFIG_MERGE_KEEP_EXISTING,
+    ::T3_CONFIG_MERGE_REPLACE_SECTIONS, ::T3_CONFIG_MERGE_APPEND_LISTS and
+    ::T3_CONFIG_MERGE_REPLACE_PLISTS change this behaviour.
+
+    The time taken is linear in the combined size of @p dest and @p src.
+*/
+T3_CONFIG_API int t3_config_merge(t3_config_t *dest, t3_config_t *src, int flags);
+/** Compute a hash of the contents of a (sub-)config.
+    @param config The (sub-)config to hash.
+    @return A 64-bit hash of the type and value of @p config, including the
+        names and values of all items in it.
+
+    The name of @p config itself is not included, such that items with equal
+    values hash equally regardless of their names. The order of the items in a
+    section does not influence the hash, while the order of the items in a list
+    does. Hashes are stable: the same contents hash to the same value across
+    runs and platforms.
+
+    This function does not modify @p config, so it may be called from
+    different threads for the same (sub-)config. The time taken is linear in
+    the size of @p config, except for frozen configs, which store the hashes of
+    all sections and lists when they are created (see ::t3_config_freeze).
+    Schemas can not be hashed.
+*/
+T3_CONFIG_API uint64_t t3_config_hash(const t3_config_t *config);
+/** Check whether two (sub-)configs have the same contents.
+    @param a The first (sub-)config to compare.
+    @param b The second (sub-)config to compare.
+    @return ::t3_true if @p a and @p b have the same type and value.
+
+    Like ::t3_config_hash, this ignores the names of @p a and @p b themselves,
+    the order of the items in sections, and the file names and line numbers of
+    all items. Items which are shared through ::t3_config_clone are not
+    compared, and hashes cached by ::t3_config_hash are used to detect
+    differences early. If ::t3_config_equal returns ::t3_true, then
+    ::t3_config_hash returns the same value for both.
+*/
+T3_CONFIG_API t3_bool t3_config_equal(const t3_config_t *a, const t3_config_t *b);
+/** Compute the changes required to transform one config into another.
+    @param old_config The original config.
+    @param new_config The modified config.
+    @param error Location to store an error code, or @c NULL.
+    @return A section describing the changes, or @c NULL on error.
+
+    Both @p old_config and @p new_config must be sections. The result is a
+    section containing a single list named @c changes. Each item in that list
+    is a section describing a single change, with the following items:
+    - @c op: one of @c "add", @c "remove" or @c "change".
+    - @c path: the slash-separated path of the item, relative to @p old_config.
+    - @c value: the new value of the item. Not present for @c "remove".
+
+    Sections present in both configs are compared recursively; all other
+    values, including lists, are compared as a whole. Sub-configs which are
+    shared because they were copied with ::t3_config_clone are skipped without
+    comparing their contents, which makes comparing a config with a modified
+    copy of itself cheap. The result can be written to a file with
+    ::t3_config_write_file, and applied with ::t3_config_apply_patch.
+*/
+T3_CONFIG_API t3_config_t *t3_config_diff(const t3_config_t *old_config,
+                                          const t3_config_t *new_config, int *error);
+/** Apply a list of changes as produced by ::t3_config_diff.
+    @param config The config to change.
+    @param patch The changes, in the format returned by ::t3_config_diff.
+    @return An error code.
+
+    Changed items keep their position in their section, while added items are
+    appended. If @p patch is malformed, a path can not be resolved, or @p config
+    can not be modified (see ::t3_config_clone), ::T3_ERR_BAD_ARG is returned. In
+    that case the changes preceding the offending change have already been
+    applied to @p config.
+*/
+T3_CONFIG_API int t3_config_apply_patch(t3_config_t *config, const t3_config_t *patch);
 /** Set the type of list of an existing list-type (sub-)config. */
 T3_CONFIG_API int t3_config_set_list_type(t3_config_t *config, t3_config_type_t type);
 
@@ -282,6 +642,22 @@ T3_CONFIG_API int t3_config_set_list_type(t3_config_t *config, t3_config_type_t
     use ::t3_config_get_next to retrieve further items.
 */
 T3_CONFIG_API t3_config_t *t3_config_get(const t3_config_t *config, const char *name);
+/** Retrieve a sub-config for modification.
+    @param config The (sub-)config to retrieve from.
+    @param name The name of the sub-config to retrieve, or @c NULL for the first sub-config.
+    @return The requested sub-config, or @c NULL if no sub-config exists with the given name, if
+        @p config can not be modified, or if there is insufficient memory.
+
+    This function is equivalent to ::t3_config_get, except that it ensures that
+    the items in @p config are no longer shared with a copy made by
+    ::t3_config_clone. The returned sub-config, and all items following it, may
+    then be modified without affecting other configs. @p config itself must
+    either be the top-level config or have been retrieved using this function.
+    This is only required to modify the items of a copy made by
+    ::t3_config_clone, as the other functions modifying items copy shared items
+    on behalf of the config they belong to.
+*/
+T3_CONFIG_API t3_config_t *t3_config_get_mutable(t3_config_t *config, const char *name);
 /** Get the type of a (sub-)config.
     See ::t3_config_type_t for possible types.
 */
@@ -354,8 +730,10 @@ T3_CONFIG_API double t3_config_get_number_dflt(const t3_config_t *config, double
 T3_CONFIG_API const char *t3_config_get_string_dflt(const t3_config_t *config, const char *dflt);
 
 /** Take ownership of the string value from a config with ::T3_CONFIG_STRING type.
-    @return The string value of @p config, or @c NULL if @p config is @c NULL or not of type
-    ::T3_CONFIG_STRING.
+    @return The string value of @p config, or @c NULL if @p config is @c NULL, not of type
+    ::T3_CONFIG_STRING or can not be modified (see ::t3_config_clone). Short strings and strings
+    shared with other items are copied, so @c NULL is also returned if memory is exhausted, in
+    which case @p config is not modified.
 
     After calling this function, the type of the config will be set to ::T3_CONFIG_NONE.
 */
@@ -400,6 +778,256 @@ T3_CONFIG_API t3_config_t *t3_config_find(const t3_config_t *config,
                                           t3_bool (*predicate)(const t3_config_t *, const void *),
                                           const void *data, t3_config_t *start_from);
 
+/** Compile a path for use with ::t3_config_get_path.
+    @param path The path to compile, with the names separated by slashes (for example
+        @c "server/limits/connections"). A name may be followed by one or more list indices in
+        brackets, such as @c "backends[2]/host". A leading slash is allowed, and the empty path
+        refers to the config itself.
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return A pointer to the compiled path, or @c NULL on error.
+
+    The path is split into its names and indices, and the hash values of the names are
+    computed, such that lookups only need to compare them. Errors are ::T3_ERR_PARSE_ERROR if
+    @p path is malformed, ::T3_ERR_OUT_OF_RANGE if an index is too large, ::T3_ERR_BAD_ARG if
+    @p path is @c NULL, and ::T3_ERR_OUT_OF_MEMORY.
+*/
+T3_CONFIG_API t3_config_path_t *t3_config_path_compile(const char *path, int *error);
+/** Free all memory used by a compiled path. */
+T3_CONFIG_API void t3_config_path_delete(t3_config_path_t *path);
+/** Retrieve a sub-config using a compiled path.
+    @param config The config to start the lookup from.
+    @param path The path to look up, as returned by ::t3_config_path_compile.
+    @return The sub-config at @p path, or @c NULL if it does not exist.
+
+    This is equivalent to a chain of ::t3_config_get calls, and to
+    ::t3_config_get_next calls for the list indices, but avoids computing the
+    hash values of the names for each lookup. Frozen configs (see
+    ::t3_config_freeze) are searched using their hash tables, and their list
+    items are indexed directly. A compiled path can be used with any number of
+    configs, and from multiple threads at the same time.
+*/
+T3_CONFIG_API t3_config_t *t3_config_get_path(const t3_config_t *config,
+                                              const t3_config_path_t *path);
+
+/** Create a lookup handle, which caches the result of looking up a path.
+    @param path The path to look up, in the format accepted by ::t3_config_path_compile.
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return A pointer to the lookup handle, or @c NULL on error.
+*/
+T3_CONFIG_API t3_config_lookup_t *t3_config_lookup_new(const char *path, int *error);
+/** Free all memory used by a lookup handle. */
+T3_CONFIG_API void t3_config_lookup_delete(t3_config_lookup_t *lookup);
+/** Retrieve a sub-config using a lookup handle.
+    @param lookup The lookup handle, as returned by ::t3_config_lookup_new.
+    @param config The config to start the lookup from.
+    @return The sub-config at the path of @p lookup, or @c NULL if it does not exist.
+
+    The result is cached in @p lookup, together with @p config and the
+    generation of the top-level config containing @p config, which changes
+    whenever any item in that config is modified. As long as @p config and
+    the generation are unchanged, the cached result is returned without
+    searching. Otherwise the path is looked up again, as with
+    ::t3_config_get_path. Modifications of other configs do not cause the path
+    to be looked up again. Results are not cached for items shared by copies
+    made with ::t3_config_clone once the original config has been deleted, as
+    the config containing them is then not known.
+
+    As @p lookup is updated, it must not be used by multiple threads at the
+    same time. Use a separate handle for each thread instead.
+*/
+T3_CONFIG_API t3_config_t *t3_config_lookup(t3_config_lookup_t *lookup, const t3_config_t *config);
+
+/** Create an index of the items in a list, keyed by the value of a key in each item.
+    @param list The list to index. This must be a list or plist, usually of sections.
+    @param key The name of the key whose value identifies an item, for example @c "name".
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return A pointer to the index, or @c NULL on error.
+
+    Only items which contain @p key with a string or integer value are indexed.
+    If multiple items have the same value, the first one is found. The index
+    refers to @p list, which must not be deleted while the index is in use.
+    It may however be modified: the index is rebuilt on the next lookup after
+    any item in the top-level config containing @p list was modified.
+    Modifications of other configs do not cause a rebuild.
+*/
+T3_CONFIG_API t3_config_index_t *t3_config_index_by(const t3_config_t *list, const char *key,
+                                                    int *error);
+/** Free all memory used by an index. The list is not deleted. */
+T3_CONFIG_API void t3_config_index_delete(t3_config_index_t *index);
+/** Find the item in an index with a string value.
+    @param index The index to search, as returned by ::t3_config_index_by.
+    @param value The string value to find.
+    @return The first item in the list whose key has the value @p value, or @c NULL if there is
+        none.
+
+    As @p index is rebuilt when a config was modified, it must not be used by
+    multiple threads at the same time.
+*/
+T3_CONFIG_API t3_config_t *t3_config_index_get(t3_config_index_t *index, const char *value);
+/** Find the item in an index with an integer value. See ::t3_config_index_get. */
+T3_CONFIG_API t3_config_t *t3_config_index_get_int(t3_config_index_t *index, int64_t value);
+
+/** Compile a query, which selects items from a config.
+    @param query The query to compile.
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return A pointer to the compiled query, or @c NULL on error.
+
+    A query is a path (see ::t3_config_path_compile) in which each step is
+    either a name or @c *, which selects all items of a section or list. Each
+    step can be followed by selectors in brackets. A selector consisting of
+    digits selects the item with that index from a list. Any other selector is
+    a filter: an expression in the syntax of schema constraints, which must
+    hold for the selected item. In the expression, names refer to keys in the
+    selected item, @c % refers to the item itself, and paths starting with a
+    slash are taken from the config passed to ::t3_config_query_run. For
+    example, @c "*[weight > 10]" selects the items of the config which contain
+    a key @c weight with an integer value larger than 10.
+
+    Errors are ::T3_ERR_PARSE_ERROR if @p query is malformed,
+    ::T3_ERR_OUT_OF_RANGE if an index is too large, ::T3_ERR_BAD_ARG if
+    @p query is @c NULL, and ::T3_ERR_OUT_OF_MEMORY.
+*/
+T3_CONFIG_API t3_config_query_t *t3_config_query_compile(const char *query, int *error);
+/** Free all memory used by a compiled query. */
+T3_CONFIG_API void t3_config_query_delete(t3_config_query_t *query);
+/** Run a compiled query.
+    @param query The query to run, as returned by ::t3_config_query_compile.
+    @param config The config to select items from.
+    @param callback The function to call for each selected item.
+    @param data A pointer to user data which will be passed as the second argument to @p callback.
+    @retval ::T3_ERR_SUCCESS on success.
+    @retval ::T3_ERR_BAD_ARG if any of @p query, @p config or @p callback is @c NULL.
+
+    Items are reported in the order in which they occur in @p config. Running a
+    query does not allocate memory, and a compiled query can be run from
+    multiple threads at the same time. The config must not be modified from
+    @p callback.
+*/
+T3_CONFIG_API int t3_config_query_run(const t3_config_query_t *query, const t3_config_t *config,
+                                      void (*callback)(const t3_config_t *item, void *data),
+                                      void *data);
+
+/** @name Binding flags */
+/*@{*/
+/** The key must exist: ::t3_config_bind reports ::T3_ERR_MISSING_KEY instead of storing the
+    default value if it does not. */
+#define T3_CONFIG_BIND_REQUIRED (1 << 0)
+/*@}*/
+
+/** Description of a single struct member to fill with ::t3_config_bind. */
+typedef struct {
+  /** The path of the value, with the names separated by slashes (for example
+      @c "server/limits/connections"). */
+  const char *path;
+  /** The type of the value. This also determines the type of the member: ::t3_bool for
+      ::T3_CONFIG_BOOL, @c int64_t for ::T3_CONFIG_INT, @c double for ::T3_CONFIG_NUMBER,
+      <tt>const char *</tt> for ::T3_CONFIG_STRING and <tt>const t3_config_t *</tt> for
+      ::T3_CONFIG_SECTION, ::T3_CONFIG_LIST and ::T3_CONFIG_PLIST. */
+  t3_config_type_t type;
+  /** The offset of the member in the struct, as returned by @c offsetof. */
+  size_t offset;
+  /** Flags, see ::T3_CONFIG_BIND_REQUIRED. */
+  int flags;
+  /** The value to store if the key does not exist. Only the member matching @c type is used.
+      For sections and lists, @c NULL is stored. */
+  union {
+    t3_bool boolean;
+    int64_t integer;
+    double number;
+    const char *string;
+  } dflt;
+} t3_config_binding_t;
+
+/** Fill the members of a struct with values from a config.
+    @param config The config to read from. This must be a section, usually a top-level config.
+    @param bindings The table describing the members to fill.
+    @param count The number of entries in @p bindings.
+    @param result A pointer to the struct to fill.
+    @param status An array of @p count elements in which the result for each entry of
+        @p bindings is stored, or @c NULL.
+    @retval ::T3_ERR_SUCCESS if all members were filled.
+    @retval ::T3_ERR_MISSING_KEY if a key marked ::T3_CONFIG_BIND_REQUIRED does not exist.
+    @retval ::T3_ERR_INVALID_KEY_TYPE if a key, or one of the sections on its path, has a
+        different type than its binding.
+    @retval ::T3_ERR_BAD_ARG if @p config is not a section, or a binding has an invalid path or
+        type.
+    @retval ::T3_ERR_OUT_OF_MEMORY .
+
+    Each section of @p config is traversed at most once, regardless of the number of bindings,
+    which makes this faster than looking up each value separately. A failing binding does not
+    stop the others from being filled: the return value is the error for the first failing entry
+    in @p bindings, while @p status receives the errors for all of them. Members for failing
+    entries are not modified. Integer values are accepted for ::T3_CONFIG_NUMBER bindings.
+
+    Strings, sections and lists stored in the struct point into @p config, and are only valid
+    as long as @p config is not modified or deleted. If ::T3_ERR_OUT_OF_MEMORY or
+    ::T3_ERR_BAD_ARG for one of the parameters is returned, @p result and @p status are not
+    modified.
+*/
+T3_CONFIG_API int t3_config_bind(const t3_config_t *config, const t3_config_binding_t *bindings,
+                                 size_t count, void *result, int *status);
+
+/** Create a new, empty, overlay.
+    @return A pointer to the new overlay or @c NULL if out of memory.
+
+    An overlay combines several configs (layers) into a single view without
+    copying them. Values in higher layers override those in lower layers, while
+    sections that occur in multiple layers are combined. Lists are not combined:
+    the list in the highest layer is used. The layers are not copied, and must
+    not be deleted or modified while the overlay is in use.
+*/
+T3_CONFIG_API t3_config_overlay_t *t3_config_overlay_new(void);
+/** Add a layer on top of all existing layers of an overlay.
+    @param overlay The overlay to add to.
+    @param layer The config to add. This must be a section, usually a top-level config.
+    @retval ::T3_ERR_SUCCESS on success.
+    @retval ::T3_ERR_BAD_ARG if @p layer is not a section.
+    @retval ::T3_ERR_OUT_OF_MEMORY .
+*/
+T3_CONFIG_API int t3_config_overlay_push(t3_config_overlay_t *overlay, const t3_config_t *layer);
+/** Free all memory used by an overlay. The layers are not deleted. */
+T3_CONFIG_API void t3_config_overlay_delete(t3_config_overlay_t *overlay);
+/** Retrieve a sub-config from an overlay.
+    @param overlay The overlay to retrieve from.
+    @param path The path of the sub-config, with the names separated by slashes (for example
+        @c "server/limits/connections"), or @c NULL for the top-level config in the highest
+        layer.
+    @return The sub-config from the highest layer that defines @p path, or @c NULL if none does.
+
+    If the returned sub-config is a section, only the items from that layer are
+    visible through it. To view the combined contents of a section, use
+    ::t3_config_overlay_iterate or look up the full path of its items.
+*/
+T3_CONFIG_API t3_config_t *t3_config_overlay_get(const t3_config_overlay_t *overlay,
+                                                 const char *path);
+/** Iterate over the items in a section or list in an overlay.
+    @param overlay The overlay to iterate over.
+    @param path The path of the section or list (see ::t3_config_overlay_get).
+    @param callback The function to call for each item.
+    @param data A pointer to user data which will be passed as the second argument to @p callback.
+    @retval ::T3_ERR_SUCCESS on success, or if @p path does not exist.
+    @retval ::T3_ERR_BAD_ARG if @p path does not refer to a section or list.
+    @retval ::T3_ERR_OUT_OF_MEMORY .
+
+    For sections, @p callback is called once for each key in the combined view,
+    with the item from the highest layer that defines it. Items from higher
+    layers are visited first.
+*/
+T3_CONFIG_API int t3_config_overlay_iterate(const t3_config_overlay_t *overlay, const char *path,
+                                            void (*callback)(const t3_config_t *item, void *data),
+                                            void *data);
+/** Create a config containing the combined view of an overlay.
+    @param overlay The overlay to flatten.
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return A pointer to the new config, or @c NULL on error.
+
+    The result does not share any items with the layers, such that the layers
+    are not modified and remain modifiable after the overlay is deleted. Items
+    that do not need to be combined are copied as a whole.
+*/
+T3_CONFIG_API t3_config_t *t3_config_overlay_flatten(const t3_config_overlay_t *overlay,
+                                                     int *error);
+
 /** Get the value of ::T3_CONFIG_VERSION corresponding to the actual used library.
     @return The value of ::T3_CONFIG_VERSION.
 
@@ -447,6 +1075,47 @@ T3_CONFIG_API t3_bool t3_config_validate(t3_config_t *config, const t3_config_sc
                                          t3_config_error_t *error, int flags);
 /** Free all memory used by @p schema. */
 T3_CONFIG_API void t3_config_delete_schema(t3_config_schema_t *schema);
+/** Determine the memory used by @p schema. See ::t3_config_memory_usage. */
+T3_CONFIG_API int t3_config_schema_memory_usage(const t3_config_schema_t *schema,
+                                                t3_config_memory_t *usage);
+
+/** Compile an expression, written in the syntax of schema constraints.
+    @param text The expression to compile, for example <tt>"enabled = yes & weight > 10"</tt>.
+    @param schema The schema to check the expression against, or @c NULL.
+    @param type The name of the type in @p schema describing the configs the expression will be
+        evaluated on, or @c NULL for the top level of @p schema.
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return A pointer to the compiled expression, or @c NULL on error.
+
+    If @p schema is given, the expression is checked in the same way as the
+    constraints in a schema: all names must be allowed keys, and compared
+    values must have compatible types. Otherwise any expression is accepted,
+    and comparisons involving missing keys or values of different types are
+    false when evaluated.
+
+    Errors are ::T3_ERR_PARSE_ERROR if @p text is malformed,
+    ::T3_ERR_INVALID_CONSTRAINT if the check against @p schema fails,
+    ::T3_ERR_BAD_ARG if @p text is @c NULL or @p type is not a section type
+    in @p schema, and ::T3_ERR_OUT_OF_MEMORY.
+*/
+T3_CONFIG_API t3_config_expr_t *t3_config_expr_compile(const char *text,
+                                                       const t3_config_schema_t *schema,
+                                                       const char *type, int *error);
+/** Evaluate a compiled expression.
+    @param expr The expression to evaluate, as returned by ::t3_config_expr_compile.
+    @param config The config to evaluate the expression on. Names in the expression refer to the
+        keys of @p config, and @c % refers to @p config itself.
+    @param root The config to which paths starting with a slash refer, or @c NULL to use
+        @p config.
+    @return ::t3_true if the expression holds, ::t3_false otherwise.
+
+    Evaluation does not allocate memory or modify @p expr, so a compiled
+    expression can be evaluated from multiple threads at the same time.
+*/
+T3_CONFIG_API t3_bool t3_config_expr_eval(const t3_config_expr_t *expr, const t3_config_t *config,
+                                          const t3_config_t *root);
+/** Free all memory used by a compiled expression. */
+T3_CONFIG_API void t3_config_expr_delete(t3_config_expr_t *expr);
 
 /** @name Flags for ::t3_config_open_from_path. */
 /*@{*/
@@ -476,7 +1145,16 @@ T3_CONFIG_API int t3_config_get_line_number(const t3_config_t *config);
 /** Get the file name in which the (sub-)configuration item was defined.
     This function will return @c NULL if it was not created in a file, or it
     was defined in the file/buffer passed to ::t3_config_read_file or
-    ::t3_config_read_buffer.
+    ::t3_config_read_buffer. The returned string remains valid as long as
+    @p config, or another item read from the same file, exists.
+
+    The file names are stored in a table shared by all configs, and a name is
+    removed when the last item read from the file is deleted. The table holds
+    at most 65535 distinct names at the same time. Reading a config that
+    includes a file which is not in the full table fails with
+    ::T3_ERR_TOO_MANY_FILES. Without the GCC atomic builtins, the table is not
+    protected by a lock, and configs which include files, or images containing
+    file names, must only be used from a single thread at a time.
 */
 T3_CONFIG_API const char *t3_config_get_file_name(const t3_config_t *config);
 
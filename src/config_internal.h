@@ -13,24 +13,72 @@
 */
 #ifndef T3_CONFIG_INTERNAL_H
 #define T3_CONFIG_INTERNAL_H
+#include <stddef.h>
+
 #include "config.h"
 
 #include "expression.h"
 
+/* Item names are stored in reference counted records, such that items can share a single copy,
+   and names can be compared by hash first. The name member of t3_config_t points to the str member
+   of the record. String values are stored the same way if T3_CONFIG_SHARED_STRING is set. */
 typedef struct {
-  char *file_name;
+  /* The number of references, or -1 if the record is not reference counted because it is part of
+     a larger block of memory. */
   int count;
-} file_name_t;
+  uint32_t hash, length;
+  char str[1];
+} shared_string_t;
+
+#define STRING_RECORD(s) ((shared_string_t *)((s)-offsetof(shared_string_t, str)))
+#define STRING_HASH(s) (STRING_RECORD(s)->hash)
+#define STRING_RECORD_SIZE(length) (offsetof(shared_string_t, str) + (length) + 1)
+
+/* Hash table of string records, used to share strings between the items of a config. */
+typedef struct {
+  char **strings;
+  size_t mask, count;
+} string_table_t;
 
+/* The fields are ordered such that the item contains no padding. Lists of items are linked through
+   next rather than stored in arrays, as items must stay at the same address when other items are
+   added or removed. For the same reason, unnamed items still have a name field: an item in a list
+   can be moved into a section with t3_config_add_existing, and would otherwise need to be moved.
+   Information which is only needed for some items is stored elsewhere, such that every item takes
+   40 bytes on 64-bit platforms: the hash of a frozen section or list is stored in its
+   frozen_index_t, and the number of owners of a list of items is only stored once the list is
+   shared, in a shared_list_t. */
 struct t3_config_t {
-  t3_config_type_t type;
+  /* A t3_config_type_t, stored in a single byte. */
+  unsigned char type;
+  /* Combination of T3_CONFIG_FROZEN, T3_CONFIG_FROZEN_ROOT, T3_CONFIG_SHARED_STRING,
+     T3_CONFIG_INLINE_STRING, T3_CONFIG_FIRST and T3_CONFIG_TOP_LEVEL. */
+  unsigned char flags;
+  /* The index of the file the item was read from in the file table, or 0 if unknown. See
+     _t3_config_intern_file_name. */
+  uint16_t file_index;
   int line_number;
+  union {
+    /* For the first item in a list (T3_CONFIG_FIRST is set): the section or list owning the list,
+       or, if the list is shared, a tagged pointer to its shared_list_t (see
+       shared_list in config.c). For other items in a list: the first item of the list. This allows
+       finding out whether any list on the path to an item is shared, without following pointers
+       which may refer to an owner that no longer exists. */
+    struct t3_config_t *up;
+    /* For top-level items (T3_CONFIG_TOP_LEVEL is set): changes whenever the item or any item
+       below it is modified, by taking a new value from a global counter (see
+       _t3_config_modified). New items also get a new value, such that an item allocated at the
+       address of a deleted item has a different generation. Cached lookups compare this to detect
+       changes, without being affected by modifications of other configs. */
+    uint64_t generation;
+  } link;
   struct t3_config_t *next;
   char *name;
-  file_name_t *file_name;
   union {
     const void *ptr; /* First member can be assigned. */
     char *string;
+    /* Short strings are stored in the item itself if T3_CONFIG_INLINE_STRING is set. */
+    char short_string[sizeof(int64_t)];
     int64_t integer;
     double number;
     struct t3_config_t *list;
@@ -41,6 +89,88 @@ struct t3_config_t {
 
 enum { T3_CONFIG_SCHEMA = 64, T3_CONFIG_EXPRESSION, T3_CONFIG_ANY };
 
+/* The item is part of a frozen config, and can not be modified. */
+#define T3_CONFIG_FROZEN (1 << 0)
+/* The item is the top-level item of a frozen config, and owns the memory of the config. */
+#define T3_CONFIG_FROZEN_ROOT (1 << 1)
+/* The string value of the item is a shared string record, rather than a plain allocated string. */
+#define T3_CONFIG_SHARED_STRING (1 << 2)
+/* The string value of the item is stored in value.short_string. */
+#define T3_CONFIG_INLINE_STRING (1 << 3)
+/* The item is the first item in a list of items, and link.up refers to the owner of the list. */
+#define T3_CONFIG_FIRST (1 << 4)
+/* The item is not part of a list of items, and link.generation is valid. */
+#define T3_CONFIG_TOP_LEVEL (1 << 5)
+
+/* Check whether @p config is not part of a list of items. */
+#define IS_TOP_LEVEL(config) (((config)->flags & T3_CONFIG_TOP_LEVEL) != 0)
+
+/* The owners of a list of items which is shared by several sections or lists. Shared lists must
+   be copied before they are modified, except by the original owner once the other owners have
+   released the list. Accessed atomically, as configs sharing items may be used from different
+   threads. Freed when the list is deleted, or when its last owner claims it. */
+typedef struct {
+  /* The original owner of the list, or NULL if it has released the list or if no section or list
+     owns the list (see _t3_config_disown_items). */
+  struct t3_config_t *owner;
+  /* The number of sections or lists other than the original owner that share the list. */
+  int count;
+} shared_list_t;
+
+/* The reference counts of shared lists and names, and the owners of shared lists, are accessed
+   atomically, such that configs sharing items can be used from different threads. Without
+   the GCC atomic builtins, such configs must only be used from a single thread. */
+#ifdef __GNUC__
+#define ATOMIC_LOAD(var) __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(var, value) __atomic_store_n(&(var), (value), __ATOMIC_RELEASE)
+#define ATOMIC_FETCH_ADD(var, value) __atomic_fetch_add(&(var), (value), __ATOMIC_ACQ_REL)
+/* Replace @p var by @p desired if it equals @p expected, which must be a variable. */
+#define ATOMIC_CAS(var, expected, desired)                                \
+  __atomic_compare_exchange_n(&(var), &(expected), (desired), 0, __ATOMIC_ACQ_REL, \
+                              __ATOMIC_ACQUIRE)
+#else
+#define ATOMIC_LOAD(var) (var)
+#define ATOMIC_STORE(var, value) ((var) = (value))
+#define ATOMIC_FETCH_ADD(var, value) (((var) += (value)) - (value))
+#define ATOMIC_CAS(var, expected, desired) \
+  ((var) == (expected) ? ((var) = (desired), t3_true) : ((expected) = (var), t3_false))
+#endif
+
+/* The string value of a T3_CONFIG_STRING item, wherever it is stored. */
+#define STRING_VALUE(config)                                                \
+  ((config)->flags & T3_CONFIG_INLINE_STRING ? (config)->value.short_string \
+                                             : (config)->value.string)
+/* Check whether a string of the given length, excluding the nul byte, fits in the item. */
+#define FITS_INLINE(length) ((length) < sizeof(((t3_config_t *)0)->value.short_string))
+
+T3_CONFIG_LOCAL t3_bool _t3_config_is_shared(const t3_config_t *first);
+T3_CONFIG_LOCAL int _t3_config_share_items(t3_config_t *first);
+T3_CONFIG_LOCAL void _t3_config_disown_items(t3_config_t *first);
+T3_CONFIG_LOCAL int _t3_config_unshare(t3_config_t *config);
+T3_CONFIG_LOCAL t3_config_t *_t3_config_writable(t3_config_t *config, int *error);
+T3_CONFIG_LOCAL void _t3_config_link_items(t3_config_t *owner);
+T3_CONFIG_LOCAL void _t3_config_move_items(t3_config_t *owner, const t3_config_t *old_owner);
+T3_CONFIG_LOCAL void _t3_config_delete_items(t3_config_t *owner);
+T3_CONFIG_LOCAL void _t3_config_replace_value(t3_config_t *dest, t3_config_t *src);
+T3_CONFIG_LOCAL void _t3_config_free_string_value(t3_config_t *config);
+T3_CONFIG_LOCAL void _t3_config_modified(t3_config_t *config);
+T3_CONFIG_LOCAL uint64_t _t3_config_new_generation(void);
+T3_CONFIG_LOCAL uint64_t _t3_config_generation(const t3_config_t *config);
+T3_CONFIG_LOCAL void _t3_config_make_top_level(t3_config_t *config);
+T3_CONFIG_LOCAL void _t3_config_delete_frozen(t3_config_t *config);
+T3_CONFIG_LOCAL t3_config_t *_t3_config_frozen_get(const t3_config_t *section, const char *name);
+T3_CONFIG_LOCAL t3_config_t *_t3_config_frozen_get_hashed(const t3_config_t *section,
+                                                          const char *name, uint64_t hash);
+T3_CONFIG_LOCAL t3_config_t *_t3_config_frozen_get_index(const t3_config_t *list, size_t index);
+T3_CONFIG_LOCAL int _t3_config_frozen_length(const t3_config_t *config);
+T3_CONFIG_LOCAL size_t _t3_config_frozen_index_size(const t3_config_t *config);
+T3_CONFIG_LOCAL t3_config_t *_t3_config_thaw(const t3_config_t *config, int *error);
+
+T3_CONFIG_LOCAL void _t3_config_string_table_init(string_table_t *table);
+T3_CONFIG_LOCAL char *_t3_config_intern_string(string_table_t *table, const char *str);
+T3_CONFIG_LOCAL void _t3_config_string_table_free(string_table_t *table);
+T3_CONFIG_LOCAL int _t3_config_dedup(t3_config_t *config, string_table_t *strings);
+
 #ifndef YY_TYPEDEF_YY_SCANNER_T
 #define YY_TYPEDEF_YY_SCANNER_T
 typedef void *yyscan_t;
@@ -66,6 +196,8 @@ typedef struct {
 
   t3_config_t *current_section; /* Used only for including files, to hold the current section. */
   t3_config_t *included;        /* Holds a list of included files (strings). */
+  string_table_t strings;       /* Names of the items read so far, for sharing. */
+  t3_config_stats_t *stats;     /* Statistics to update, or NULL if they were not requested. */
 } parse_context_t;
 
 T3_CONFIG_LOCAL char *_t3_config_get_text(yyscan_t scanner);
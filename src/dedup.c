@@ -0,0 +1,290 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_internal.h"
+#include "hash.h"
+#include "util.h"
+
+/* Deduplication works bottom-up. First all names and string values in a list of items are replaced
+   by shared string records, after which names and strings can be compared by pointer. Only lists
+   without sections or lists in them are shared: two such lists are identical if their items have
+   the same names, types, values and locations. If an identical list was seen before, the list is
+   replaced by the earlier one, which is shared in the same way as t3_config_clone shares lists.
+   Unlike a clone, no section or list sharing the list owns it. Modifying one of them copies the
+   list, or claims it once the others have done so, while the items in the list can only be
+   modified after t3_config_get_mutable has done that. As the sections and lists sharing a list are
+   not shared themselves, the path to them is always known. */
+
+typedef struct {
+  uint64_t hash;
+  t3_config_t *list;
+} chain_entry_t;
+
+typedef struct {
+  string_table_t *strings;
+  /* Hash table of the distinct lists of items seen so far. */
+  chain_entry_t *chains;
+  size_t chain_mask, chain_count;
+} dedup_context_t;
+
+static uint64_t combine(uint64_t hash, uint64_t value) {
+  return _t3_config_hash_mix(hash ^ (value + UINT64_C(0x9e3779b97f4a7c15) + (hash << 6)));
+}
+
+/** Hash the items in @p list, which have already been deduplicated themselves. */
+static uint64_t hash_chain(const t3_config_t *list) {
+  uint64_t hash = 0, bits;
+
+  for (; list != NULL; list = list->next) {
+    hash = combine(hash, list->name == NULL ? 0 : STRING_HASH(list->name));
+    hash = combine(hash, (uint64_t)list->type);
+    hash = combine(hash, ((uint64_t)list->file_index << 32) | (uint32_t)list->line_number);
+    switch (list->type) {
+      case T3_CONFIG_BOOL:
+        hash = combine(hash, list->value.boolean ? 1 : 0);
+        break;
+      case T3_CONFIG_INT:
+        hash = combine(hash, (uint64_t)list->value.integer);
+        break;
+      case T3_CONFIG_NUMBER:
+        memcpy(&bits, &list->value.number, sizeof(bits));
+        hash = combine(hash, bits);
+        break;
+      case T3_CONFIG_STRING:
+        if (list->flags & T3_CONFIG_INLINE_STRING) {
+          hash = combine(hash, _t3_config_hash_string(list->value.short_string,
+                                                      strlen(list->value.short_string)));
+        } else {
+          hash = combine(hash, list->value.string == NULL ? 0 : STRING_HASH(list->value.string));
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return hash;
+}
+
+/** Check whether the items of two lists, which have already been deduplicated, are identical.
+    Items read from different locations are different, such that sharing the list does not change
+    the file names and line numbers reported for its items.
+*/
+static t3_bool chains_equal(const t3_config_t *a, const t3_config_t *b) {
+  for (; a != NULL && b != NULL; a = a->next, b = b->next) {
+    if (a->name != b->name || a->type != b->type || a->line_number != b->line_number ||
+        a->file_index != b->file_index) {
+      return t3_false;
+    }
+    switch (a->type) {
+      case T3_CONFIG_BOOL:
+        if (a->value.boolean != b->value.boolean) {
+          return t3_false;
+        }
+        break;
+      case T3_CONFIG_INT:
+        if (a->value.integer != b->value.integer) {
+          return t3_false;
+        }
+        break;
+      case T3_CONFIG_NUMBER:
+        /* Compare the representation, such that 0.0 and -0.0 are kept apart. */
+        if (memcmp(&a->value.number, &b->value.number, sizeof(a->value.number)) != 0) {
+          return t3_false;
+        }
+        break;
+      case T3_CONFIG_STRING:
+        /* Short strings are stored in the items, and are not shared. */
+        if ((a->flags & T3_CONFIG_INLINE_STRING) || (b->flags & T3_CONFIG_INLINE_STRING)) {
+          if (!(a->flags & b->flags & T3_CONFIG_INLINE_STRING) ||
+              strcmp(a->value.short_string, b->value.short_string) != 0) {
+            return t3_false;
+          }
+          break;
+        }
+        if (a->value.ptr != b->value.ptr) {
+          return t3_false;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return a == b;
+}
+
+/** Double the size of the table of distinct lists. */
+static t3_bool grow_chains(dedup_context_t *context) {
+  size_t size = context->chains == NULL ? 64 : (context->chain_mask + 1) * 2, i, j;
+  chain_entry_t *chains;
+
+  if ((chains = _t3_config_mem_calloc(size, sizeof(chain_entry_t))) == NULL) {
+    return t3_false;
+  }
+  if (context->chains != NULL) {
+    for (i = 0; i <= context->chain_mask; i++) {
+      if (context->chains[i].list == NULL) {
+        continue;
+      }
+      j = context->chains[i].hash & (size - 1);
+      while (chains[j].list != NULL) {
+        j = (j + 1) & (size - 1);
+      }
+      chains[j] = context->chains[i];
+    }
+    _t3_config_mem_free(context->chains);
+  }
+  context->chains = chains;
+  context->chain_mask = size - 1;
+  return t3_true;
+}
+
+/** Replace the list of items in @p config, which contains no sections or lists, by an identical
+    list seen earlier, or remember it if there is none. */
+static int share_chain(dedup_context_t *context, t3_config_t *config) {
+  uint64_t hash = hash_chain(config->value.list);
+  chain_entry_t *entry;
+  size_t i;
+  int error;
+
+  if (context->chains == NULL || 2 * (context->chain_count + 1) > context->chain_mask + 1) {
+    if (!grow_chains(context)) {
+      return T3_ERR_OUT_OF_MEMORY;
+    }
+  }
+
+  for (i = hash & context->chain_mask; context->chains[i].list != NULL;
+       i = (i + 1) & context->chain_mask) {
+    entry = &context->chains[i];
+    if (entry->hash != hash || !chains_equal(entry->list, config->value.list)) {
+      continue;
+    }
+    if (entry->list != config->value.list) {
+      if ((error = _t3_config_share_items(entry->list)) != T3_ERR_SUCCESS) {
+        return error;
+      }
+      /* Items reached through either section or list would otherwise be copied on behalf of the
+         first one when they are modified. */
+      _t3_config_disown_items(entry->list);
+      _t3_config_delete_items(config);
+      config->value.list = entry->list;
+      /* Pointers to the deleted items held elsewhere become invalid. */
+      _t3_config_modified(config);
+    }
+    return T3_ERR_SUCCESS;
+  }
+
+  context->chains[i].hash = hash;
+  context->chains[i].list = config->value.list;
+  context->chain_count++;
+  return T3_ERR_SUCCESS;
+}
+
+/** Replace @p *str by a shared string record from the table. */
+static int share_string(dedup_context_t *context, char **str, t3_bool is_record) {
+  char *shared;
+
+  if (*str == NULL) {
+    return T3_ERR_SUCCESS;
+  }
+  if ((shared = _t3_config_intern_string(context->strings, *str)) == NULL) {
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+  if (is_record) {
+    _t3_config_release_string(*str);
+  } else {
+    _t3_config_mem_free(*str);
+  }
+  *str = shared;
+  return T3_ERR_SUCCESS;
+}
+
+static int dedup_value(dedup_context_t *context, t3_config_t *config) {
+  t3_config_t *item;
+  t3_bool has_aggregates = t3_false;
+  int error;
+
+  switch ((int)config->type) {
+    case T3_CONFIG_STRING:
+      /* Short strings take less memory in the item than a reference to a shared copy. */
+      if (config->flags & T3_CONFIG_INLINE_STRING) {
+        return T3_ERR_SUCCESS;
+      }
+      if ((error = share_string(context, &config->value.string,
+                                (config->flags & T3_CONFIG_SHARED_STRING) != 0)) !=
+          T3_ERR_SUCCESS) {
+        return error;
+      }
+      if (config->value.string != NULL) {
+        config->flags |= T3_CONFIG_SHARED_STRING;
+      }
+      return T3_ERR_SUCCESS;
+    case T3_CONFIG_LIST:
+    case T3_CONFIG_PLIST:
+    case T3_CONFIG_SECTION:
+      /* Lists shared with other configs can not be modified, and are left as they are. */
+      if (config->value.list == NULL || _t3_config_is_shared(config->value.list)) {
+        return T3_ERR_SUCCESS;
+      }
+      for (item = config->value.list; item != NULL; item = item->next) {
+        if ((error = share_string(context, &item->name, t3_true)) != T3_ERR_SUCCESS ||
+            (error = dedup_value(context, item)) != T3_ERR_SUCCESS) {
+          return error;
+        }
+        if (item->type == T3_CONFIG_LIST || item->type == T3_CONFIG_PLIST ||
+            item->type == T3_CONFIG_SECTION) {
+          has_aggregates = t3_true;
+        }
+      }
+      return has_aggregates ? T3_ERR_SUCCESS : share_chain(context, config);
+    case T3_CONFIG_EXPRESSION:
+    case T3_CONFIG_SCHEMA:
+      return T3_ERR_BAD_ARG;
+    default:
+      return T3_ERR_SUCCESS;
+  }
+}
+
+int _t3_config_dedup(t3_config_t *config, string_table_t *strings) {
+  dedup_context_t context;
+  int error;
+
+  if (config == NULL) {
+    return T3_ERR_BAD_ARG;
+  }
+  if ((config = _t3_config_writable(config, &error)) == NULL) {
+    return error;
+  }
+
+  context.strings = strings;
+  context.chains = NULL;
+  context.chain_mask = 0;
+  context.chain_count = 0;
+
+  error = dedup_value(&context, config);
+  _t3_config_mem_free(context.chains);
+  return error;
+}
+
+int t3_config_dedup(t3_config_t *config) {
+  string_table_t strings;
+  int error;
+
+  _t3_config_string_table_init(&strings);
+  error = _t3_config_dedup(config, &strings);
+  _t3_config_string_table_free(&strings);
+  return error;
+}
@@ -0,0 +1,251 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_internal.h"
+#include "hash.h"
+#include "util.h"
+
+typedef struct {
+  t3_config_t *changes;
+  /* Path of the section currently being compared, including a trailing slash. */
+  char *path;
+  size_t path_len, path_size;
+} diff_context_t;
+
+/** Append @p name and a slash to the path in @p context. */
+static t3_bool push_path(diff_context_t *context, const char *name) {
+  size_t len = strlen(name);
+
+  if (context->path_len + len + 2 > context->path_size) {
+    size_t new_size = context->path_size * 2 + len + 2;
+    char *new_path = _t3_config_mem_realloc(context->path, new_size);
+    if (new_path == NULL) {
+      return t3_false;
+    }
+    context->path = new_path;
+    context->path_size = new_size;
+  }
+  memcpy(context->path + context->path_len, name, len);
+  context->path_len += len;
+  context->path[context->path_len++] = '/';
+  context->path[context->path_len] = 0;
+  return t3_true;
+}
+
+/** Add a change for the item @p name in the current section to the list of changes. */
+static int add_change(diff_context_t *context, const char *op, const char *name,
+                      const t3_config_t *value) {
+  t3_config_t *change, *copy;
+  size_t path_len = context->path_len;
+  int error = T3_ERR_SUCCESS;
+
+  if ((change = t3_config_add_section(context->changes, NULL, &error)) == NULL) {
+    return error;
+  }
+  if (!push_path(context, name)) {
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+  /* Remove the trailing slash. */
+  context->path[context->path_len - 1] = 0;
+  if ((error = t3_config_add_string(change, "op", op)) == T3_ERR_SUCCESS) {
+    error = t3_config_add_string(change, "path", context->path);
+  }
+  context->path_len = path_len;
+  context->path[path_len] = 0;
+  if (error != T3_ERR_SUCCESS || value == NULL) {
+    return error;
+  }
+
+  /* A full copy is made, as sharing the items with @p value would make the caller's config
+     share its lists with the result. */
+  if ((copy = _t3_config_thaw(value, &error)) == NULL) {
+    return error;
+  }
+  if ((error = t3_config_add_existing(change, "value", copy)) != T3_ERR_SUCCESS) {
+    t3_config_delete(copy);
+  }
+  return error;
+}
+
+/** Add the changes required to transform section @p old_section into @p new_section. */
+static int diff_sections(diff_context_t *context, const t3_config_t *old_section,
+                         const t3_config_t *new_section) {
+  const t3_config_t *item, *other;
+  key_index_t old_index, new_index;
+  int error = T3_ERR_SUCCESS;
+
+  /* Sections shared through t3_config_clone can not have changed. */
+  if (old_section->value.list == new_section->value.list) {
+    return T3_ERR_SUCCESS;
+  }
+
+  if (!_t3_config_index_init_section(&old_index, old_section)) {
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+  if (!_t3_config_index_init_section(&new_index, new_section)) {
+    _t3_config_index_free(&old_index);
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+
+  for (item = old_section->value.list; item != NULL && error == T3_ERR_SUCCESS;
+       item = item->next) {
+    other = *_t3_config_index_lookup_name(&new_index, item->name);
+    if (other == NULL) {
+      error = add_change(context, "remove", item->name, NULL);
+    } else if (item->type == T3_CONFIG_SECTION && other->type == T3_CONFIG_SECTION) {
+      size_t path_len = context->path_len;
+      if (!push_path(context, item->name)) {
+        error = T3_ERR_OUT_OF_MEMORY;
+        break;
+      }
+      error = diff_sections(context, item, other);
+      context->path_len = path_len;
+      context->path[path_len] = 0;
+    } else if (!t3_config_equal(item, other)) {
+      error = add_change(context, "change", item->name, other);
+    }
+  }
+
+  for (item = new_section->value.list; item != NULL && error == T3_ERR_SUCCESS;
+       item = item->next) {
+    if (*_t3_config_index_lookup_name(&old_index, item->name) == NULL) {
+      error = add_change(context, "add", item->name, item);
+    }
+  }
+
+  _t3_config_index_free(&old_index);
+  _t3_config_index_free(&new_index);
+  return error;
+}
+
+t3_config_t *t3_config_diff(const t3_config_t *old_config, const t3_config_t *new_config,
+                            int *error) {
+  diff_context_t context;
+  t3_config_t *result;
+  int local_error = T3_ERR_SUCCESS;
+
+  if (old_config == NULL || new_config == NULL || old_config->type != T3_CONFIG_SECTION ||
+      new_config->type != T3_CONFIG_SECTION) {
+    if (error != NULL) {
+      *error = T3_ERR_BAD_ARG;
+    }
+    return NULL;
+  }
+
+  if ((result = t3_config_new()) == NULL) {
+    if (error != NULL) {
+      *error = T3_ERR_OUT_OF_MEMORY;
+    }
+    return NULL;
+  }
+  if ((context.changes = t3_config_add_list(result, "changes", &local_error)) == NULL ||
+      (context.path = _t3_config_mem_alloc(context.path_size = 64)) == NULL) {
+    t3_config_delete(result);
+    if (error != NULL) {
+      *error = local_error != T3_ERR_SUCCESS ? local_error : T3_ERR_OUT_OF_MEMORY;
+    }
+    return NULL;
+  }
+  context.path_len = 0;
+  context.path[0] = 0;
+
+  local_error = diff_sections(&context, old_config, new_config);
+  _t3_config_mem_free(context.path);
+  if (local_error != T3_ERR_SUCCESS) {
+    t3_config_delete(result);
+    if (error != NULL) {
+      *error = local_error;
+    }
+    return NULL;
+  }
+  return result;
+}
+
+/** Apply a single change from a patch. */
+static int apply_change(t3_config_t *config, const t3_config_t *change) {
+  const char *op = t3_config_get_string(t3_config_get(change, "op"));
+  const char *path = t3_config_get_string(t3_config_get(change, "path"));
+  const t3_config_t *value = t3_config_get(change, "value");
+  const char *slash;
+  t3_config_t *existing, *copy;
+  char *name;
+  int error = T3_ERR_SUCCESS;
+
+  if (op == NULL || path == NULL) {
+    return T3_ERR_BAD_ARG;
+  }
+
+  /* Find the section containing the item to change. */
+  while (config != NULL && (slash = strchr(path, '/')) != NULL) {
+    if ((name = _t3_config_mem_alloc(slash - path + 1)) == NULL) {
+      return T3_ERR_OUT_OF_MEMORY;
+    }
+    memcpy(name, path, slash - path);
+    name[slash - path] = 0;
+    config = t3_config_get_mutable(config, name);
+    _t3_config_mem_free(name);
+    path = slash + 1;
+  }
+  if (config == NULL || config->type != T3_CONFIG_SECTION) {
+    return T3_ERR_BAD_ARG;
+  }
+
+  if (strcmp(op, "remove") == 0) {
+    if ((existing = t3_config_unlink(config, path)) == NULL) {
+      return T3_ERR_BAD_ARG;
+    }
+    t3_config_delete(existing);
+    return T3_ERR_SUCCESS;
+  }
+
+  if ((strcmp(op, "add") != 0 && strcmp(op, "change") != 0) || value == NULL) {
+    return T3_ERR_BAD_ARG;
+  }
+  /* Like in add_change, the value is copied completely, leaving @p change untouched. */
+  if ((copy = _t3_config_thaw(value, &error)) == NULL) {
+    return error;
+  }
+  if ((existing = t3_config_get_mutable(config, path)) != NULL) {
+    /* Keep the position of the changed item in the section. */
+    _t3_config_replace_value(existing, copy);
+  } else if ((error = t3_config_add_existing(config, path, copy)) != T3_ERR_SUCCESS) {
+    t3_config_delete(copy);
+  }
+  return error;
+}
+
+int t3_config_apply_patch(t3_config_t *config, const t3_config_t *patch) {
+  const t3_config_t *changes, *change;
+  int error;
+
+  if (config == NULL || config->type != T3_CONFIG_SECTION || patch == NULL ||
+      patch->type != T3_CONFIG_SECTION) {
+    return T3_ERR_BAD_ARG;
+  }
+  if (!t3_config_is_list(changes = t3_config_get(patch, "changes"))) {
+    return T3_ERR_BAD_ARG;
+  }
+  if ((config = _t3_config_writable(config, &error)) == NULL) {
+    return error;
+  }
+
+  for (change = changes->value.list; change != NULL; change = change->next) {
+    if ((error = apply_change(config, change)) != T3_ERR_SUCCESS) {
+      return error;
+    }
+  }
+  return T3_ERR_SUCCESS;
+}
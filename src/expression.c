@@ -32,7 +32,7 @@ static const t3_config_t *lookup_node(const expr_node_t *expr, const t3_config_t
       if (value == NULL || value->type != T3_CONFIG_STRING) {
         return NULL;
       }
-      return t3_config_get(config, value->value.string);
+      return t3_config_get(config, STRING_VALUE(value));
     }
     case EXPR_THIS:
       return config;
@@ -76,7 +76,7 @@ static t3_bool resolve(const expr_node_t *expr, const t3_config_t *config, const
         list = lookup_node(expr->value.operand[0], config, root, config);
       }
 
-      if (list->type != T3_CONFIG_LIST && list->type != T3_CONFIG_PLIST) {
+      if (list == NULL || (list->type != T3_CONFIG_LIST && list->type != T3_CONFIG_PLIST)) {
         return t3_false;
       }
 
@@ -111,7 +111,7 @@ static t3_config_type_t operand_type(const expr_node_t *expr) {
 }
 
 static const char *get_string_operand(const expr_node_t *expr) {
-  return expr->type == EXPR_CONFIG ? expr->value.config->value.string : expr->value.string;
+  return expr->type == EXPR_CONFIG ? STRING_VALUE(expr->value.config) : expr->value.string;
 }
 
 static t3_bool get_bool_operand(const expr_node_t *expr) {
@@ -405,10 +405,20 @@ void _t3_config_delete_expr(expr_node_t *expr) {
       break;
     case EXPR_STRING_CONST:
     case EXPR_IDENT:
-      free(expr->value.string);
+      _t3_config_mem_free(expr->value.string);
       break;
     default:
       break;
   }
-  free(expr);
+  _t3_config_mem_free(expr);
 }
+
+t3_bool t3_config_expr_eval(const t3_config_expr_t *expr, const t3_config_t *config,
+                            const t3_config_t *root) {
+  if (expr == NULL || config == NULL) {
+    return t3_false;
+  }
+  return _t3_config_evaluate_expr((const expr_node_t *)expr, config, root == NULL ? config : root);
+}
+
+void t3_config_expr_delete(t3_config_expr_t *expr) { _t3_config_delete_expr((expr_node_t *)expr); }
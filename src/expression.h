@@ -72,4 +72,5 @@ T3_CONFIG_LOCAL t3_bool _t3_config_validate_expr(const expr_node_t *expression,
                                                  const t3_config_t *config,
                                                  const t3_config_t *root);
 T3_CONFIG_LOCAL void _t3_config_delete_expr(expr_node_t *expr);
+T3_CONFIG_LOCAL expr_node_t *_t3_config_parse_expr(const char *text, int *error);
 #endif
@@ -0,0 +1,565 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_internal.h"
+#include "freeze.h"
+#include "hash.h"
+#include "util.h"
+
+/* Sections with at most this many items are searched linearly, which is faster than hashing. */
+#define LINEAR_LOOKUP_MAX 8
+/* The maximum number of displacements tried per bucket, before giving up on the perfect hash.
+   When only a few slots remain, finding a displacement for a bucket takes about as many tries
+   as there are items in the section, so the limit must scale with the number of items. */
+#define MAX_DISPLACEMENT(count) ((count)*64 + 1024)
+#define DISPLACEMENT_STEP UINT64_C(0x9e3779b97f4a7c15)
+
+typedef struct {
+  /* A name from the original config. */
+  const char *name;
+  /* The copy of the name in the frozen config, or NULL if it has not been made yet. */
+  char *copy;
+} name_entry_t;
+
+typedef struct {
+  size_t items, indices, table_entries, name_bytes, string_bytes;
+  /* Hash table of the distinct names. */
+  name_entry_t *names;
+  size_t name_mask, name_count;
+} freeze_size_t;
+
+typedef struct {
+  freeze_size_t *size;
+  char *next_item;
+  uint32_t *next_table_entry;
+  char *next_name;
+  char *next_string;
+} freeze_context_t;
+
+static uint32_t bucket_count(uint32_t count) { return count / 2 + 1; }
+
+static uint32_t bucket_of(uint64_t hash, uint32_t buckets) {
+  return (uint32_t)(hash >> 32) % buckets;
+}
+
+static uint32_t slot_of(uint64_t hash, uint32_t displacement, uint32_t count) {
+  return (uint32_t)(_t3_config_hash_mix(hash + displacement * DISPLACEMENT_STEP) % count);
+}
+
+/** Find the entry for @p name in the table of distinct names. */
+static name_entry_t *find_name(const freeze_size_t *size, const char *name) {
+  size_t i;
+
+  for (i = STRING_HASH(name) & size->name_mask; size->names[i].name != NULL;
+       i = (i + 1) & size->name_mask) {
+    if (size->names[i].name == name ||
+        (STRING_HASH(size->names[i].name) == STRING_HASH(name) &&
+         strcmp(size->names[i].name, name) == 0)) {
+      break;
+    }
+  }
+  return &size->names[i];
+}
+
+/** Add @p name to the table of distinct names, if it is not present yet. */
+static t3_bool add_name(freeze_size_t *size, const char *name) {
+  name_entry_t *entry;
+
+  if (size->names == NULL || 2 * (size->name_count + 1) > size->name_mask + 1) {
+    freeze_size_t old = *size;
+    size_t i;
+
+    size->name_mask = size->names == NULL ? 63 : size->name_mask * 2 + 1;
+    if ((size->names = _t3_config_mem_calloc(size->name_mask + 1, sizeof(name_entry_t))) == NULL) {
+      size->names = old.names;
+      size->name_mask = old.name_mask;
+      return t3_false;
+    }
+    for (i = 0; old.names != NULL && i <= old.name_mask; i++) {
+      if (old.names[i].name != NULL) {
+        *find_name(size, old.names[i].name) = old.names[i];
+      }
+    }
+    _t3_config_mem_free(old.names);
+  }
+
+  entry = find_name(size, name);
+  if (entry->name == NULL) {
+    entry->name = name;
+    size->name_count++;
+    size->name_bytes += NAME_SIZE(STRING_RECORD(name)->length);
+  }
+  return t3_true;
+}
+
+/** Compute the amount of memory required to store the frozen copy of @p config. */
+static int measure(const t3_config_t *config, freeze_size_t *size) {
+  const t3_config_t *item;
+  uint32_t count = 0;
+  int error;
+
+  if ((int)config->type == T3_CONFIG_EXPRESSION || (int)config->type == T3_CONFIG_SCHEMA) {
+    return T3_ERR_BAD_ARG;
+  }
+
+  size->items++;
+  if (config->name != NULL && !add_name(size, config->name)) {
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+
+  switch (config->type) {
+    case T3_CONFIG_STRING:
+      if (!(config->flags & T3_CONFIG_INLINE_STRING) && config->value.string != NULL) {
+        size->string_bytes += strlen(config->value.string) + 1;
+      }
+      break;
+    case T3_CONFIG_LIST:
+    case T3_CONFIG_PLIST:
+    case T3_CONFIG_SECTION:
+      for (item = config->value.list; item != NULL; item = item->next) {
+        if ((error = measure(item, size)) != T3_ERR_SUCCESS) {
+          return error;
+        }
+        count++;
+      }
+      if (count > 0) {
+        size->indices++;
+      }
+      if (config->type == T3_CONFIG_SECTION && count > LINEAR_LOOKUP_MAX) {
+        size->table_entries += bucket_count(count) + count;
+      }
+      break;
+    default:
+      break;
+  }
+  return T3_ERR_SUCCESS;
+}
+
+static char *copy_string(freeze_context_t *context, const char *str) {
+  char *result = context->next_string;
+  size_t len;
+
+  if (str == NULL) {
+    return NULL;
+  }
+  len = strlen(str) + 1;
+  memcpy(result, str, len);
+  context->next_string += len;
+  return result;
+}
+
+/** Retrieve the copy of @p name in the frozen config, creating it if it does not exist yet. */
+static char *copy_name(freeze_context_t *context, const char *name) {
+  name_entry_t *entry;
+  shared_string_t *record;
+
+  if (name == NULL) {
+    return NULL;
+  }
+  entry = find_name(context->size, name);
+  if (entry->copy == NULL) {
+    record = (shared_string_t *)context->next_name;
+    /* The names are released with the frozen config, so they are not reference counted. */
+    record->count = -1;
+    record->hash = STRING_HASH(name);
+    record->length = STRING_RECORD(name)->length;
+    memcpy(record->str, name, record->length + 1);
+    entry->copy = record->str;
+    context->next_name += NAME_SIZE(record->length);
+  }
+  return entry->copy;
+}
+
+typedef struct {
+  uint32_t bucket, size;
+} bucket_size_t;
+
+static int compare_bucket_size(const void *a, const void *b) {
+  const bucket_size_t *bucket_a = a, *bucket_b = b;
+  /* Sort by decreasing size. */
+  return bucket_a->size < bucket_b->size ? 1 : bucket_a->size > bucket_b->size ? -1 : 0;
+}
+
+/** Try to place the @p member_count items in @p members in empty slots, using @p displacement.
+    If any of the slots is not available, all slots taken are released again.
+*/
+static t3_bool place_bucket(uint32_t *slots, const uint64_t *hashes, const uint32_t *members,
+                            uint32_t member_count, uint32_t displacement, uint32_t count) {
+  uint32_t i, slot;
+
+  for (i = 0; i < member_count; i++) {
+    slot = slot_of(hashes[members[i]], displacement, count);
+    if (slots[slot] != UINT32_MAX) {
+      while (i > 0) {
+        i--;
+        slots[slot_of(hashes[members[i]], displacement, count)] = UINT32_MAX;
+      }
+      return t3_false;
+    }
+    slots[slot] = members[i];
+  }
+  return t3_true;
+}
+
+/** Build a minimal perfect hash for the names of @p count @p items.
+    This uses the hash and displace method: the names are first distributed over a number of
+    buckets, after which, starting with the largest bucket, a displacement is searched for each
+    bucket that maps all the names in the bucket to free slots.
+    @return ::t3_false if no perfect hash was found, or memory was exhausted.
+*/
+static t3_bool build_perfect_hash(const t3_config_t *items, uint32_t count, uint32_t buckets,
+                                  uint32_t *displacements, uint32_t *slots) {
+  uint64_t *hashes;
+  uint32_t *members, *bucket_start, i, displacement, max_displacement = MAX_DISPLACEMENT(count);
+  bucket_size_t *order;
+  t3_bool result = t3_true;
+
+  hashes = _t3_config_mem_alloc(count * sizeof(uint64_t));
+  members = _t3_config_mem_alloc(count * sizeof(uint32_t));
+  bucket_start = _t3_config_mem_calloc(buckets + 1, sizeof(uint32_t));
+  order = _t3_config_mem_alloc(buckets * sizeof(bucket_size_t));
+  if (hashes == NULL || members == NULL || bucket_start == NULL || order == NULL) {
+    result = t3_false;
+    goto end;
+  }
+
+  /* Distribute the items over the buckets, using a counting sort. */
+  for (i = 0; i < buckets; i++) {
+    order[i].bucket = i;
+    order[i].size = 0;
+  }
+  for (i = 0; i < count; i++) {
+    hashes[i] = _t3_config_hash_string64(items[i].name);
+    order[bucket_of(hashes[i], buckets)].size++;
+  }
+  for (i = 0; i < buckets; i++) {
+    bucket_start[i + 1] = bucket_start[i] + order[i].size;
+  }
+  for (i = 0; i < count; i++) {
+    uint32_t bucket = bucket_of(hashes[i], buckets);
+    members[bucket_start[bucket] + --order[bucket].size] = i;
+  }
+  for (i = 0; i < buckets; i++) {
+    order[i].size = bucket_start[i + 1] - bucket_start[i];
+  }
+  qsort(order, buckets, sizeof(bucket_size_t), compare_bucket_size);
+
+  for (i = 0; i < count; i++) {
+    slots[i] = UINT32_MAX;
+  }
+  for (i = 0; i < buckets; i++) {
+    uint32_t bucket = order[i].bucket;
+
+    displacements[bucket] = 0;
+    if (order[i].size == 0) {
+      continue;
+    }
+    for (displacement = 0; displacement < max_displacement; displacement++) {
+      if (place_bucket(slots, hashes, members + bucket_start[bucket], order[i].size, displacement,
+                       count)) {
+        break;
+      }
+    }
+    if (displacement == max_displacement) {
+      result = t3_false;
+      break;
+    }
+    displacements[bucket] = displacement;
+  }
+
+end:
+  _t3_config_mem_free(hashes);
+  _t3_config_mem_free(members);
+  _t3_config_mem_free(bucket_start);
+  _t3_config_mem_free(order);
+  return result;
+}
+
+static void copy_item(freeze_context_t *context, t3_config_t *dest, const t3_config_t *src);
+
+/** Copy the items of @p src into a new consecutive block, and make @p dest refer to them. */
+static void copy_items(freeze_context_t *context, t3_config_t *dest, const t3_config_t *src) {
+  frozen_index_t *index;
+  t3_config_t *items;
+  const t3_config_t *item;
+  uint32_t count = 0, i;
+
+  for (item = src->value.list; item != NULL; item = item->next) {
+    count++;
+  }
+  if (count == 0) {
+    dest->value.list = NULL;
+    return;
+  }
+
+  index = (frozen_index_t *)context->next_item;
+  items = (t3_config_t *)(context->next_item + INDEX_SIZE);
+  context->next_item += INDEX_SIZE + count * ITEM_SIZE;
+
+  /* All items are allocated before recursing, such that they are consecutive. */
+  for (item = src->value.list, i = 0; item != NULL; item = item->next, i++) {
+    copy_item(context, &items[i], item);
+    items[i].next = i + 1 < count ? &items[i + 1] : NULL;
+  }
+  dest->value.list = items;
+  _t3_config_link_items(dest);
+
+  index->count = count;
+  index->displacements = NULL;
+  index->slots = NULL;
+  index->buckets = 0;
+  if (src->type == T3_CONFIG_SECTION && count > LINEAR_LOOKUP_MAX) {
+    uint32_t buckets = bucket_count(count);
+    uint32_t *displacements = context->next_table_entry;
+    uint32_t *slots = displacements + buckets;
+
+    context->next_table_entry += buckets + count;
+    /* If no perfect hash can be built, the section is searched linearly. */
+    if (build_perfect_hash(items, count, buckets, displacements, slots)) {
+      index->displacements = displacements;
+      index->slots = slots;
+      index->buckets = buckets;
+    }
+  }
+}
+
+static void copy_item(freeze_context_t *context, t3_config_t *dest, const t3_config_t *src) {
+  dest->type = src->type;
+  dest->line_number = src->line_number;
+  dest->flags = T3_CONFIG_FROZEN | (src->flags & T3_CONFIG_INLINE_STRING);
+  dest->next = NULL;
+  dest->name = copy_name(context, src->name);
+  dest->file_index = src->file_index;
+
+  switch (src->type) {
+    case T3_CONFIG_STRING:
+      if (src->flags & T3_CONFIG_INLINE_STRING) {
+        dest->value = src->value;
+      } else {
+        dest->value.string = copy_string(context, src->value.string);
+      }
+      break;
+    case T3_CONFIG_LIST:
+    case T3_CONFIG_PLIST:
+    case T3_CONFIG_SECTION:
+      copy_items(context, dest, src);
+      break;
+    default:
+      dest->value = src->value;
+      break;
+  }
+
+  /* Frozen items are never written after freezing, as they may be used from multiple threads, so
+     the hashes of sections and lists are computed now. The sections and lists below dest already
+     have their hashes. Scalars and empty sections and lists are cheap to hash when needed. */
+  if ((dest->type == T3_CONFIG_LIST || dest->type == T3_CONFIG_PLIST ||
+       dest->type == T3_CONFIG_SECTION) &&
+      dest->value.list != NULL) {
+    ((frozen_index_t *)INDEX(dest->value.list))->hash = _t3_config_compute_hash(dest);
+  }
+}
+
+/** Create a frozen copy of @p config.
+    @param size The location to store the size of the allocated block.
+    @param items_size The location to store the number of bytes used by the items and indices at
+        the start of the block. The tables, names and strings follow these.
+*/
+t3_config_t *_t3_config_freeze_block(const t3_config_t *config, size_t *size, size_t *items_size,
+                                     int *error) {
+  freeze_size_t measured;
+  freeze_context_t context;
+  t3_config_t *result;
+  char *memory;
+  int local_error;
+
+  memset(&measured, 0, sizeof(measured));
+  if ((local_error = measure(config, &measured)) != T3_ERR_SUCCESS) {
+    goto error_end;
+  }
+
+  *items_size = ITEM_SIZE + measured.indices * INDEX_SIZE + (measured.items - 1) * ITEM_SIZE;
+  *size = *items_size + measured.table_entries * sizeof(uint32_t) + measured.name_bytes +
+          measured.string_bytes;
+  if ((memory = _t3_config_mem_alloc(*size)) == NULL) {
+    local_error = T3_ERR_OUT_OF_MEMORY;
+    goto error_end;
+  }
+
+  result = (t3_config_t *)memory;
+
+  context.size = &measured;
+  context.next_item = memory + ITEM_SIZE;
+  context.next_table_entry = (uint32_t *)(memory + *items_size);
+  context.next_name = (char *)(context.next_table_entry + measured.table_entries);
+  context.next_string = context.next_name + measured.name_bytes;
+
+  copy_item(&context, result, config);
+  _t3_config_make_top_level(result);
+  result->flags |= T3_CONFIG_FROZEN_ROOT;
+  _t3_config_mem_free(measured.names);
+  return result;
+
+error_end:
+  _t3_config_mem_free(measured.names);
+  if (error != NULL) {
+    *error = local_error;
+  }
+  return NULL;
+}
+
+/** Call @p visit for the file index of @p config and of all items below it. This is used to add and
+    release the references to the file names of frozen items, which _t3_config_freeze_block does
+    not add, as images refer to file names by their position in the image instead.
+*/
+void _t3_config_visit_file_names(const t3_config_t *config, void (*visit)(uint16_t index)) {
+  const t3_config_t *item;
+
+  visit(config->file_index);
+  if (config->type == T3_CONFIG_LIST || config->type == T3_CONFIG_PLIST ||
+      config->type == T3_CONFIG_SECTION) {
+    for (item = config->value.list; item != NULL; item = item->next) {
+      _t3_config_visit_file_names(item, visit);
+    }
+  }
+}
+
+t3_config_t *t3_config_freeze(const t3_config_t *config, int *error) {
+  t3_config_t *result;
+  size_t size, items_size;
+
+  if (config == NULL) {
+    if (error != NULL) {
+      *error = T3_ERR_BAD_ARG;
+    }
+    return NULL;
+  }
+  if ((result = _t3_config_freeze_block(config, &size, &items_size, error)) != NULL) {
+    _t3_config_visit_file_names(result, _t3_config_ref_file_name);
+  }
+  return result;
+}
+
+void _t3_config_delete_frozen(t3_config_t *config) {
+  _t3_config_visit_file_names(config, _t3_config_release_file_name);
+  _t3_config_mem_free(config);
+}
+
+t3_config_t *_t3_config_frozen_get(const t3_config_t *section, const char *name) {
+  const frozen_index_t *index = INDEX(section->value.list);
+  return _t3_config_frozen_get_hashed(
+      section, name, index->displacements == NULL ? 0 : _t3_config_hash_string64(name));
+}
+
+/** Look up @p name in a frozen section, where @p hash is the result of _t3_config_hash_string64
+    for @p name. The hash is only used if the section has a perfect hash table. */
+t3_config_t *_t3_config_frozen_get_hashed(const t3_config_t *section, const char *name,
+                                          uint64_t hash) {
+  t3_config_t *items = section->value.list;
+  const frozen_index_t *index = INDEX(items);
+  uint32_t i;
+
+  if (index->displacements == NULL) {
+    for (i = 0; i < index->count; i++) {
+      if (strcmp(items[i].name, name) == 0) {
+        return &items[i];
+      }
+    }
+    return NULL;
+  }
+
+  i = index->slots[slot_of(hash, index->displacements[bucket_of(hash, index->buckets)],
+                           index->count)];
+  return strcmp(items[i].name, name) == 0 ? &items[i] : NULL;
+}
+
+t3_config_t *_t3_config_frozen_get_index(const t3_config_t *list, size_t index) {
+  t3_config_t *items = list->value.list;
+  return items != NULL && index < INDEX(items)->count ? &items[index] : NULL;
+}
+
+int _t3_config_frozen_length(const t3_config_t *config) {
+  return config->value.list == NULL ? 0 : (int)INDEX(config->value.list)->count;
+}
+
+/** Get the number of bytes used by the index of the frozen section or list @p config. */
+size_t _t3_config_frozen_index_size(const t3_config_t *config) {
+  const frozen_index_t *index;
+
+  if (config->value.list == NULL) {
+    return 0;
+  }
+  index = INDEX(config->value.list);
+  return INDEX_SIZE + (index->displacements == NULL
+                           ? 0
+                           : (index->buckets + index->count) * sizeof(uint32_t));
+}
+
+/** Create a modifiable copy of @p config and all items below it, which does not share any items
+    with @p config. @p config does not need to be frozen, and is not modified.
+*/
+t3_config_t *_t3_config_thaw(const t3_config_t *config, int *error) {
+  t3_config_t *result, *item, **next_ptr;
+
+  if ((result = _t3_config_mem_alloc(sizeof(t3_config_t))) == NULL) {
+    *error = T3_ERR_OUT_OF_MEMORY;
+    return NULL;
+  }
+  *result = *config;
+  _t3_config_ref_file_name(result->file_index);
+  result->next = NULL;
+  result->flags = config->flags & T3_CONFIG_INLINE_STRING;
+  _t3_config_make_top_level(result);
+  result->name = NULL;
+
+  switch (config->type) {
+    case T3_CONFIG_STRING:
+      if (config->flags & T3_CONFIG_INLINE_STRING) {
+        break;
+      }
+      result->value.string = NULL;
+      if (config->value.string != NULL &&
+          (result->value.string = _t3_config_strdup(config->value.string)) == NULL) {
+        goto out_of_memory;
+      }
+      break;
+    case T3_CONFIG_LIST:
+    case T3_CONFIG_PLIST:
+    case T3_CONFIG_SECTION:
+      result->value.list = NULL;
+      next_ptr = &result->value.list;
+      for (item = config->value.list; item != NULL; item = item->next) {
+        if ((*next_ptr = _t3_config_thaw(item, error)) == NULL) {
+          t3_config_delete(result);
+          return NULL;
+        }
+        next_ptr = &(*next_ptr)->next;
+      }
+      _t3_config_link_items(result);
+      break;
+    default:
+      break;
+  }
+
+  if (config->name != NULL && (result->name = _t3_config_ref_string(config->name)) == NULL) {
+    goto out_of_memory;
+  }
+  return result;
+
+out_of_memory:
+  t3_config_delete(result);
+  *error = T3_ERR_OUT_OF_MEMORY;
+  return NULL;
+}
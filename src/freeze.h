@@ -0,0 +1,57 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef T3_CONFIG_FREEZE_H
+#define T3_CONFIG_FREEZE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config_api.h"
+#include "config_internal.h"
+
+/* A frozen config is stored in a single block of memory, laid out as follows:
+   - the top-level item,
+   - for each section or list with items, in document order of the sections and lists: a
+     frozen_index_t followed by the items in the section or list,
+   - the perfect hash tables of the sections,
+   - the name records, each distinct name stored once,
+   - the string values.
+   Because the items of each section and list are stored consecutively, the next pointers are
+   kept only for the benefit of the regular API.
+*/
+
+#define ALIGN(x) (((x) + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1))
+#define ITEM_SIZE ALIGN(sizeof(t3_config_t))
+#define INDEX_SIZE ALIGN(sizeof(frozen_index_t))
+#define NAME_SIZE(length) \
+  ((STRING_RECORD_SIZE(length) + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1))
+
+/* The index of a section or list, stored directly before its first item. */
+typedef struct {
+  /* The minimal perfect hash of the item names. If displacements is NULL, items are looked up
+     by linear search. */
+  const uint32_t *displacements;
+  const uint32_t *slots;
+  uint32_t count, buckets;
+  /* The result of t3_config_hash for the section or list, computed when it was frozen. */
+  uint64_t hash;
+} frozen_index_t;
+
+#define INDEX(first_item) ((const frozen_index_t *)((const char *)(first_item)-INDEX_SIZE))
+
+T3_CONFIG_LOCAL t3_config_t *_t3_config_freeze_block(const t3_config_t *config, size_t *size,
+                                                     size_t *items_size, int *error);
+T3_CONFIG_LOCAL void _t3_config_visit_file_names(const t3_config_t *config,
+                                                 void (*visit)(uint16_t index));
+#endif
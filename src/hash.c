@@ -0,0 +1,367 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "freeze.h"
+#include "hash.h"
+#include "util.h"
+
+/** FNV-1a hash of the first @p len bytes of @p str. */
+uint32_t _t3_config_hash_string(const char *str, size_t len) {
+  uint32_t hash = 2166136261u;
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    hash ^= (unsigned char)str[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/** Initialize an empty index with room for @p count items. */
+t3_bool _t3_config_index_init(key_index_t *index, size_t count) {
+  size_t size = 8;
+
+  /* Keep the load factor at or below 0.5 to keep the probe sequences short. */
+  while (size < 2 * count) {
+    size <<= 1;
+  }
+  if ((index->items = _t3_config_mem_calloc(size, sizeof(t3_config_t *))) == NULL) {
+    return t3_false;
+  }
+  index->mask = size - 1;
+  return t3_true;
+}
+
+/** Initialize an index containing all the items in @p section.
+    If a name occurs more than once, the first item with that name is stored.
+*/
+t3_bool _t3_config_index_init_section(key_index_t *index, const t3_config_t *section) {
+  t3_config_t *item, **slot;
+
+  if (!_t3_config_index_init(index, t3_config_get_length(section))) {
+    return t3_false;
+  }
+  for (item = t3_config_get(section, NULL); item != NULL; item = item->next) {
+    slot = _t3_config_index_lookup_name(index, item->name);
+    if (*slot == NULL) {
+      *slot = item;
+    }
+  }
+  return t3_true;
+}
+
+static t3_config_t **lookup(const key_index_t *index, const char *name, size_t len,
+                            uint32_t hash) {
+  size_t i = hash & index->mask;
+  const char *item_name;
+
+  for (; index->items[i] != NULL; i = (i + 1) & index->mask) {
+    item_name = index->items[i]->name;
+    if (item_name == name ||
+        (STRING_HASH(item_name) == hash && STRING_RECORD(item_name)->length == len &&
+         memcmp(item_name, name, len) == 0)) {
+      break;
+    }
+  }
+  return &index->items[i];
+}
+
+/** Find the slot for @p name in @p index.
+    @return The slot containing the item named @p name, or the empty slot where
+        it should be stored.
+*/
+t3_config_t **_t3_config_index_lookup(const key_index_t *index, const char *name, size_t len) {
+  return lookup(index, name, len, _t3_config_hash_string(name, len));
+}
+
+/** Find the slot for @p name in @p index, where @p name is the name of an item.
+    This is faster than ::_t3_config_index_lookup, because the hash of the name is precomputed.
+*/
+t3_config_t **_t3_config_index_lookup_name(const key_index_t *index, const char *name) {
+  return lookup(index, name, STRING_RECORD(name)->length, STRING_HASH(name));
+}
+
+void _t3_config_index_free(key_index_t *index) { _t3_config_mem_free(index->items); }
+
+void _t3_config_string_table_init(string_table_t *table) {
+  table->strings = NULL;
+  table->mask = 0;
+  table->count = 0;
+}
+
+/** Double the size of @p table. */
+static t3_bool grow_string_table(string_table_t *table) {
+  size_t size = table->strings == NULL ? 64 : (table->mask + 1) * 2, i, j;
+  char **strings;
+
+  if ((strings = _t3_config_mem_calloc(size, sizeof(char *))) == NULL) {
+    return t3_false;
+  }
+  if (table->strings != NULL) {
+    for (i = 0; i <= table->mask; i++) {
+      if (table->strings[i] == NULL) {
+        continue;
+      }
+      j = STRING_HASH(table->strings[i]) & (size - 1);
+      while (strings[j] != NULL) {
+        j = (j + 1) & (size - 1);
+      }
+      strings[j] = table->strings[i];
+    }
+    _t3_config_mem_free(table->strings);
+  }
+  table->strings = strings;
+  table->mask = size - 1;
+  return t3_true;
+}
+
+/** Retrieve a shared string record for @p str, creating it if it does not exist yet.
+    @return A new reference to the string record, or @c NULL if memory is exhausted.
+*/
+char *_t3_config_intern_string(string_table_t *table, const char *str) {
+  size_t len = strlen(str), i;
+  uint32_t hash = _t3_config_hash_string(str, len);
+  char *result;
+
+  if (table->strings == NULL || 2 * (table->count + 1) > table->mask + 1) {
+    if (!grow_string_table(table)) {
+      return NULL;
+    }
+  }
+
+  for (i = hash & table->mask; table->strings[i] != NULL; i = (i + 1) & table->mask) {
+    if (STRING_HASH(table->strings[i]) == hash && strcmp(table->strings[i], str) == 0) {
+      return _t3_config_ref_string(table->strings[i]);
+    }
+  }
+
+  if ((result = _t3_config_new_string(str)) == NULL) {
+    return NULL;
+  }
+  /* The table holds a reference of its own. */
+  table->strings[i] = _t3_config_ref_string(result);
+  table->count++;
+  return result;
+}
+
+void _t3_config_string_table_free(string_table_t *table) {
+  size_t i;
+
+  if (table->strings == NULL) {
+    return;
+  }
+  for (i = 0; i <= table->mask; i++) {
+    _t3_config_release_string(table->strings[i]);
+  }
+  _t3_config_mem_free(table->strings);
+  table->strings = NULL;
+}
+
+/** 64-bit FNV-1a hash of a nul-terminated string. */
+uint64_t _t3_config_hash_string64(const char *str) {
+  uint64_t hash = UINT64_C(14695981039346656037);
+
+  for (; *str != 0; str++) {
+    hash ^= (unsigned char)*str;
+    hash *= UINT64_C(1099511628211);
+  }
+  return hash;
+}
+
+/** Scramble the bits of @p value, such that every input bit affects all output bits. */
+uint64_t _t3_config_hash_mix(uint64_t value) {
+  value ^= value >> 30;
+  value *= UINT64_C(0xbf58476d1ce4e5b9);
+  value ^= value >> 27;
+  value *= UINT64_C(0x94d049bb133111eb);
+  value ^= value >> 31;
+  return value;
+}
+
+static uint64_t combine(uint64_t hash, uint64_t value) {
+  value += UINT64_C(0x9e3779b97f4a7c15) + (hash << 6) + (hash >> 2);
+  return _t3_config_hash_mix(hash ^ value);
+}
+
+/** Get the hash of @p config that was stored when it was frozen.
+    @return ::t3_false if no hash is stored for @p config. Only frozen sections and lists with items
+        have their hashes stored.
+*/
+static t3_bool stored_hash(const t3_config_t *config, uint64_t *hash) {
+  if (!(config->flags & T3_CONFIG_FROZEN) || config->value.list == NULL ||
+      (config->type != T3_CONFIG_LIST && config->type != T3_CONFIG_PLIST &&
+       config->type != T3_CONFIG_SECTION)) {
+    return t3_false;
+  }
+  *hash = INDEX(config->value.list)->hash;
+  return t3_true;
+}
+
+/** Compute the hash of @p config. Frozen sections and lists have their hashes computed when they
+    are frozen, which are used rather than computing them again. Other items are never written, as
+    they may be read from other threads at the same time.
+*/
+uint64_t _t3_config_hash_value(const t3_config_t *config) {
+  uint64_t hash;
+  return stored_hash(config, &hash) ? hash : _t3_config_compute_hash(config);
+}
+
+/** Compute the hash of @p config from the hashes of the items below it, without using a hash
+    stored for @p config itself. This is used to compute the hashes while freezing.
+*/
+uint64_t _t3_config_compute_hash(const t3_config_t *config) {
+  const t3_config_t *item;
+  uint64_t hash = (uint64_t)config->type, sum, item_hash;
+  double number;
+
+  switch ((int)config->type) {
+    case T3_CONFIG_BOOL:
+      hash = combine(hash, config->value.boolean ? 1 : 0);
+      break;
+    case T3_CONFIG_INT:
+      hash = combine(hash, (uint64_t)config->value.integer);
+      break;
+    case T3_CONFIG_NUMBER:
+      /* Make sure that 0.0 and -0.0, which compare equal, also hash equal. */
+      number = config->value.number == 0.0 ? 0.0 : config->value.number;
+      memcpy(&sum, &number, sizeof(sum));
+      hash = combine(hash, sum);
+      break;
+    case T3_CONFIG_STRING:
+      if (STRING_VALUE(config) != NULL) {
+        hash = combine(hash, _t3_config_hash_string64(STRING_VALUE(config)));
+      }
+      break;
+    case T3_CONFIG_LIST:
+    case T3_CONFIG_PLIST:
+      for (item = config->value.list; item != NULL; item = item->next) {
+        hash = combine(hash, _t3_config_hash_value(item));
+      }
+      break;
+    case T3_CONFIG_SECTION:
+      /* The order of the items in a section is not significant, so the hashes of the items are
+         combined using a commutative operation. */
+      sum = 0;
+      for (item = config->value.list; item != NULL; item = item->next) {
+        item_hash = combine(_t3_config_hash_string64(item->name), _t3_config_hash_value(item));
+        sum += _t3_config_hash_mix(item_hash);
+      }
+      hash = combine(hash, sum);
+      break;
+    default:
+      break;
+  }
+  return hash;
+}
+
+uint64_t t3_config_hash(const t3_config_t *config) {
+  if (config == NULL) {
+    return 0;
+  }
+  return _t3_config_hash_value(config);
+}
+
+/** Check whether the stored hashes of @p a and @p b prove that they differ. */
+static t3_bool stored_hashes_differ(const t3_config_t *a, const t3_config_t *b) {
+  uint64_t hash_a, hash_b;
+  return stored_hash(a, &hash_a) && stored_hash(b, &hash_b) && hash_a != hash_b;
+}
+
+static t3_bool values_equal(const t3_config_t *a, const t3_config_t *b);
+
+/** Compare the items of two sections, without regard for the order of the items. */
+static t3_bool sections_equal(const t3_config_t *a, const t3_config_t *b) {
+  const t3_config_t *item, *other;
+  key_index_t index;
+  int length = 0;
+  t3_bool result = t3_true;
+
+  for (item = a->value.list; item != NULL; item = item->next) {
+    length++;
+  }
+  if (length != t3_config_get_length(b)) {
+    return t3_false;
+  }
+
+  /* Small sections are faster to compare by linear search than by building an index. If the
+     index can not be built for lack of memory, fall back to linear search as well. */
+  if (length <= 8 || !_t3_config_index_init_section(&index, b)) {
+    for (item = a->value.list; item != NULL; item = item->next) {
+      if ((other = t3_config_get(b, item->name)) == NULL ||
+          !values_equal(item, other)) {
+        return t3_false;
+      }
+    }
+    return t3_true;
+  }
+
+  for (item = a->value.list; item != NULL && result; item = item->next) {
+    other = *_t3_config_index_lookup_name(&index, item->name);
+    result = other != NULL && values_equal(item, other);
+  }
+  _t3_config_index_free(&index);
+  return result;
+}
+
+static t3_bool values_equal(const t3_config_t *a, const t3_config_t *b) {
+  if (a == b) {
+    return t3_true;
+  }
+  if (a->type != b->type || stored_hashes_differ(a, b)) {
+    return t3_false;
+  }
+
+  switch ((int)a->type) {
+    case T3_CONFIG_NONE:
+      return t3_true;
+    case T3_CONFIG_BOOL:
+      return a->value.boolean == b->value.boolean;
+    case T3_CONFIG_INT:
+      return a->value.integer == b->value.integer;
+    case T3_CONFIG_NUMBER:
+      return a->value.number == b->value.number;
+    case T3_CONFIG_STRING:
+      /* Strings shared by t3_config_dedup are trivially equal. */
+      if (STRING_VALUE(a) == NULL || STRING_VALUE(b) == NULL ||
+          STRING_VALUE(a) == STRING_VALUE(b)) {
+        return STRING_VALUE(a) == STRING_VALUE(b);
+      }
+      return strcmp(STRING_VALUE(a), STRING_VALUE(b)) == 0;
+    case T3_CONFIG_LIST:
+    case T3_CONFIG_PLIST:
+      /* Items shared through t3_config_clone are trivially equal. */
+      if (a->value.list == b->value.list) {
+        return t3_true;
+      }
+      for (a = a->value.list, b = b->value.list; a != NULL && b != NULL; a = a->next, b = b->next) {
+        if (!values_equal(a, b)) {
+          return t3_false;
+        }
+      }
+      return a == b;
+    case T3_CONFIG_SECTION:
+      return a->value.list == b->value.list || sections_equal(a, b);
+    default:
+      return t3_false;
+  }
+}
+
+t3_bool t3_config_equal(const t3_config_t *a, const t3_config_t *b) {
+  if (a == NULL || b == NULL) {
+    return a == b;
+  }
+  return values_equal(a, b);
+}
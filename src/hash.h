@@ -0,0 +1,42 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef T3_CONFIG_HASH_H
+#define T3_CONFIG_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config_api.h"
+#include "config_internal.h"
+
+/** Open addressing hash table of items, keyed by item name. */
+typedef struct {
+  t3_config_t **items;
+  size_t mask;
+} key_index_t;
+
+T3_CONFIG_LOCAL uint32_t _t3_config_hash_string(const char *str, size_t len);
+T3_CONFIG_LOCAL uint64_t _t3_config_hash_string64(const char *str);
+T3_CONFIG_LOCAL uint64_t _t3_config_hash_mix(uint64_t value);
+T3_CONFIG_LOCAL uint64_t _t3_config_hash_value(const t3_config_t *config);
+T3_CONFIG_LOCAL uint64_t _t3_config_compute_hash(const t3_config_t *config);
+T3_CONFIG_LOCAL t3_bool _t3_config_index_init(key_index_t *index, size_t count);
+T3_CONFIG_LOCAL t3_bool _t3_config_index_init_section(key_index_t *index,
+                                                      const t3_config_t *section);
+T3_CONFIG_LOCAL t3_config_t **_t3_config_index_lookup(const key_index_t *index, const char *name,
+                                                      size_t len);
+T3_CONFIG_LOCAL t3_config_t **_t3_config_index_lookup_name(const key_index_t *index,
+                                                           const char *name);
+T3_CONFIG_LOCAL void _t3_config_index_free(key_index_t *index);
+#endif
@@ -0,0 +1,643 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_internal.h"
+#include "freeze.h"
+#include "hash.h"
+#include "util.h"
+
+/* A config image is a frozen config (see freeze.h), in which all pointers have been replaced by
+   offsets from the start of the block, with 0 standing for NULL. The block is preceded by a
+   header and the names of the files the items were read from. As the items are stored as they
+   are in memory, an image can only be loaded on a machine with the same byte order and type
+   sizes as the one it was created on.
+
+   Images are normally loaded into newly allocated memory, but t3_config_load_static converts
+   an image in place, such that an image compiled into a program only needs memory to add its
+   file names to the file table. */
+
+#define IMAGE_MAGIC "T3CFGIMG"
+#define IMAGE_VERSION 1
+#define IMAGE_BYTE_ORDER UINT32_C(0x01020304)
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t pointer_size;
+  uint32_t item_size;
+  /* The number of file names, and the total size of the nul-terminated file names. The file
+     names are padded with nul bytes, such that the block is aligned like the header. */
+  uint32_t file_count;
+  uint32_t file_names_size;
+  /* The size of the block, and of the items and indices at the start of the block. */
+  uint64_t block_size;
+  uint64_t items_size;
+  /* One of the IMAGE_* states. Only images loaded by t3_config_load_static change state. */
+  uint32_t state;
+  uint32_t reserved;
+} image_header_t;
+
+#define IMAGE_UNLOADED 0
+#define IMAGE_LOADING 1
+#define IMAGE_LOADED 2
+#define IMAGE_INVALID 3
+
+#define TO_OFFSET(block, ptr) ((ptr) == NULL ? 0 : (uintptr_t)((const char *)(ptr) - (block)))
+#define FROM_OFFSET(ptr) ((uintptr_t)(ptr))
+
+typedef struct {
+  const char *block;
+  /* The file table indices of the files in the image, in order of first occurrence. */
+  uint16_t *files;
+  uint32_t file_count, files_allocated;
+} write_context_t;
+
+/** Retrieve the index in the image of the file with index @p file_index in the file table. */
+static int image_file_index(write_context_t *context, uint16_t file_index) {
+  uint16_t *files;
+  uint32_t i;
+
+  if (file_index == 0) {
+    return 0;
+  }
+  for (i = 0; i < context->file_count; i++) {
+    if (context->files[i] == file_index) {
+      return (int)i + 1;
+    }
+  }
+  if (context->file_count == context->files_allocated) {
+    context->files_allocated = context->files_allocated == 0 ? 16 : context->files_allocated * 2;
+    if ((files = _t3_config_mem_realloc(context->files,
+                                        context->files_allocated * sizeof(uint16_t))) == NULL) {
+      return -1;
+    }
+    context->files = files;
+  }
+  context->files[context->file_count++] = file_index;
+  return (int)context->file_count;
+}
+
+/** Replace all pointers in @p item and the items below it by offsets. */
+static int to_offsets(write_context_t *context, t3_config_t *item) {
+  frozen_index_t *index;
+  t3_config_t *items;
+  uint32_t i;
+  int file_index, error;
+
+  if ((file_index = image_file_index(context, item->file_index)) < 0) {
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+  item->file_index = (uint16_t)file_index;
+  /* The up pointers are set again when the image is loaded. */
+  item->flags &= T3_CONFIG_INLINE_STRING;
+  item->link.up = NULL;
+  item->next = NULL;
+  item->name = (char *)TO_OFFSET(context->block, item->name);
+
+  switch (item->type) {
+    case T3_CONFIG_STRING:
+      if (!(item->flags & T3_CONFIG_INLINE_STRING)) {
+        item->value.string = (char *)TO_OFFSET(context->block, item->value.string);
+      }
+      break;
+    case T3_CONFIG_LIST:
+    case T3_CONFIG_PLIST:
+    case T3_CONFIG_SECTION:
+      if ((items = item->value.list) == NULL) {
+        break;
+      }
+      index = (frozen_index_t *)INDEX(items);
+      for (i = 0; i < index->count; i++) {
+        if ((error = to_offsets(context, &items[i])) != T3_ERR_SUCCESS) {
+          return error;
+        }
+      }
+      index->displacements = (const uint32_t *)TO_OFFSET(context->block, index->displacements);
+      index->slots = (const uint32_t *)TO_OFFSET(context->block, index->slots);
+      item->value.list = (t3_config_t *)TO_OFFSET(context->block, items);
+      break;
+    default:
+      break;
+  }
+  return T3_ERR_SUCCESS;
+}
+
+int t3_config_write_image(const t3_config_t *config, FILE *file) {
+  write_context_t context;
+  static const char zeros[sizeof(uint64_t)];
+  image_header_t header;
+  t3_config_t *block;
+  size_t size, items_size, padding;
+  const char *file_name;
+  uint32_t i;
+  int error;
+
+  if (config == NULL || file == NULL) {
+    return T3_ERR_BAD_ARG;
+  }
+
+  /* The pointers are replaced in a private frozen copy. */
+  if ((block = _t3_config_freeze_block(config, &size, &items_size, &error)) == NULL) {
+    return error;
+  }
+
+  context.block = (const char *)block;
+  context.files = NULL;
+  context.file_count = 0;
+  context.files_allocated = 0;
+  if ((error = to_offsets(&context, block)) != T3_ERR_SUCCESS) {
+    goto end;
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+  header.version = IMAGE_VERSION;
+  header.byte_order = IMAGE_BYTE_ORDER;
+  header.pointer_size = sizeof(void *);
+  header.item_size = ITEM_SIZE;
+  header.file_count = context.file_count;
+  for (i = 0; i < context.file_count; i++) {
+    header.file_names_size += strlen(_t3_config_file_name(context.files[i])) + 1;
+  }
+  padding = ALIGN(header.file_names_size) - header.file_names_size;
+  header.file_names_size += padding;
+  header.block_size = size;
+  header.items_size = items_size;
+
+  error = T3_ERR_ERRNO;
+  if (fwrite(&header, sizeof(header), 1, file) != 1) {
+    goto end;
+  }
+  for (i = 0; i < context.file_count; i++) {
+    file_name = _t3_config_file_name(context.files[i]);
+    if (fwrite(file_name, strlen(file_name) + 1, 1, file) != 1) {
+      goto end;
+    }
+  }
+  if ((padding > 0 && fwrite(zeros, padding, 1, file) != 1) || fwrite(block, size, 1, file) != 1) {
+    goto end;
+  }
+  error = T3_ERR_SUCCESS;
+
+end:
+  _t3_config_mem_free(context.files);
+  _t3_config_mem_free(block);
+  return error;
+}
+
+typedef struct {
+  char *block;
+  size_t block_size, items_size;
+  /* The position in the block where the next list of items must start. */
+  size_t cursor;
+  /* The file names stored in the image. */
+  const char *file_names;
+  uint32_t file_count;
+  /* The most recently mapped file, as items from the same file are mostly stored together. */
+  uint16_t last_image_file, last_file_index;
+} read_context_t;
+
+/** Replace the index in the image of the file of @p item by its index in the file table. */
+static t3_bool map_file_index(read_context_t *context, t3_config_t *item) {
+  const char *file_name;
+  uint16_t i;
+
+  if (item->file_index == 0) {
+    return t3_true;
+  }
+  if (item->file_index > context->file_count) {
+    return t3_false;
+  }
+  if (item->file_index != context->last_image_file) {
+    for (i = 1, file_name = context->file_names; i < item->file_index; i++) {
+      file_name += strlen(file_name) + 1;
+    }
+    /* All file names were added by intern_file_names, so they can always be found. The items
+       only get their references to the file names once the whole image has been loaded. */
+    context->last_file_index = _t3_config_find_file_name(file_name);
+    context->last_image_file = item->file_index;
+  }
+  item->file_index = context->last_file_index;
+  return t3_true;
+}
+
+/** Check that @p offset refers to a nul-terminated string after the items of the block. */
+static t3_bool valid_string(const read_context_t *context, uintptr_t offset) {
+  return offset >= context->items_size && offset < context->block_size &&
+         memchr(context->block + offset, 0, context->block_size - offset) != NULL;
+}
+
+/** Check that @p offset refers to a name record as created by ::t3_config_freeze. */
+static t3_bool valid_name(const read_context_t *context, uintptr_t offset) {
+  const shared_string_t *record;
+  size_t record_offset;
+
+  if (offset < context->items_size + offsetof(shared_string_t, str) ||
+      offset >= context->block_size) {
+    return t3_false;
+  }
+  record_offset = offset - offsetof(shared_string_t, str);
+  if (record_offset % sizeof(uint32_t) != 0) {
+    return t3_false;
+  }
+  record = (const shared_string_t *)(context->block + record_offset);
+  return record->count == -1 && record->length < context->block_size - offset &&
+         record->str[record->length] == 0 && strlen(record->str) == record->length &&
+         record->hash == _t3_config_hash_string(record->str, record->length);
+}
+
+/** Check that @p offset refers to a table of @p count entries after the items of the block. */
+static t3_bool valid_table(const read_context_t *context, uintptr_t offset, uint32_t count) {
+  return offset >= context->items_size && offset % sizeof(uint32_t) == 0 &&
+         offset <= context->block_size &&
+         (context->block_size - offset) / sizeof(uint32_t) >= count;
+}
+
+/** Validate the index of the list of items at offset @p offset, and replace the offsets in it by
+    pointers.
+    @return The index, or @c NULL if it is invalid.
+*/
+static frozen_index_t *load_index(read_context_t *context, uintptr_t offset) {
+  frozen_index_t *index;
+  uintptr_t displacements, slots;
+  uint32_t i;
+
+  /* The lists of items are stored in the order in which they are visited. */
+  if (offset != context->cursor + INDEX_SIZE || offset > context->items_size) {
+    return NULL;
+  }
+  index = (frozen_index_t *)(context->block + context->cursor);
+  if (index->count == 0 || (context->items_size - offset) / ITEM_SIZE < index->count) {
+    return NULL;
+  }
+  context->cursor = offset + index->count * ITEM_SIZE;
+
+  displacements = FROM_OFFSET(index->displacements);
+  slots = FROM_OFFSET(index->slots);
+  if ((displacements == 0) != (slots == 0)) {
+    return NULL;
+  }
+  if (displacements == 0) {
+    index->buckets = 0;
+    return index;
+  }
+  if (index->buckets == 0 || !valid_table(context, displacements, index->buckets) ||
+      !valid_table(context, slots, index->count)) {
+    return NULL;
+  }
+  index->displacements = (const uint32_t *)(context->block + displacements);
+  index->slots = (const uint32_t *)(context->block + slots);
+  for (i = 0; i < index->count; i++) {
+    if (index->slots[i] >= index->count) {
+      return NULL;
+    }
+  }
+  return index;
+}
+
+/** Validate @p item and the items below it, and replace the offsets in them by pointers. */
+static t3_bool load_item(read_context_t *context, t3_config_t *item, t3_bool in_section) {
+  frozen_index_t *index;
+  t3_config_t *items;
+  uintptr_t offset;
+  uint32_t i;
+
+  if (item->flags & ~T3_CONFIG_INLINE_STRING) {
+    return t3_false;
+  }
+  item->flags |= T3_CONFIG_FROZEN;
+  item->link.up = NULL;
+  item->next = NULL;
+
+  if (!map_file_index(context, item)) {
+    return t3_false;
+  }
+
+  offset = FROM_OFFSET(item->name);
+  if (offset == 0) {
+    /* Items in sections are found by name, so they must have one. */
+    if (in_section) {
+      return t3_false;
+    }
+  } else if (!valid_name(context, offset)) {
+    return t3_false;
+  } else {
+    item->name = context->block + offset;
+  }
+
+  switch (item->type) {
+    case T3_CONFIG_NONE:
+    case T3_CONFIG_BOOL:
+    case T3_CONFIG_INT:
+    case T3_CONFIG_NUMBER:
+      break;
+    case T3_CONFIG_STRING:
+      if (item->flags & T3_CONFIG_INLINE_STRING) {
+        return memchr(item->value.short_string, 0, sizeof(item->value.short_string)) != NULL;
+      }
+      if (!valid_string(context, offset = FROM_OFFSET(item->value.string))) {
+        return t3_false;
+      }
+      item->value.string = context->block + offset;
+      break;
+    case T3_CONFIG_LIST:
+    case T3_CONFIG_PLIST:
+    case T3_CONFIG_SECTION:
+      if ((offset = FROM_OFFSET(item->value.list)) == 0) {
+        break;
+      }
+      if ((index = load_index(context, offset)) == NULL) {
+        return t3_false;
+      }
+      /* Only sections have perfect hash tables. */
+      if (index->displacements != NULL && item->type != T3_CONFIG_SECTION) {
+        return t3_false;
+      }
+      items = (t3_config_t *)(context->block + offset);
+      item->value.list = items;
+      for (i = 0; i < index->count; i++) {
+        if (!load_item(context, &items[i], item->type == T3_CONFIG_SECTION)) {
+          return t3_false;
+        }
+        items[i].next = i + 1 < index->count ? &items[i + 1] : NULL;
+      }
+      _t3_config_link_items(item);
+      break;
+    default:
+      return t3_false;
+  }
+  return (item->flags & T3_CONFIG_INLINE_STRING) == 0;
+}
+
+/** Copy the header of the image in @p buffer to @p header, and check it and the file names
+    following it.
+*/
+static t3_bool check_header(const void *buffer, size_t size, image_header_t *header) {
+  const char *file_names = (const char *)buffer + sizeof(image_header_t), *file_name;
+  uint32_t i;
+
+  if (size < sizeof(image_header_t)) {
+    return t3_false;
+  }
+  memcpy(header, buffer, sizeof(image_header_t));
+  if (memcmp(header->magic, IMAGE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != IMAGE_VERSION || header->byte_order != IMAGE_BYTE_ORDER ||
+      header->pointer_size != sizeof(void *) || header->item_size != ITEM_SIZE) {
+    return t3_false;
+  }
+  if (header->file_names_size > size - sizeof(image_header_t) ||
+      header->file_names_size != ALIGN(header->file_names_size) ||
+      header->block_size != size - sizeof(image_header_t) - header->file_names_size ||
+      header->items_size < ITEM_SIZE || header->items_size > header->block_size) {
+    return t3_false;
+  }
+
+  if (header->file_count > UINT16_MAX ||
+      (header->file_names_size > 0 && file_names[header->file_names_size - 1] != 0)) {
+    return t3_false;
+  }
+  for (i = 0, file_name = file_names; i < header->file_count; i++) {
+    if (file_name >= file_names + header->file_names_size) {
+      return t3_false;
+    }
+    file_name += strlen(file_name) + 1;
+  }
+  return t3_true;
+}
+
+/** Release the references to the first @p count file names of an image, as added by
+    intern_file_names. */
+static void release_file_names(const char *file_names, uint32_t count) {
+  uint32_t i;
+
+  for (i = 0; i < count; i++) {
+    _t3_config_release_file_name(_t3_config_find_file_name(file_names));
+    file_names += strlen(file_names) + 1;
+  }
+}
+
+/** Add the file names of an image to the file table, before any of its items are converted.
+    Converting the items then only has to look up the file names, which can not fail. A reference
+    to each name is held until release_file_names is called. */
+static int intern_file_names(const image_header_t *header, const char *file_names) {
+  const char *file_name = file_names;
+  uint16_t file_index;
+  uint32_t i;
+  int error;
+
+  for (i = 0; i < header->file_count; i++) {
+    if ((error = _t3_config_intern_file_name(file_name, &file_index)) != T3_ERR_SUCCESS) {
+      release_file_names(file_names, i);
+      return error;
+    }
+    file_name += strlen(file_name) + 1;
+  }
+  return T3_ERR_SUCCESS;
+}
+
+/** Validate the items in @p block, and replace the offsets in them by pointers. */
+static t3_bool load_block(const image_header_t *header, const char *file_names, char *block) {
+  read_context_t context;
+
+  context.block = block;
+  context.block_size = header->block_size;
+  context.items_size = header->items_size;
+  context.cursor = ITEM_SIZE;
+  context.file_names = file_names;
+  context.file_count = header->file_count;
+  context.last_image_file = 0;
+  context.last_file_index = 0;
+
+  if (!load_item(&context, (t3_config_t *)block, t3_false) ||
+      context.cursor != context.items_size) {
+    return t3_false;
+  }
+  _t3_config_make_top_level((t3_config_t *)block);
+  return t3_true;
+}
+
+t3_config_t *t3_config_read_image_buffer(const void *buffer, size_t size, int *error) {
+  image_header_t header;
+  const char *file_names;
+  char *block;
+  int local_error = T3_ERR_INVALID_IMAGE;
+
+  if (buffer == NULL) {
+    local_error = T3_ERR_BAD_ARG;
+    goto error_end;
+  }
+  if (!check_header(buffer, size, &header) || header.state != IMAGE_UNLOADED) {
+    goto error_end;
+  }
+  file_names = (const char *)buffer + sizeof(image_header_t);
+  if ((local_error = intern_file_names(&header, file_names)) != T3_ERR_SUCCESS) {
+    goto error_end;
+  }
+
+  if ((block = _t3_config_mem_alloc(header.block_size)) == NULL) {
+    local_error = T3_ERR_OUT_OF_MEMORY;
+    goto release_end;
+  }
+  memcpy(block, file_names + header.file_names_size, header.block_size);
+  if (!load_block(&header, file_names, block)) {
+    _t3_config_mem_free(block);
+    local_error = T3_ERR_INVALID_IMAGE;
+    goto release_end;
+  }
+  ((t3_config_t *)block)->flags |= T3_CONFIG_FROZEN_ROOT;
+  /* Like the items of other frozen configs, each item refers to its file name until the config is
+     deleted. */
+  _t3_config_visit_file_names((t3_config_t *)block, _t3_config_ref_file_name);
+  release_file_names(file_names, header.file_count);
+  return (t3_config_t *)block;
+
+release_end:
+  release_file_names(file_names, header.file_count);
+error_end:
+  if (error != NULL) {
+    *error = local_error;
+  }
+  return NULL;
+}
+
+t3_config_t *t3_config_load_static(void *image, size_t size, int *error) {
+  image_header_t header, *state_header = image;
+  uint32_t state = IMAGE_UNLOADED;
+  const char *file_names;
+  char *block;
+  int local_error;
+
+  if (image == NULL || (uintptr_t)image % sizeof(uint64_t) != 0) {
+    if (error != NULL) {
+      *error = T3_ERR_BAD_ARG;
+    }
+    return NULL;
+  }
+  /* Once loaded, the image no longer needs to be checked. */
+  if (size >= sizeof(image_header_t) &&
+#ifdef __GNUC__
+      __atomic_load_n(&state_header->state, __ATOMIC_ACQUIRE) == IMAGE_LOADED
+#else
+      state_header->state == IMAGE_LOADED
+#endif
+  ) {
+    return (t3_config_t *)((char *)image + sizeof(image_header_t) + state_header->file_names_size);
+  }
+
+  if (!check_header(image, size, &header) || header.state > IMAGE_INVALID) {
+    goto invalid;
+  }
+  file_names = (const char *)image + sizeof(image_header_t);
+  block = (char *)file_names + header.file_names_size;
+  /* The file names are added first, such that running out of memory leaves the image unchanged
+     and the call can be retried. The state of an image never returns to IMAGE_UNLOADED, so a
+     caller seeing another state here will not convert the image. */
+  if (header.state == IMAGE_UNLOADED &&
+      (local_error = intern_file_names(&header, file_names)) != T3_ERR_SUCCESS) {
+    if (error != NULL) {
+      *error = local_error;
+    }
+    return NULL;
+  }
+
+  /* The first caller converts the image, while any concurrent callers wait for it to finish. */
+#ifdef __GNUC__
+  while (!__atomic_compare_exchange_n(&state_header->state, &state, IMAGE_LOADING, 0,
+                                      __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+    if (state == IMAGE_LOADED || state == IMAGE_INVALID) {
+      break;
+    }
+    state = IMAGE_UNLOADED;
+  }
+#else
+  if ((state = state_header->state) == IMAGE_UNLOADED) {
+    state_header->state = IMAGE_LOADING;
+  }
+#endif
+
+  if (state == IMAGE_UNLOADED) {
+    /* A failed conversion leaves the image partly converted, so it can not be retried. */
+    state = load_block(&header, file_names, block) ? IMAGE_LOADED : IMAGE_INVALID;
+#ifdef __GNUC__
+    __atomic_store_n(&state_header->state, state, __ATOMIC_RELEASE);
+#else
+    state_header->state = state;
+#endif
+    /* The loaded image is never released, so its references to the file names are kept, rather
+       than adding a reference for each item. */
+    if (state == IMAGE_LOADED) {
+      return (t3_config_t *)block;
+    }
+    release_file_names(file_names, header.file_count);
+  } else if (header.state == IMAGE_UNLOADED) {
+    /* Another caller converted the image, and holds the references to the file names. */
+    release_file_names(file_names, header.file_count);
+  }
+
+  if (state == IMAGE_LOADED) {
+    return (t3_config_t *)block;
+  }
+
+invalid:
+  if (error != NULL) {
+    *error = T3_ERR_INVALID_IMAGE;
+  }
+  return NULL;
+}
+
+t3_config_t *t3_config_read_image(FILE *file, int *error) {
+  char *buffer = NULL, *new_buffer;
+  size_t size = 0, allocated = 0, bytes_read;
+  t3_config_t *result;
+
+  if (file == NULL) {
+    if (error != NULL) {
+      *error = T3_ERR_BAD_ARG;
+    }
+    return NULL;
+  }
+
+  do {
+    if (size == allocated) {
+      allocated = allocated == 0 ? 4096 : allocated * 2;
+      if ((new_buffer = _t3_config_mem_realloc(buffer, allocated)) == NULL) {
+        _t3_config_mem_free(buffer);
+        if (error != NULL) {
+          *error = T3_ERR_OUT_OF_MEMORY;
+        }
+        return NULL;
+      }
+      buffer = new_buffer;
+    }
+    bytes_read = fread(buffer + size, 1, allocated - size, file);
+    size += bytes_read;
+  } while (bytes_read > 0);
+
+  if (ferror(file)) {
+    _t3_config_mem_free(buffer);
+    if (error != NULL) {
+      *error = T3_ERR_ERRNO;
+    }
+    return NULL;
+  }
+
+  result = t3_config_read_image_buffer(buffer, size, error);
+  _t3_config_mem_free(buffer);
+  return result;
+}
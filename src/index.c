@@ -0,0 +1,186 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <string.h>
+
+#include "config_internal.h"
+#include "hash.h"
+#include "util.h"
+
+typedef struct {
+  /* The item in the list, or NULL for an empty slot. */
+  t3_config_t *item;
+  /* The value of the key in item. */
+  const t3_config_t *key;
+  uint32_t hash;
+} index_slot_t;
+
+struct t3_config_index_t {
+  const t3_config_t *list;
+  char *key;
+  /* The generation of the config containing list when the slots were filled (see
+     _t3_config_generation). When any item in that config is modified, its generation changes and
+     the slots are filled again on the next lookup. */
+  uint64_t generation;
+  index_slot_t *slots;
+  size_t mask;
+};
+
+static uint32_t hash_string(const char *str) { return _t3_config_hash_string(str, strlen(str)); }
+
+static uint32_t hash_int(int64_t value) { return (uint32_t)_t3_config_hash_mix((uint64_t)value); }
+
+static t3_bool key_matches(const t3_config_t *key, t3_config_type_t type, const char *str,
+                           int64_t value) {
+  if (key->type != type) {
+    return t3_false;
+  }
+  return type == T3_CONFIG_STRING ? strcmp(STRING_VALUE(key), str) == 0
+                                  : key->value.integer == value;
+}
+
+/** Find the slot for the key value @p str or @p value, depending on @p type.
+    @return The slot containing the matching item, or the empty slot where it should be stored.
+*/
+static index_slot_t *find_slot(const t3_config_index_t *index, t3_config_type_t type,
+                               const char *str, int64_t value, uint32_t hash) {
+  size_t i = hash & index->mask;
+
+  for (; index->slots[i].item != NULL; i = (i + 1) & index->mask) {
+    if (index->slots[i].hash == hash && key_matches(index->slots[i].key, type, str, value)) {
+      break;
+    }
+  }
+  return &index->slots[i];
+}
+
+/** Fill the slots of @p index from the items in its list.
+    If a key value occurs more than once, the first item with that value is stored.
+*/
+static t3_bool build(t3_config_index_t *index) {
+  const t3_config_t *key;
+  t3_config_t *item;
+  index_slot_t *slot;
+  size_t size = 8, count = (size_t)t3_config_get_length(index->list);
+  uint32_t hash;
+
+  /* Keep the load factor at or below 0.5 to keep the probe sequences short. */
+  while (size < 2 * count) {
+    size <<= 1;
+  }
+  if (index->slots == NULL || index->mask + 1 != size) {
+    _t3_config_mem_free(index->slots);
+    if ((index->slots = _t3_config_mem_alloc(size * sizeof(index_slot_t))) == NULL) {
+      index->mask = 0;
+      return t3_false;
+    }
+    index->mask = size - 1;
+  }
+  memset(index->slots, 0, size * sizeof(index_slot_t));
+
+  for (item = index->list->value.list; item != NULL; item = item->next) {
+    if ((key = t3_config_get(item, index->key)) == NULL) {
+      continue;
+    }
+    if (key->type == T3_CONFIG_STRING) {
+      hash = hash_string(STRING_VALUE(key));
+      slot = find_slot(index, T3_CONFIG_STRING, STRING_VALUE(key), 0, hash);
+    } else if (key->type == T3_CONFIG_INT) {
+      hash = hash_int(key->value.integer);
+      slot = find_slot(index, T3_CONFIG_INT, NULL, key->value.integer, hash);
+    } else {
+      continue;
+    }
+    if (slot->item == NULL) {
+      slot->item = item;
+      slot->key = key;
+      slot->hash = hash;
+    }
+  }
+  index->generation = _t3_config_generation(index->list);
+  return t3_true;
+}
+
+t3_config_index_t *t3_config_index_by(const t3_config_t *list, const char *key, int *error) {
+  t3_config_index_t *result;
+
+  if (list == NULL || (list->type != T3_CONFIG_LIST && list->type != T3_CONFIG_PLIST) ||
+      key == NULL) {
+    if (error != NULL) {
+      *error = T3_ERR_BAD_ARG;
+    }
+    return NULL;
+  }
+
+  if ((result = _t3_config_mem_alloc(sizeof(t3_config_index_t))) == NULL) {
+    goto out_of_memory;
+  }
+  result->list = list;
+  result->slots = NULL;
+  if ((result->key = _t3_config_strdup(key)) == NULL) {
+    _t3_config_mem_free(result);
+    goto out_of_memory;
+  }
+  if (!build(result)) {
+    t3_config_index_delete(result);
+    goto out_of_memory;
+  }
+  return result;
+
+out_of_memory:
+  if (error != NULL) {
+    *error = T3_ERR_OUT_OF_MEMORY;
+  }
+  return NULL;
+}
+
+void t3_config_index_delete(t3_config_index_t *index) {
+  if (index == NULL) {
+    return;
+  }
+  _t3_config_mem_free(index->slots);
+  _t3_config_mem_free(index->key);
+  _t3_config_mem_free(index);
+}
+
+/** Look up a key value in @p index, rebuilding it first if its list was modified. */
+static t3_config_t *index_get(t3_config_index_t *index, t3_config_type_t type, const char *str,
+                              int64_t value, uint32_t hash) {
+  const t3_config_t *key;
+  t3_config_t *item;
+
+  if (index->generation != _t3_config_generation(index->list) && !build(index)) {
+    /* Without memory for the index, fall back to searching the list. */
+    for (item = index->list->value.list; item != NULL; item = item->next) {
+      if ((key = t3_config_get(item, index->key)) != NULL && key_matches(key, type, str, value)) {
+        return item;
+      }
+    }
+    return NULL;
+  }
+  return find_slot(index, type, str, value, hash)->item;
+}
+
+t3_config_t *t3_config_index_get(t3_config_index_t *index, const char *value) {
+  if (index == NULL || value == NULL) {
+    return NULL;
+  }
+  return index_get(index, T3_CONFIG_STRING, value, 0, hash_string(value));
+}
+
+t3_config_t *t3_config_index_get_int(t3_config_index_t *index, int64_t value) {
+  if (index == NULL) {
+    return NULL;
+  }
+  return index_get(index, T3_CONFIG_INT, NULL, value, hash_int(value));
+}
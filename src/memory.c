@@ -0,0 +1,209 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_internal.h"
+#include "expression.h"
+#include "hash.h"
+#include "util.h"
+
+typedef struct {
+  t3_config_memory_t *usage;
+  /* Hash table of the shared names, strings and lists of items counted so far. */
+  const void **seen;
+  size_t seen_mask, seen_count;
+} measure_context_t;
+
+/** Double the size of the table of shared memory blocks counted so far. */
+static t3_bool grow_seen(measure_context_t *context) {
+  size_t size = context->seen == NULL ? 64 : (context->seen_mask + 1) * 2, i, j;
+  const void **seen;
+
+  if ((seen = _t3_config_mem_calloc(size, sizeof(void *))) == NULL) {
+    return t3_false;
+  }
+  if (context->seen != NULL) {
+    for (i = 0; i <= context->seen_mask; i++) {
+      if (context->seen[i] == NULL) {
+        continue;
+      }
+      j = _t3_config_hash_mix((uintptr_t)context->seen[i]) & (size - 1);
+      while (seen[j] != NULL) {
+        j = (j + 1) & (size - 1);
+      }
+      seen[j] = context->seen[i];
+    }
+    _t3_config_mem_free(context->seen);
+  }
+  context->seen = seen;
+  context->seen_mask = size - 1;
+  return t3_true;
+}
+
+/** Record that the memory at @p ptr has been counted.
+    @return ::T3_ERR_SUCCESS if @p ptr had not been counted yet, @c 1 if it had, or
+        ::T3_ERR_OUT_OF_MEMORY.
+*/
+static int first_visit(measure_context_t *context, const void *ptr) {
+  size_t i;
+
+  if (context->seen == NULL || 2 * (context->seen_count + 1) > context->seen_mask + 1) {
+    if (!grow_seen(context)) {
+      return T3_ERR_OUT_OF_MEMORY;
+    }
+  }
+
+  for (i = _t3_config_hash_mix((uintptr_t)ptr) & context->seen_mask; context->seen[i] != NULL;
+       i = (i + 1) & context->seen_mask) {
+    if (context->seen[i] == ptr) {
+      return 1;
+    }
+  }
+  context->seen[i] = ptr;
+  context->seen_count++;
+  return T3_ERR_SUCCESS;
+}
+
+/** Count the memory used by a string record, unless it was counted before. */
+static int measure_record(measure_context_t *context, const char *str, size_t *bytes) {
+  int result;
+
+  if (str == NULL) {
+    return T3_ERR_SUCCESS;
+  }
+  if ((result = first_visit(context, STRING_RECORD(str))) == T3_ERR_SUCCESS) {
+    *bytes += STRING_RECORD_SIZE(STRING_RECORD(str)->length);
+  }
+  return result < 0 ? result : T3_ERR_SUCCESS;
+}
+
+static size_t measure_expr(const expr_node_t *expr) {
+  size_t bytes;
+
+  if (expr == NULL) {
+    return 0;
+  }
+  bytes = sizeof(expr_node_t);
+  switch (expr->type) {
+    case EXPR_TOP:
+    case EXPR_AND:
+    case EXPR_OR:
+    case EXPR_XOR:
+    case EXPR_EQ:
+    case EXPR_NE:
+    case EXPR_LT:
+    case EXPR_LE:
+    case EXPR_GT:
+    case EXPR_GE:
+    case EXPR_PATH:
+    case EXPR_LIST:
+      bytes += measure_expr(expr->value.operand[0]);
+      bytes += measure_expr(expr->value.operand[1]);
+      break;
+    case EXPR_NOT:
+    case EXPR_DEREF:
+    case EXPR_LENGTH:
+      bytes += measure_expr(expr->value.operand[0]);
+      break;
+    case EXPR_STRING_CONST:
+    case EXPR_IDENT:
+      /* The description of a constraint is stored as a string constant, which is NULL if the
+         constraint has no description. */
+      if (expr->value.string != NULL) {
+        bytes += strlen(expr->value.string) + 1;
+      }
+      break;
+    default:
+      break;
+  }
+  return bytes;
+}
+
+static int measure_item(measure_context_t *context, const t3_config_t *config) {
+  t3_config_memory_t *usage = context->usage;
+  const t3_config_t *item;
+  int result;
+
+  usage->items++;
+  usage->item_bytes += sizeof(t3_config_t);
+  if ((result = measure_record(context, config->name, &usage->name_bytes)) != T3_ERR_SUCCESS) {
+    return result;
+  }
+
+  switch ((int)config->type) {
+    case T3_CONFIG_STRING:
+      if ((config->flags & T3_CONFIG_INLINE_STRING) || config->value.string == NULL) {
+        return T3_ERR_SUCCESS;
+      }
+      if (config->flags & T3_CONFIG_SHARED_STRING) {
+        return measure_record(context, config->value.string, &usage->string_bytes);
+      }
+      usage->string_bytes += strlen(config->value.string) + 1;
+      return T3_ERR_SUCCESS;
+    case T3_CONFIG_LIST:
+    case T3_CONFIG_PLIST:
+    case T3_CONFIG_SECTION:
+    case T3_CONFIG_SCHEMA:
+      if (config->value.list == NULL) {
+        return T3_ERR_SUCCESS;
+      }
+      if (config->flags & T3_CONFIG_FROZEN) {
+        usage->index_bytes += _t3_config_frozen_index_size(config);
+      } else if (_t3_config_is_shared(config->value.list)) {
+        /* A list shared through t3_config_clone or t3_config_dedup is counted only once. */
+        if ((result = first_visit(context, config->value.list)) != T3_ERR_SUCCESS) {
+          return result < 0 ? result : T3_ERR_SUCCESS;
+        }
+      }
+      for (item = config->value.list; item != NULL; item = item->next) {
+        if ((result = measure_item(context, item)) != T3_ERR_SUCCESS) {
+          return result;
+        }
+      }
+      return T3_ERR_SUCCESS;
+    case T3_CONFIG_EXPRESSION:
+      usage->expression_bytes += measure_expr(config->value.expr);
+      return T3_ERR_SUCCESS;
+    default:
+      return T3_ERR_SUCCESS;
+  }
+}
+
+int t3_config_memory_usage(const t3_config_t *config, t3_config_memory_t *usage) {
+  measure_context_t context;
+  int error;
+
+  if (config == NULL || usage == NULL) {
+    return T3_ERR_BAD_ARG;
+  }
+
+  memset(usage, 0, sizeof(t3_config_memory_t));
+  context.usage = usage;
+  context.seen = NULL;
+  context.seen_mask = 0;
+  context.seen_count = 0;
+
+  error = measure_item(&context, config);
+  _t3_config_mem_free(context.seen);
+
+  usage->total_bytes = usage->item_bytes + usage->name_bytes + usage->string_bytes +
+                       usage->expression_bytes + usage->index_bytes;
+  return error;
+}
+
+int t3_config_schema_memory_usage(const t3_config_schema_t *schema, t3_config_memory_t *usage) {
+  return t3_config_memory_usage((const t3_config_t *)schema, usage);
+}
@@ -0,0 +1,162 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_internal.h"
+#include "hash.h"
+
+static t3_bool is_aggregate(const t3_config_t *config) {
+  return config->type == T3_CONFIG_SECTION || config->type == T3_CONFIG_LIST ||
+         config->type == T3_CONFIG_PLIST;
+}
+
+/** Check whether values of @p type are combined rather than replaced, given @p flags. */
+static t3_bool combines(t3_config_type_t type, int flags) {
+  switch (type) {
+    case T3_CONFIG_SECTION:
+      return !(flags & T3_CONFIG_MERGE_REPLACE_SECTIONS);
+    case T3_CONFIG_LIST:
+      return (flags & T3_CONFIG_MERGE_APPEND_LISTS) != 0;
+    case T3_CONFIG_PLIST:
+      return !(flags & T3_CONFIG_MERGE_REPLACE_PLISTS);
+    default:
+      return t3_false;
+  }
+}
+
+/** Return the location of the @c next pointer of the last item in @p config. */
+static t3_config_t **find_tail(t3_config_t *config) {
+  t3_config_t **next_ptr = &config->value.list;
+  while (*next_ptr != NULL) {
+    next_ptr = &(*next_ptr)->next;
+  }
+  return next_ptr;
+}
+
+/** Detach the list of items from @p config, such that they can be moved elsewhere.
+    The detached list is stored in @p items. If the list was shared, the items are copied first.
+*/
+static int take_items(t3_config_t *config, t3_config_t **items) {
+  int error;
+  if ((error = _t3_config_unshare(config)) != T3_ERR_SUCCESS) {
+    return error;
+  }
+  *items = config->value.list;
+  config->value.list = NULL;
+  return T3_ERR_SUCCESS;
+}
+
+static int merge_aggregate(t3_config_t *dest, t3_config_t *src, int flags);
+
+/** Merge the list of named @p items into the section @p dest. @p items is consumed. */
+static int merge_section(t3_config_t *dest, t3_config_t *items, int flags) {
+  t3_config_t **tail, **slot, *item, *next, *existing;
+  key_index_t index;
+  int error = T3_ERR_SUCCESS;
+
+  if ((error = _t3_config_unshare(dest)) != T3_ERR_SUCCESS ||
+      !_t3_config_index_init_section(&index, dest)) {
+    t3_config_delete(items);
+    return error != T3_ERR_SUCCESS ? error : T3_ERR_OUT_OF_MEMORY;
+  }
+  tail = find_tail(dest);
+
+  for (item = items; item != NULL; item = next) {
+    next = item->next;
+    /* Make the item top-level, as the first item of items still refers to its deleted owner. */
+    item->next = NULL;
+    _t3_config_make_top_level(item);
+
+    if (error != T3_ERR_SUCCESS) {
+      /* Release the remaining items after an error. */
+      t3_config_delete(item);
+      continue;
+    }
+
+    slot = _t3_config_index_lookup_name(&index, item->name);
+    if ((existing = *slot) == NULL) {
+      *slot = item;
+      *tail = item;
+      tail = &item->next;
+    } else if (existing->type == item->type && combines(item->type, flags)) {
+      error = merge_aggregate(existing, item, flags);
+    } else if (flags & T3_CONFIG_MERGE_KEEP_EXISTING) {
+      t3_config_delete(item);
+    } else {
+      _t3_config_replace_value(existing, item);
+    }
+  }
+  _t3_config_link_items(dest);
+  _t3_config_modified(dest);
+  _t3_config_index_free(&index);
+  return error;
+}
+
+/** Merge the aggregate @p src into @p dest, which has the same type. @p src is deleted. */
+static int merge_aggregate(t3_config_t *dest, t3_config_t *src, int flags) {
+  t3_config_t *items;
+  int error;
+
+  error = take_items(src, &items);
+  t3_config_delete(src);
+  if (error != T3_ERR_SUCCESS) {
+    return error;
+  }
+
+  if (dest->type == T3_CONFIG_SECTION) {
+    return merge_section(dest, items, flags);
+  }
+
+  /* Lists are simply concatenated. */
+  if ((error = _t3_config_unshare(dest)) != T3_ERR_SUCCESS) {
+    t3_config_delete(items);
+    return error;
+  }
+  *find_tail(dest) = items;
+  _t3_config_link_items(dest);
+  _t3_config_modified(dest);
+  return T3_ERR_SUCCESS;
+}
+
+int t3_config_merge(t3_config_t *dest, t3_config_t *src, int flags) {
+  t3_config_t *items;
+  int error;
+
+  if (dest == NULL || src == NULL || dest == src || src->next != NULL || !IS_TOP_LEVEL(src) ||
+      dest->type != src->type || !is_aggregate(dest) ||
+      ((dest->flags | src->flags) & T3_CONFIG_FROZEN)) {
+    return T3_ERR_BAD_ARG;
+  }
+  if ((dest = _t3_config_writable(dest, &error)) == NULL) {
+    return error;
+  }
+
+  /* At the top level, sections are always merged. */
+  if (dest->type == T3_CONFIG_SECTION || combines(dest->type, flags)) {
+    return merge_aggregate(dest, src, flags);
+  }
+
+  /* Replace the list in dest by the list in src. */
+  if ((error = take_items(src, &items)) != T3_ERR_SUCCESS) {
+    t3_config_delete(src);
+    return error;
+  }
+  t3_config_delete(src);
+  _t3_config_delete_items(dest);
+  dest->value.list = items;
+  _t3_config_link_items(dest);
+  _t3_config_modified(dest);
+  return T3_ERR_SUCCESS;
+}
@@ -0,0 +1,377 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_internal.h"
+#include "hash.h"
+#include "util.h"
+
+struct t3_config_overlay_t {
+  /* The layers, with the bottom layer first. */
+  const t3_config_t **layers;
+  int count, size;
+};
+
+t3_config_overlay_t *t3_config_overlay_new(void) {
+  t3_config_overlay_t *result;
+
+  if ((result = _t3_config_mem_alloc(sizeof(t3_config_overlay_t))) == NULL) {
+    return NULL;
+  }
+  result->layers = NULL;
+  result->count = 0;
+  result->size = 0;
+  return result;
+}
+
+void t3_config_overlay_delete(t3_config_overlay_t *overlay) {
+  if (overlay == NULL) {
+    return;
+  }
+  _t3_config_mem_free(overlay->layers);
+  _t3_config_mem_free(overlay);
+}
+
+int t3_config_overlay_push(t3_config_overlay_t *overlay, const t3_config_t *layer) {
+  if (overlay == NULL || layer == NULL || layer->type != T3_CONFIG_SECTION) {
+    return T3_ERR_BAD_ARG;
+  }
+
+  if (overlay->count == overlay->size) {
+    int new_size = overlay->size == 0 ? 4 : overlay->size * 2;
+    const t3_config_t **new_layers =
+        _t3_config_mem_realloc(overlay->layers, new_size * sizeof(t3_config_t *));
+    if (new_layers == NULL) {
+      return T3_ERR_OUT_OF_MEMORY;
+    }
+    overlay->layers = new_layers;
+    overlay->size = new_size;
+  }
+  overlay->layers[overlay->count++] = layer;
+  return T3_ERR_SUCCESS;
+}
+
+/** Retrieve an item from a section, using a name which is not nul-terminated. */
+static t3_config_t *get_component(const t3_config_t *section, const char *name, size_t len) {
+  t3_config_t *item;
+  uint32_t hash = _t3_config_hash_string(name, len);
+
+  /* Comparing the hash values first avoids most string comparisons. */
+  for (item = section->value.list; item != NULL; item = item->next) {
+    if (STRING_HASH(item->name) == hash && strncmp(item->name, name, len) == 0 &&
+        item->name[len] == 0) {
+      return item;
+    }
+  }
+  return NULL;
+}
+
+/** Look up @p path in a single layer.
+    @param layer The layer to search.
+    @param path The path to look up, or @c NULL for the layer itself.
+    @param hides The location to store whether a path component in @p layer resolves to something
+        other than a section, which hides the layers below it.
+    @return The item at @p path, or @c NULL if it does not exist in @p layer.
+*/
+static const t3_config_t *lookup_layer(const t3_config_t *layer, const char *path,
+                                       t3_bool *hides) {
+  const char *component = path, *slash;
+
+  *hides = t3_false;
+  while (layer != NULL && component != NULL && *component != 0) {
+    if (layer->type != T3_CONFIG_SECTION) {
+      *hides = t3_true;
+      return NULL;
+    }
+    slash = strchr(component, '/');
+    layer = get_component(layer, component,
+                          slash == NULL ? strlen(component) : (size_t)(slash - component));
+    component = slash == NULL ? NULL : slash + 1;
+  }
+  return layer;
+}
+
+/** Look up @p path in each of the layers, starting from the top layer.
+    @param overlay The overlay to search.
+    @param path The path to look up, or @c NULL for the top-level section.
+    @param found The location to store the items found in each layer, top layer first.
+    @return The number of items stored in @p found.
+
+    Only the items that are visible in the combined view are returned. That is,
+    the search stops after the first item that is not a section, and layers in
+    which a path component resolves to something other than a section hide all
+    layers below them.
+*/
+static int lookup_layers(const t3_config_overlay_t *overlay, const char *path,
+                         const t3_config_t **found) {
+  const t3_config_t *item;
+  t3_bool hides;
+  int i, count = 0;
+
+  for (i = overlay->count - 1; i >= 0; i--) {
+    item = lookup_layer(overlay->layers[i], path, &hides);
+    if (hides) {
+      return count;
+    } else if (item == NULL) {
+      continue;
+    }
+
+    found[count++] = item;
+    if (item->type != T3_CONFIG_SECTION) {
+      return count;
+    }
+  }
+  return count;
+}
+
+t3_config_t *t3_config_overlay_get(const t3_config_overlay_t *overlay, const char *path) {
+  const t3_config_t *item;
+  t3_bool hides;
+  int i;
+
+  if (overlay == NULL) {
+    return NULL;
+  }
+
+  /* Only the highest layer defining path matters, so the search stops there. */
+  for (i = overlay->count - 1; i >= 0; i--) {
+    item = lookup_layer(overlay->layers[i], path, &hides);
+    if (item != NULL || hides) {
+      return (t3_config_t *)item;
+    }
+  }
+  return NULL;
+}
+
+/** Build an index for each of the @p count sections in @p sections. */
+static t3_bool build_indices(const t3_config_t **sections, int count, key_index_t *indices) {
+  int i;
+
+  for (i = 0; i < count; i++) {
+    if (!_t3_config_index_init_section(&indices[i], sections[i])) {
+      while (i > 0) {
+        _t3_config_index_free(&indices[--i]);
+      }
+      return t3_false;
+    }
+  }
+  return t3_true;
+}
+
+static void free_indices(key_index_t *indices, int count) {
+  int i;
+  for (i = 0; i < count; i++) {
+    _t3_config_index_free(&indices[i]);
+  }
+}
+
+/** Check whether the item name @p name is defined in any of the first @p count indices. */
+static t3_bool is_hidden(const key_index_t *indices, int count, const char *name) {
+  int i;
+
+  for (i = 0; i < count; i++) {
+    if (*_t3_config_index_lookup_name(&indices[i], name) != NULL) {
+      return t3_true;
+    }
+  }
+  return t3_false;
+}
+
+int t3_config_overlay_iterate(const t3_config_overlay_t *overlay, const char *path,
+                              void (*callback)(const t3_config_t *item, void *data), void *data) {
+  const t3_config_t **sections;
+  key_index_t *indices;
+  const t3_config_t *item;
+  int i, count;
+
+  if (overlay == NULL || overlay->count == 0 || callback == NULL) {
+    return T3_ERR_BAD_ARG;
+  }
+
+  if ((sections = _t3_config_mem_alloc(overlay->count * sizeof(t3_config_t *))) == NULL) {
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+  count = lookup_layers(overlay, path, sections);
+
+  if (count == 0) {
+    _t3_config_mem_free(sections);
+    return T3_ERR_SUCCESS;
+  } else if (sections[0]->type != T3_CONFIG_SECTION && !t3_config_is_list(sections[0])) {
+    _t3_config_mem_free(sections);
+    return T3_ERR_BAD_ARG;
+  }
+
+  /* Lists are not merged, so only the top-most item matters. */
+  if (count == 1 || sections[0]->type != T3_CONFIG_SECTION) {
+    for (item = sections[0]->value.list; item != NULL; item = item->next) {
+      callback(item, data);
+    }
+    _t3_config_mem_free(sections);
+    return T3_ERR_SUCCESS;
+  }
+
+  /* The last section found may not actually be a section, if it was hidden by a value. */
+  if (sections[count - 1]->type != T3_CONFIG_SECTION) {
+    count--;
+  }
+
+  if ((indices = _t3_config_mem_alloc(count * sizeof(key_index_t))) == NULL ||
+      !build_indices(sections, count, indices)) {
+    _t3_config_mem_free(indices);
+    _t3_config_mem_free(sections);
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+
+  for (i = 0; i < count; i++) {
+    for (item = sections[i]->value.list; item != NULL; item = item->next) {
+      if (!is_hidden(indices, i, item->name)) {
+        callback(item, data);
+      }
+    }
+  }
+
+  free_indices(indices, count);
+  _t3_config_mem_free(indices);
+  _t3_config_mem_free(sections);
+  return T3_ERR_SUCCESS;
+}
+
+static int flatten_sections(t3_config_t *result, const t3_config_t **sections, int count);
+
+/** Add the merged value of @p name to the list at @p next_ptr.
+    @param next_ptr The location to store the new item.
+    @param name The name of the item.
+    @param indices The indices of the sections to search, starting with the section the item was
+        found in.
+    @param count The number of items in @p indices.
+*/
+static int flatten_item(t3_config_t **next_ptr, char *name, const key_index_t *indices,
+                        int count) {
+  const t3_config_t **sub_sections;
+  t3_config_t *item, *result;
+  int i, sub_count = 0, error;
+
+  if ((sub_sections = _t3_config_mem_alloc(count * sizeof(t3_config_t *))) == NULL) {
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+
+  /* Collect all the sections that will be merged, stopping at the first non-section. */
+  for (i = 0; i < count; i++) {
+    if ((item = *_t3_config_index_lookup_name(&indices[i], name)) == NULL) {
+      continue;
+    }
+    if (sub_count > 0 && item->type != T3_CONFIG_SECTION) {
+      break;
+    }
+    sub_sections[sub_count++] = item;
+    if (item->type != T3_CONFIG_SECTION) {
+      break;
+    }
+  }
+
+  /* If there is nothing to merge, copy the item from the layer it came from. Sharing its items
+     through t3_config_clone would modify the layer, which is only borrowed by the overlay. */
+  if (sub_count == 1) {
+    result = _t3_config_thaw(sub_sections[0], &error);
+    _t3_config_mem_free(sub_sections);
+    if (result == NULL) {
+      return error;
+    }
+    *next_ptr = result;
+    return T3_ERR_SUCCESS;
+  }
+
+  if ((result = t3_config_new()) == NULL || (result->name = _t3_config_ref_string(name)) == NULL) {
+    _t3_config_mem_free(result);
+    _t3_config_mem_free(sub_sections);
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+  result->line_number = sub_sections[0]->line_number;
+  result->file_index = sub_sections[0]->file_index;
+  _t3_config_ref_file_name(result->file_index);
+  *next_ptr = result;
+
+  error = flatten_sections(result, sub_sections, sub_count);
+  _t3_config_mem_free(sub_sections);
+  return error;
+}
+
+/** Fill the empty section @p result with the combination of all items in @p sections. */
+static int flatten_sections(t3_config_t *result, const t3_config_t **sections, int count) {
+  t3_config_t **next_ptr = &result->value.list;
+  key_index_t *indices;
+  const t3_config_t *item;
+  int i, error = T3_ERR_SUCCESS;
+
+  if ((indices = _t3_config_mem_alloc(count * sizeof(key_index_t))) == NULL ||
+      !build_indices(sections, count, indices)) {
+    _t3_config_mem_free(indices);
+    return T3_ERR_OUT_OF_MEMORY;
+  }
+
+  for (i = 0; i < count && error == T3_ERR_SUCCESS; i++) {
+    for (item = sections[i]->value.list; item != NULL; item = item->next) {
+      if (is_hidden(indices, i, item->name)) {
+        continue;
+      }
+      if ((error = flatten_item(next_ptr, item->name, indices + i, count - i)) != T3_ERR_SUCCESS) {
+        break;
+      }
+      next_ptr = &(*next_ptr)->next;
+    }
+  }
+  _t3_config_link_items(result);
+
+  free_indices(indices, count);
+  _t3_config_mem_free(indices);
+  return error;
+}
+
+t3_config_t *t3_config_overlay_flatten(const t3_config_overlay_t *overlay, int *error) {
+  const t3_config_t **sections;
+  t3_config_t *result;
+  int i, local_error;
+
+  if (overlay == NULL || overlay->count == 0) {
+    if (error != NULL) {
+      *error = T3_ERR_BAD_ARG;
+    }
+    return NULL;
+  }
+
+  if ((sections = _t3_config_mem_alloc(overlay->count * sizeof(t3_config_t *))) == NULL ||
+      (result = t3_config_new()) == NULL) {
+    _t3_config_mem_free(sections);
+    if (error != NULL) {
+      *error = T3_ERR_OUT_OF_MEMORY;
+    }
+    return NULL;
+  }
+
+  for (i = 0; i < overlay->count; i++) {
+    sections[i] = overlay->layers[overlay->count - 1 - i];
+  }
+
+  local_error = flatten_sections(result, sections, overlay->count);
+  _t3_config_mem_free(sections);
+  if (local_error != T3_ERR_SUCCESS) {
+    t3_config_delete(result);
+    if (error != NULL) {
+      *error = local_error;
+    }
+    return NULL;
+  }
+  return result;
+}
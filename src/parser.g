@@ -40,22 +40,31 @@ T3_CONFIG_LOCAL void _t3_config_abort(struct _t3_config_this *, int);
 #include <string.h>
 
 #include "t3config/config.h"
+#include "t3config/probes.h"
 #include "t3config/util.h"
 
 static t3_config_t *allocate_item(struct _t3_config_this *LLthis, t3_bool allocate_name) {
 	t3_config_t *result;
 
-	if ((result = (t3_config_t *) malloc(sizeof(t3_config_t))) == NULL)
+	if ((result = (t3_config_t *) _t3_config_mem_alloc(sizeof(t3_config_t))) == NULL)
 		LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
 
 	result->next = NULL;
+	/* Items are top-level until the complete config has been read, and they are linked. */
+	result->flags = T3_CONFIG_TOP_LEVEL;
+	result->link.generation = 0;
 	result->type = T3_CONFIG_NONE;
 	result->line_number = _t3_config_data->line_number;
 	result->value.ptr = NULL;
-	result->file_name = _t3_config_ref_file_name(_t3_config_data->included);
+	result->file_index = _t3_config_data->included == NULL ? 0 : _t3_config_data->included->file_index;
+	_t3_config_ref_file_name(result->file_index);
+	if (_t3_config_data->stats != NULL)
+		_t3_config_data->stats->items++;
 
 	if (allocate_name) {
-		if ((result->name = _t3_config_strdup(_t3_config_get_text(_t3_config_data->scanner))) == NULL)
+		/* Use a shared name, as many items in a typical config have the same name. */
+		if ((result->name = _t3_config_intern_string(&_t3_config_data->strings,
+				_t3_config_get_text(_t3_config_data->scanner))) == NULL)
 			LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
 	} else {
 		result->name = NULL;
@@ -94,9 +103,18 @@ static void set_value(struct _t3_config_this *LLthis, t3_config_t *item, t3_conf
 		case T3_CONFIG_STRING: {
 			/* Don't need to allocate full yytext, because we drop the quotes. */
 			char *text = _t3_config_get_text(_t3_config_data->scanner);
-			char *value = malloc(strlen(text));
+			char *value;
+
+			/* Short strings in configs are stored in the item itself. Constraints need an
+			   allocated string, as it is moved into the expression. */
+			if (!_t3_config_data->constraint_parser && FITS_INLINE(strlen(text) - 2)) {
+				_t3_unescape(item->value.short_string, text);
+				item->type = type;
+				item->flags |= T3_CONFIG_INLINE_STRING;
+				break;
+			}
 
-			if (value == NULL)
+			if ((value = _t3_config_mem_alloc(strlen(text))) == NULL)
 				LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
 
 			_t3_unescape(value, text);
@@ -125,11 +143,13 @@ static t3_bool transform_percent_list(struct _t3_config_this *LLthis, t3_config_
 		/* No existing list found. Transform the current item into new plist. */
 		list = allocate_item(LLthis, t3_false);
 		list->type = T3_CONFIG_PLIST;
-		list->name = (*last_dptr)->name;
-		(*last_dptr)->name = NULL;
-		memmove(list->name, list->name + 1, strlen(list->name));
 		list->value.list = *last_dptr;
 		*last_dptr = list;
+		list->name = _t3_config_intern_string(&_t3_config_data->strings, list->value.list->name + 1);
+		if (list->name == NULL)
+			LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
+		_t3_config_release_string(list->value.list->name);
+		list->value.list->name = NULL;
 		return t3_false;
 	}
 
@@ -144,6 +164,23 @@ static t3_bool transform_percent_list(struct _t3_config_this *LLthis, t3_config_
 	return t3_true;
 }
 
+/* Reading the time takes about as long as lexing a token, so only one in this many tokens is
+   timed, and the lexing time is estimated from those. */
+#define LEX_TIME_SAMPLE 64
+
+/** Read the next token, and update the statistics. */
+static int counted_lex(parse_context_t *context) {
+	double start;
+	int token;
+
+	if (context->stats->tokens++ % LEX_TIME_SAMPLE != 0)
+		return _t3_config_lex(context->scanner);
+	start = _t3_config_time();
+	token = _t3_config_lex(context->scanner);
+	context->stats->lex_time += (_t3_config_time() - start) * LEX_TIME_SAMPLE;
+	return token;
+}
+
 T3_CONFIG_LOCAL int _t3_config_yylex_wrapper(struct _t3_config_this *LLthis);
 int _t3_config_yylex_wrapper(struct _t3_config_this *LLthis) {
 	if (LLreissue == LL_NEW_TOKEN) {
@@ -158,6 +195,8 @@ int _t3_config_yylex_wrapper(struct _t3_config_this *LLthis) {
 		   when we find a newline, to improve error location reporting. */
 		if (LLsymb == '\n')
 			_t3_config_data->line_number++;
+		if (_t3_config_data->stats != NULL)
+			return counted_lex(_t3_config_data);
 		return _t3_config_lex(_t3_config_data->scanner);
 	} else {
 		int LLretval = LLreissue;
@@ -172,19 +211,6 @@ void LLmessage(struct _t3_config_this *LLthis, int LLtoken) {
 	LLabort(LLthis, T3_ERR_PARSE_ERROR);
 }
 
-static file_name_t *new_file_name(const t3_config_t *config) {
-	file_name_t *result;
-	if ((result = malloc(sizeof(file_name_t))) == NULL)
-		return NULL;
-
-	if ((result->file_name = _t3_config_strdup(t3_config_get_string(config))) == NULL) {
-		free(result);
-		return NULL;
-	}
-	result->count = 1;
-	return result;
-}
-
 static void include_file(struct _t3_config_this *LLthis, t3_config_t *item, t3_config_t *include) {
 	/* Location to save data from current lexer. */
 	yyscan_t scanner;
@@ -196,9 +222,10 @@ static void include_file(struct _t3_config_this *LLthis, t3_config_t *item, t3_c
 	yyscan_t new_scanner;
 	FILE *new_file;
 	int result;
+	double start = 0.0;
 
 	for (included = _t3_config_data->included; included != NULL; included = included->next) {
-		if (strcmp(included->value.string, include->value.string) == 0) {
+		if (strcmp(t3_config_get_string(included), t3_config_get_string(include)) == 0) {
 			/* It is an error to use recursive includes. */
 			if (_t3_config_data->opts->flags & T3_CONFIG_VERBOSE_ERROR)
 				_t3_config_data->error_extra = t3_config_take_string(include);
@@ -212,24 +239,36 @@ static void include_file(struct _t3_config_this *LLthis, t3_config_t *item, t3_c
 
 	include->next = _t3_config_data->included;
 	_t3_config_data->included = include;
-	_t3_config_unref_file_name(include);
-	if ((include->file_name = new_file_name(include)) == NULL)
-		LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
+	/* The include item refers to the file it was read from, until it refers to the file it names. */
+	_t3_config_release_file_name(include->file_index);
+	include->file_index = 0;
+	if ((result = _t3_config_intern_file_name(t3_config_get_string(include), &include->file_index)) !=
+			T3_ERR_SUCCESS)
+		LLabort(LLthis, result);
+
 
+	PROBE1(include__open, t3_config_get_string(include));
+	if (_t3_config_data->stats != NULL) {
+		_t3_config_data->stats->includes++;
+		start = _t3_config_time();
+	}
 
 	/* Use either the default or the user supplied include-callback function to open
 	   the include file. */
 	if (_t3_config_data->opts->flags & T3_CONFIG_INCLUDE_DFLT)
 		new_file = t3_config_open_from_path(_t3_config_data->opts->include_callback.dflt.path,
-			include->value.string, _t3_config_data->opts->include_callback.dflt.flags);
+			t3_config_get_string(include), _t3_config_data->opts->include_callback.dflt.flags);
 	else
-		new_file = _t3_config_data->opts->include_callback.user.open(include->value.string,
+		new_file = _t3_config_data->opts->include_callback.user.open(t3_config_get_string(include),
 			_t3_config_data->opts->include_callback.user.data);
 
+	if (_t3_config_data->stats != NULL)
+		_t3_config_data->stats->include_time += _t3_config_time() - start;
+
 	/* Abort if the include file could not be found. */
 	if (new_file == NULL) {
 		if (_t3_config_data->opts->flags & T3_CONFIG_VERBOSE_ERROR)
-			_t3_config_data->error_extra = _t3_config_strdup(include->value.string);
+			_t3_config_data->error_extra = _t3_config_strdup(t3_config_get_string(include));
 		LLabort(LLthis, T3_ERR_ERRNO);
 	}
 
@@ -260,7 +299,14 @@ static void include_file(struct _t3_config_this *LLthis, t3_config_t *item, t3_c
 	_t3_config_data->file = file;
 
 	/* Close the include file. */
-	fclose(new_file);
+	if (_t3_config_data->stats != NULL) {
+		start = _t3_config_time();
+		fclose(new_file);
+		_t3_config_data->stats->include_time += _t3_config_time() - start;
+	} else {
+		fclose(new_file);
+	}
+	PROBE2(include__close, t3_config_get_string(include), result);
 
 	/* Abort if the parse of the include file was not successful. */
 	if (result != T3_ERR_SUCCESS)
@@ -322,9 +368,17 @@ value(t3_config_t *item) {
 			/* We won't be adding the entire yytext, so we can safely ignore the
 			   nul byte. */
 			char *text = _t3_config_get_text(_t3_config_data->scanner);
-			char *value = realloc(item->value.string, strlen(text) + strlen(item->value.string));
-			if (value == NULL)
-				LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
+			char *value;
+
+			if (item->flags & T3_CONFIG_INLINE_STRING) {
+				if ((value = _t3_config_mem_alloc(strlen(text) + strlen(item->value.short_string))) == NULL)
+					LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
+				strcpy(value, item->value.short_string);
+				item->flags &= ~T3_CONFIG_INLINE_STRING;
+			} else {
+				if ((value = _t3_config_mem_realloc(item->value.string, strlen(text) + strlen(item->value.string))) == NULL)
+					LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
+			}
 
 			item->value.string = value;
 			value += strlen(value);
@@ -485,7 +539,7 @@ static expr_node_t *new_expression(struct _t3_config_this *LLthis, expr_type_t t
 			break;
 	}
 
-	if ((result = malloc(sizeof(expr_node_t))) == NULL)
+	if ((result = _t3_config_mem_alloc(sizeof(expr_node_t))) == NULL)
 		LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
 	result->type = type;
 	result->value.operand[0] = operand_0;
@@ -506,7 +560,7 @@ static expr_node_t *new_expression(struct _t3_config_this *LLthis, expr_type_t t
 			break;
 		case EXPR_IDENT:
 			if ((result->value.string = _t3_config_strdup(_t3_config_get_text(_t3_config_data->scanner))) == NULL) {
-				free(result);
+				_t3_config_mem_free(result);
 				LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
 			}
 			break;
@@ -523,12 +577,12 @@ constraint {
 	_t3_config_data->LLthis = LLthis;
 	_t3_config_data->result = NULL;
 
-	if ((top = malloc(sizeof(expr_node_t))) == NULL)
+	if ((top = _t3_config_mem_alloc(sizeof(expr_node_t))) == NULL)
 		LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
 	_t3_config_data->result = top;
 	top->type = EXPR_TOP;
 	top->value.operand[0] = NULL;
-	if ((top->value.operand[1] = malloc(sizeof(expr_node_t))) == NULL)
+	if ((top->value.operand[1] = _t3_config_mem_alloc(sizeof(expr_node_t))) == NULL)
 		LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
 	top->value.operand[1]->type = EXPR_STRING_CONST;
 	top->value.operand[1]->value.string = NULL;
@@ -546,7 +600,7 @@ constraint {
 	expression(0, &top->value.operand[0])
 	{
 		if (top->value.operand[1] == NULL) {
-			if ((top->value.operand[1] = malloc(sizeof(expr_node_t))) == NULL)
+			if ((top->value.operand[1] = _t3_config_mem_alloc(sizeof(expr_node_t))) == NULL)
 				LLabort(LLthis, T3_ERR_OUT_OF_MEMORY);
 			top->value.operand[1]->type = EXPR_STRING_CONST;
 			top->value.operand[1]->value.string = NULL;
@@ -0,0 +1,256 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <string.h>
+
+#include "config_internal.h"
+#include "hash.h"
+#include "util.h"
+
+#define NAME_CHARS "-_abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+
+/* A single step of a path: either the name of an item in a section, or the index of an item in a
+   list. */
+typedef struct {
+  /* The name to look up, or NULL if this is a list index. */
+  const char *name;
+  /* The hash of the name as used by non-frozen sections, and by the perfect hash tables of
+     frozen sections. */
+  uint32_t hash;
+  uint64_t hash64;
+  size_t index;
+} path_step_t;
+
+/* The steps and the names they refer to are stored in a single block of memory: first the
+   header, then the steps, then the nul-terminated names. */
+struct t3_config_path_t {
+  size_t count;
+  path_step_t steps[1];
+};
+
+/** Parse the list index at @p ptr, which points just after the opening bracket.
+    @return A pointer to the character following the closing bracket, or @c NULL on error. */
+static const char *parse_index(const char *ptr, size_t *index, int *error) {
+  size_t value = 0;
+
+  if (*ptr < '0' || *ptr > '9') {
+    *error = T3_ERR_PARSE_ERROR;
+    return NULL;
+  }
+  for (; *ptr >= '0' && *ptr <= '9'; ptr++) {
+    if (value > ((size_t)-1 - 9) / 10) {
+      *error = T3_ERR_OUT_OF_RANGE;
+      return NULL;
+    }
+    value = value * 10 + (size_t)(*ptr - '0');
+  }
+  if (*ptr != ']') {
+    *error = T3_ERR_PARSE_ERROR;
+    return NULL;
+  }
+  *index = value;
+  return ptr + 1;
+}
+
+/** Count the steps in @p path, or return @c (size_t)-1 if it is not a valid path. */
+static size_t count_steps(const char *path, int *error) {
+  size_t count = 0, index, length;
+
+  while (*path != 0) {
+    if ((length = strspn(path, NAME_CHARS)) == 0) {
+      *error = T3_ERR_PARSE_ERROR;
+      return (size_t)-1;
+    }
+    count++;
+    path += length;
+    while (*path == '[') {
+      if ((path = parse_index(path + 1, &index, error)) == NULL) {
+        return (size_t)-1;
+      }
+      count++;
+    }
+    if (*path == '/') {
+      path++;
+      if (*path == 0) {
+        *error = T3_ERR_PARSE_ERROR;
+        return (size_t)-1;
+      }
+    } else if (*path != 0) {
+      *error = T3_ERR_PARSE_ERROR;
+      return (size_t)-1;
+    }
+  }
+  return count;
+}
+
+t3_config_path_t *t3_config_path_compile(const char *path, int *error) {
+  t3_config_path_t *result;
+  char *names;
+  size_t count, length, i;
+  int local_error = T3_ERR_SUCCESS;
+
+  if (path == NULL) {
+    local_error = T3_ERR_BAD_ARG;
+    goto error_return;
+  }
+
+  /* A leading slash denotes the root, as in the paths of schema constraints. */
+  if (*path == '/') {
+    path++;
+  }
+  if ((count = count_steps(path, &local_error)) == (size_t)-1) {
+    goto error_return;
+  }
+
+  if ((result = _t3_config_mem_alloc(sizeof(t3_config_path_t) + count * sizeof(path_step_t) +
+                                     strlen(path) + 1)) == NULL) {
+    local_error = T3_ERR_OUT_OF_MEMORY;
+    goto error_return;
+  }
+  result->count = count;
+  names = (char *)(result->steps + (count + 1));
+
+  /* The path is known to be valid, so it does not need to be checked again. */
+  for (i = 0; i < count;) {
+    if (*path == '/') {
+      path++;
+    }
+    length = strspn(path, NAME_CHARS);
+    memcpy(names, path, length);
+    names[length] = 0;
+    result->steps[i].name = names;
+    result->steps[i].hash = _t3_config_hash_string(names, length);
+    result->steps[i].hash64 = _t3_config_hash_string64(names);
+    result->steps[i].index = 0;
+    names += length + 1;
+    path += length;
+    i++;
+    while (*path == '[') {
+      path = parse_index(path + 1, &result->steps[i].index, &local_error);
+      result->steps[i].name = NULL;
+      result->steps[i].hash = 0;
+      result->steps[i].hash64 = 0;
+      i++;
+    }
+  }
+  return result;
+
+error_return:
+  if (error != NULL) {
+    *error = local_error;
+  }
+  return NULL;
+}
+
+void t3_config_path_delete(t3_config_path_t *path) { _t3_config_mem_free(path); }
+
+/** Perform a single step of a path lookup. */
+static t3_config_t *get_step(const t3_config_t *config, const path_step_t *step) {
+  t3_config_t *item;
+  size_t i;
+
+  if (step->name == NULL) {
+    if (config->type != T3_CONFIG_LIST && config->type != T3_CONFIG_PLIST) {
+      return NULL;
+    }
+    if (config->flags & T3_CONFIG_FROZEN) {
+      return _t3_config_frozen_get_index(config, step->index);
+    }
+    for (item = config->value.list, i = step->index; item != NULL && i > 0; item = item->next) {
+      i--;
+    }
+    return item;
+  }
+
+  if (config->type != T3_CONFIG_SECTION && (int)config->type != T3_CONFIG_SCHEMA) {
+    return NULL;
+  }
+  if (config->flags & T3_CONFIG_FROZEN) {
+    return config->value.list == NULL
+               ? NULL
+               : _t3_config_frozen_get_hashed(config, step->name, step->hash64);
+  }
+  for (item = config->value.list; item != NULL; item = item->next) {
+    if (STRING_HASH(item->name) == step->hash && strcmp(item->name, step->name) == 0) {
+      return item;
+    }
+  }
+  return NULL;
+}
+
+t3_config_t *t3_config_get_path(const t3_config_t *config, const t3_config_path_t *path) {
+  size_t i;
+
+  if (config == NULL || path == NULL) {
+    return NULL;
+  }
+  for (i = 0; i < path->count && config != NULL; i++) {
+    config = get_step(config, &path->steps[i]);
+  }
+  return (t3_config_t *)config;
+}
+
+struct t3_config_lookup_t {
+  t3_config_path_t *path;
+  /* The config for which result was looked up, and the generation of the top-level config
+     containing it (see _t3_config_generation). That generation changes whenever any item in the
+     top-level config is modified, and no other top-level config ever had the same generation, so
+     a matching pair means result is still correct. */
+  const t3_config_t *config;
+  uint64_t generation;
+  t3_config_t *result;
+};
+
+t3_config_lookup_t *t3_config_lookup_new(const char *path, int *error) {
+  t3_config_lookup_t *result;
+
+  if ((result = _t3_config_mem_alloc(sizeof(t3_config_lookup_t))) == NULL) {
+    if (error != NULL) {
+      *error = T3_ERR_OUT_OF_MEMORY;
+    }
+    return NULL;
+  }
+  if ((result->path = t3_config_path_compile(path, error)) == NULL) {
+    _t3_config_mem_free(result);
+    return NULL;
+  }
+  result->config = NULL;
+  result->generation = 0;
+  result->result = NULL;
+  return result;
+}
+
+void t3_config_lookup_delete(t3_config_lookup_t *lookup) {
+  if (lookup == NULL) {
+    return;
+  }
+  t3_config_path_delete(lookup->path);
+  _t3_config_mem_free(lookup);
+}
+
+t3_config_t *t3_config_lookup(t3_config_lookup_t *lookup, const t3_config_t *config) {
+  uint64_t generation;
+
+  if (lookup == NULL || config == NULL) {
+    return NULL;
+  }
+  /* If the top-level config is not known, a deleted config may have been at the same address, so
+     the result is not reused. */
+  generation = _t3_config_generation(config);
+  if (generation == 0 || lookup->generation != generation || lookup->config != config) {
+    lookup->result = t3_config_get_path(config, lookup->path);
+    lookup->config = config;
+    lookup->generation = generation;
+  }
+  return lookup->result;
+}
@@ -27,7 +27,7 @@ static FILE *try_open(const char *dir, size_t dir_len, const char *name) {
   size_t len;
 
   len = dir_len + strlen(name) + 2;
-  if ((file_name = malloc(len)) == NULL) {
+  if ((file_name = _t3_config_mem_alloc(len)) == NULL) {
     errno = ENOMEM;
     return NULL;
   }
@@ -40,7 +40,7 @@ static FILE *try_open(const char *dir, size_t dir_len, const char *name) {
   strcat(file_name, name);
 
   result = fopen(file_name, "r");
-  free(file_name);
+  _t3_config_mem_free(file_name);
   return result;
 }
 
@@ -0,0 +1,45 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef T3_CONFIG_PROBES_H
+#define T3_CONFIG_PROBES_H
+
+/* Static tracing probes, for use with tools such as perf, bpftrace and SystemTap. The probes are
+   only compiled in if USE_SDT_PROBES is defined, and then cost a single no-op instruction each
+   when no tracer is attached. Otherwise they expand to nothing, and their arguments are not
+   evaluated. The provider name is libt3config, and double underscores in probe names are shown
+   as dashes by most tools.
+
+   Probes:
+   - parse__start(scan_type): reading a config starts. scan_type is 0 for files, 1 for buffers.
+   - parse__done(error): reading a config ended, with the given error code.
+   - include__open(name): an included file is about to be opened.
+   - include__close(name, error): parsing an included file ended, with the given error code.
+   - schema__load__start(): reading a schema starts.
+   - schema__load__done(success): reading a schema ended, successfully if success is 1.
+   - constraint__fail(constraint, line_number): a config violates a constraint of a schema.
+   - write__fsync(path): the data written by t3_config_close_write is about to be synced.
+   - write__rename(path, result): the written file was renamed to path, returning result.
+*/
+#ifdef USE_SDT_PROBES
+#include <sys/sdt.h>
+#define PROBE(name) DTRACE_PROBE(libt3config, name)
+#define PROBE1(name, a) DTRACE_PROBE1(libt3config, name, a)
+#define PROBE2(name, a, b) DTRACE_PROBE2(libt3config, name, a, b)
+#else
+#define PROBE(name) ((void)0)
+#define PROBE1(name, a) ((void)0)
+#define PROBE2(name, a, b) ((void)0)
+#endif
+
+#endif
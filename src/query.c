@@ -0,0 +1,340 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <string.h>
+
+#include "config_internal.h"
+#include "util.h"
+
+#define NAME_CHARS "-_abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+
+typedef enum {
+  /* Look up a compiled path, which combines consecutive names and list indices. */
+  STEP_PATH,
+  /* Select all items of a section or list. */
+  STEP_ALL,
+  /* Select an item of a list, following a wildcard or a filter. */
+  STEP_INDEX,
+  /* Keep the item only if the expression holds for it. */
+  STEP_FILTER
+} step_type_t;
+
+typedef struct {
+  step_type_t type;
+  union {
+    t3_config_path_t *path;
+    size_t index;
+    expr_node_t *expr;
+  } value;
+} query_step_t;
+
+struct t3_config_query_t {
+  query_step_t *steps;
+  size_t count;
+};
+
+typedef struct {
+  const t3_config_query_t *query;
+  const t3_config_t *root;
+  void (*callback)(const t3_config_t *item, void *data);
+  void *data;
+} run_context_t;
+
+/* State while compiling a query. Names and indices are collected in path, until a wildcard or
+   filter requires them to be compiled into a single STEP_PATH. */
+typedef struct {
+  t3_config_query_t *query;
+  char *path;
+  size_t path_length;
+  /* A buffer large enough to hold any filter expression in the query. */
+  char *expr;
+  int error;
+} compile_context_t;
+
+static query_step_t *add_step(compile_context_t *context, step_type_t type) {
+  query_step_t *steps;
+
+  if ((steps = _t3_config_mem_realloc(context->query->steps, (context->query->count + 1) *
+                                                                 sizeof(query_step_t))) == NULL) {
+    context->error = T3_ERR_OUT_OF_MEMORY;
+    return NULL;
+  }
+  context->query->steps = steps;
+  steps[context->query->count].type = type;
+  return &steps[context->query->count++];
+}
+
+/** Compile the names and indices collected so far into a single step. */
+static t3_bool flush_path(compile_context_t *context) {
+  t3_config_path_t *path;
+  query_step_t *step;
+
+  if (context->path_length == 0) {
+    return t3_true;
+  }
+  context->path[context->path_length] = 0;
+  context->path_length = 0;
+  if ((path = t3_config_path_compile(context->path, &context->error)) == NULL) {
+    return t3_false;
+  }
+  if ((step = add_step(context, STEP_PATH)) == NULL) {
+    t3_config_path_delete(path);
+    return t3_false;
+  }
+  step->value.path = path;
+  return t3_true;
+}
+
+static void append_path(compile_context_t *context, const char *text, size_t length) {
+  memcpy(context->path + context->path_length, text, length);
+  context->path_length += length;
+}
+
+/** Find the bracket closing the selector starting at @p text, which points to the opening
+    bracket. Brackets in the expression must be balanced, except in strings. */
+static const char *find_closing_bracket(const char *text) {
+  int depth = 0;
+  char quote = 0;
+
+  for (; *text != 0; text++) {
+    if (quote != 0) {
+      /* A doubled quote inside a string is seen as the end and start of a string. */
+      if (*text == quote) {
+        quote = 0;
+      }
+    } else if (*text == '"' || *text == '\'') {
+      quote = *text;
+    } else if (*text == '[') {
+      depth++;
+    } else if (*text == ']' && --depth == 0) {
+      return text;
+    }
+  }
+  return NULL;
+}
+
+/** Compile a selector, i.e. an index or a filter expression.
+    @param text The selector, starting with the opening bracket.
+    @param in_path Whether the selector directly follows a name or index in the path. This is
+        set to ::t3_false if the selector is not added to the path.
+    @return A pointer to the character after the closing bracket, or @c NULL on error.
+*/
+static const char *compile_selector(compile_context_t *context, const char *text,
+                                    t3_bool *in_path) {
+  const char *end = find_closing_bracket(text);
+  size_t length, digits, index = 0;
+  query_step_t *step;
+  expr_node_t *expr;
+
+  if (end == NULL) {
+    context->error = T3_ERR_PARSE_ERROR;
+    return NULL;
+  }
+  length = (size_t)(end - text) - 1;
+  digits = strspn(text + 1, "0123456789");
+
+  if (digits == length && length > 0) {
+    /* Indices directly following a name are handled by the compiled path. */
+    if (*in_path) {
+      append_path(context, text, length + 2);
+      return end + 1;
+    }
+    for (text++; text < end; text++) {
+      if (index > ((size_t)-1 - 9) / 10) {
+        context->error = T3_ERR_OUT_OF_RANGE;
+        return NULL;
+      }
+      index = index * 10 + (size_t)(*text - '0');
+    }
+    if ((step = add_step(context, STEP_INDEX)) == NULL) {
+      return NULL;
+    }
+    step->value.index = index;
+    return end + 1;
+  }
+
+  *in_path = t3_false;
+  if (!flush_path(context)) {
+    return NULL;
+  }
+  memcpy(context->expr, text + 1, length);
+  context->expr[length] = 0;
+  if ((expr = _t3_config_parse_expr(context->expr, &context->error)) == NULL) {
+    return NULL;
+  }
+  if ((step = add_step(context, STEP_FILTER)) == NULL) {
+    _t3_config_delete_expr(expr);
+    return NULL;
+  }
+  step->value.expr = expr;
+  return end + 1;
+}
+
+static t3_bool compile(compile_context_t *context, const char *text) {
+  size_t length;
+  t3_bool in_path;
+
+  /* A leading slash denotes the root, as in the paths of schema constraints. */
+  if (*text == '/') {
+    text++;
+  }
+  while (*text != 0) {
+    if (*text == '*') {
+      if (!flush_path(context) || add_step(context, STEP_ALL) == NULL) {
+        return t3_false;
+      }
+      text++;
+      in_path = t3_false;
+    } else if ((length = strspn(text, NAME_CHARS)) > 0) {
+      if (context->path_length > 0) {
+        append_path(context, "/", 1);
+      }
+      append_path(context, text, length);
+      text += length;
+      in_path = t3_true;
+    } else {
+      context->error = T3_ERR_PARSE_ERROR;
+      return t3_false;
+    }
+
+    while (*text == '[') {
+      if ((text = compile_selector(context, text, &in_path)) == NULL) {
+        return t3_false;
+      }
+    }
+
+    if (*text == '/') {
+      text++;
+      if (*text == 0) {
+        context->error = T3_ERR_PARSE_ERROR;
+        return t3_false;
+      }
+    } else if (*text != 0) {
+      context->error = T3_ERR_PARSE_ERROR;
+      return t3_false;
+    }
+  }
+  return flush_path(context);
+}
+
+t3_config_query_t *t3_config_query_compile(const char *query, int *error) {
+  compile_context_t context;
+  size_t length;
+
+  if (query == NULL) {
+    if (error != NULL) {
+      *error = T3_ERR_BAD_ARG;
+    }
+    return NULL;
+  }
+
+  length = strlen(query);
+  context.error = T3_ERR_OUT_OF_MEMORY;
+  context.path_length = 0;
+  context.path = _t3_config_mem_alloc(length + 1);
+  context.expr = _t3_config_mem_alloc(length + 1);
+  context.query = _t3_config_mem_alloc(sizeof(t3_config_query_t));
+  if (context.query != NULL) {
+    context.query->steps = NULL;
+    context.query->count = 0;
+  }
+
+  if (context.path == NULL || context.expr == NULL || context.query == NULL ||
+      !compile(&context, query)) {
+    t3_config_query_delete(context.query);
+    context.query = NULL;
+    if (error != NULL) {
+      *error = context.error;
+    }
+  }
+  _t3_config_mem_free(context.path);
+  _t3_config_mem_free(context.expr);
+  return context.query;
+}
+
+void t3_config_query_delete(t3_config_query_t *query) {
+  size_t i;
+
+  if (query == NULL) {
+    return;
+  }
+  for (i = 0; i < query->count; i++) {
+    if (query->steps[i].type == STEP_PATH) {
+      t3_config_path_delete(query->steps[i].value.path);
+    } else if (query->steps[i].type == STEP_FILTER) {
+      _t3_config_delete_expr(query->steps[i].value.expr);
+    }
+  }
+  _t3_config_mem_free(query->steps);
+  _t3_config_mem_free(query);
+}
+
+/** Apply the steps from @p step onwards to @p config, and report the resulting items. */
+static void run_steps(const run_context_t *context, size_t step, const t3_config_t *config) {
+  const query_step_t *steps = context->query->steps;
+  const t3_config_t *item;
+  size_t i;
+
+  /* Steps which select at most one item are handled iteratively. */
+  for (; step < context->query->count; step++) {
+    switch (steps[step].type) {
+      case STEP_PATH:
+        config = t3_config_get_path(config, steps[step].value.path);
+        break;
+      case STEP_INDEX:
+        if (!t3_config_is_list(config)) {
+          return;
+        }
+        for (item = t3_config_get(config, NULL), i = steps[step].value.index; item != NULL && i > 0;
+             item = item->next) {
+          i--;
+        }
+        config = item;
+        break;
+      case STEP_FILTER:
+        if (!_t3_config_evaluate_expr(steps[step].value.expr, config, context->root)) {
+          return;
+        }
+        break;
+      case STEP_ALL:
+        if (config->type != T3_CONFIG_SECTION && !t3_config_is_list(config)) {
+          return;
+        }
+        for (item = config->value.list; item != NULL; item = item->next) {
+          run_steps(context, step + 1, item);
+        }
+        return;
+      default:
+        return;
+    }
+    if (config == NULL) {
+      return;
+    }
+  }
+  context->callback(config, context->data);
+}
+
+int t3_config_query_run(const t3_config_query_t *query, const t3_config_t *config,
+                        void (*callback)(const t3_config_t *item, void *data), void *data) {
+  run_context_t context;
+
+  if (query == NULL || config == NULL || callback == NULL) {
+    return T3_ERR_BAD_ARG;
+  }
+  context.query = query;
+  context.root = config;
+  context.callback = callback;
+  context.data = data;
+  run_steps(&context, 0, config);
+  return T3_ERR_SUCCESS;
+}
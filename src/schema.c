@@ -16,6 +16,7 @@
 
 #include "config_internal.h"
 #include "parser.h"
+#include "probes.h"
 #include "util.h"
 
 typedef struct {
@@ -29,10 +30,8 @@ static char meta_schema_buffer[] = {
 };
 
 static char *dup_file_name(const t3_config_t *config) {
-  if (config == NULL || config->file_name == NULL) {
-    return NULL;
-  }
-  return _t3_config_strdup(config->file_name->file_name);
+  const char *file_name = t3_config_get_file_name(config);
+  return file_name == NULL ? NULL : _t3_config_strdup(file_name);
 }
 
 static t3_bool validate_aggregate_keys(const t3_config_t *config_part,
@@ -70,6 +69,8 @@ static t3_bool validate_constraints(const t3_config_t *config_part, const t3_con
        constraint != NULL; constraint = t3_config_get_next(constraint)) {
     if (constraint->type == (int)T3_CONFIG_EXPRESSION &&
         !_t3_config_evaluate_expr(constraint->value.expr, config_part, context->root)) {
+      PROBE2(constraint__fail, constraint->value.expr->value.operand[1]->value.string,
+             config_part->line_number);
       if (context->error != NULL) {
         context->error->error = T3_ERR_CONSTRAINT_VIOLATION;
         context->error->line_number = config_part->line_number;
@@ -183,20 +184,29 @@ t3_bool t3_config_validate(t3_config_t *config, const t3_config_schema_t *schema
   return validate_aggregate_keys(config, (const t3_config_t *)schema, &context);
 }
 
-static expr_node_t *parse_constraint_string(const char *constraint, int *error) {
+/** Parse an expression in the syntax of schema constraints.
+    @param text The expression to parse, optionally preceded by a description in braces.
+    @param error A pointer to the location to store an error value (or @c NULL).
+    @return The parsed expression, with type EXPR_TOP, or @c NULL on error.
+*/
+expr_node_t *_t3_config_parse_expr(const char *text, int *error) {
   parse_context_t context;
   int retval;
 
   context.scan_type = SCAN_BUFFER;
-  context.buffer = constraint;
-  context.buffer_size = strlen(constraint);
+  context.buffer = text;
+  context.buffer_size = strlen(text);
   context.buffer_idx = 0;
   context.line_number = 1;
   context.result = NULL;
   context.constraint_parser = t3_true;
+  context.stats = NULL;
 
   /* Initialize lexer. */
   if (_t3_config_lex_init_extra(&context, &context.scanner) != 0) {
+    if (error != NULL) {
+      *error = T3_ERR_OUT_OF_MEMORY;
+    }
     return NULL;
   }
 
@@ -222,7 +232,7 @@ static t3_bool parse_constraints(t3_config_t *schema, const t3_config_t *root,
 
   for (constraint = t3_config_get(t3_config_get(schema, "constraint"), NULL); constraint != NULL;
        constraint = t3_config_get_next(constraint)) {
-    expr_node_t *expr = parse_constraint_string(t3_config_get_string(constraint),
+    expr_node_t *expr = _t3_config_parse_expr(t3_config_get_string(constraint),
                                                 error == NULL ? NULL : &error->error);
     if (expr == NULL) {
       if (error != NULL) {
@@ -255,12 +265,27 @@ static t3_bool parse_constraints(t3_config_t *schema, const t3_config_t *root,
       return t3_false;
     }
 
-    constraint->type = T3_CONFIG_EXPRESSION;
-    if (expr->value.operand[1]->value.string == NULL) {
-      expr->value.operand[1]->value.string = constraint->value.string;
-    } else {
-      free(constraint->value.string);
+    if (expr->value.operand[1]->value.string == NULL &&
+        (expr->value.operand[1]->value.string = t3_config_take_string(constraint)) == NULL) {
+      _t3_config_delete_expr(expr);
+      if (error != NULL) {
+        error->error = T3_ERR_OUT_OF_MEMORY;
+        error->line_number = constraint->line_number;
+        if (opts != NULL) {
+          if (opts->flags & T3_CONFIG_VERBOSE_ERROR) {
+            error->extra = NULL;
+          }
+          if (opts->flags & T3_CONFIG_ERROR_FILE_NAME) {
+            error->file_name = dup_file_name(constraint);
+          }
+        }
+      }
+      return t3_false;
+    }
+    if (constraint->type == T3_CONFIG_STRING) {
+      _t3_config_free_string_value(constraint);
     }
+    constraint->type = T3_CONFIG_EXPRESSION;
     constraint->value.expr = expr;
   }
 
@@ -287,7 +312,7 @@ static t3_bool check_type_for_loop(t3_config_t *type, const t3_config_t *types)
     return t3_true;
   }
 
-  referred_type = t3_config_get(type, "type")->value.string;
+  referred_type = t3_config_get_string(t3_config_get(type, "type"));
   if (_t3_config_str2type(referred_type) != T3_CONFIG_NONE) {
     return t3_false;
   }
@@ -314,7 +339,7 @@ static t3_bool has_loops(const t3_config_t *schema, t3_config_error_t *error,
         error->line_number = type->line_number;
         if (opts != NULL) {
           if (opts->flags & T3_CONFIG_VERBOSE_ERROR) {
-            error->extra = _t3_config_strdup(t3_config_get(type, "type")->value.string);
+            error->extra = _t3_config_strdup(t3_config_get_string(t3_config_get(type, "type")));
           }
           if (opts->flags & T3_CONFIG_ERROR_FILE_NAME) {
             error->file_name = dup_file_name(type);
@@ -331,6 +356,13 @@ static t3_config_schema_t *handle_schema_validation(t3_config_t *config, t3_conf
                                                     const t3_config_opts_t *opts) {
   t3_config_t *meta_schema = NULL;
   t3_config_error_t local_error;
+  t3_config_stats_t *stats = NULL;
+  double start = 0.0;
+
+  if (opts != NULL && (opts->flags & T3_CONFIG_STATS) && opts->stats != NULL) {
+    stats = opts->stats;
+    start = _t3_config_time();
+  }
 
   if ((meta_schema = t3_config_read_buffer(meta_schema_buffer, sizeof(meta_schema_buffer),
                                            &local_error, NULL)) == NULL ||
@@ -354,24 +386,50 @@ static t3_config_schema_t *handle_schema_validation(t3_config_t *config, t3_conf
 
   if (!t3_config_validate(config, (t3_config_schema_t *)meta_schema, error,
                           opts == NULL ? 0 : opts->flags) ||
-      has_loops(config, error, opts) || !parse_constraints(config, config, error, opts)) {
+      has_loops(config, error, opts)) {
     goto error_end;
   }
+  if (stats != NULL) {
+    stats->validation_time = _t3_config_time() - start;
+    start = _t3_config_time();
+  }
+  if (!parse_constraints(config, config, error, opts)) {
+    goto error_end;
+  }
+  if (stats != NULL) {
+    stats->constraint_time = _t3_config_time() - start;
+  }
 
   t3_config_delete(meta_schema);
   config->type = T3_CONFIG_SCHEMA;
+  PROBE1(schema__load__done, 1);
   return (t3_config_schema_t *)config;
 
 error_end:
   t3_config_delete(config);
   t3_config_delete(meta_schema);
+  PROBE1(schema__load__done, 0);
   return NULL;
 }
 
+/** Remove the ::T3_CONFIG_DEDUP flag from @p opts, as constraints are compiled in place. */
+static const t3_config_opts_t *schema_opts(const t3_config_opts_t *opts, t3_config_opts_t *copy) {
+  if (opts == NULL || !(opts->flags & T3_CONFIG_DEDUP)) {
+    return opts;
+  }
+  *copy = *opts;
+  copy->flags &= ~T3_CONFIG_DEDUP;
+  return copy;
+}
+
 t3_config_schema_t *t3_config_read_schema_file(FILE *file, t3_config_error_t *error,
                                                const t3_config_opts_t *opts) {
+  t3_config_opts_t opts_copy;
   t3_config_t *config;
-  if ((config = t3_config_read_file(file, error, opts)) == NULL) {
+
+  PROBE(schema__load__start);
+  if ((config = t3_config_read_file(file, error, schema_opts(opts, &opts_copy))) == NULL) {
+    PROBE1(schema__load__done, 0);
     return NULL;
   }
   return handle_schema_validation(config, error, opts);
@@ -380,13 +438,46 @@ t3_config_schema_t *t3_config_read_schema_file(FILE *file, t3_config_error_t *er
 t3_config_schema_t *t3_config_read_schema_buffer(const char *buffer, size_t size,
                                                  t3_config_error_t *error,
                                                  const t3_config_opts_t *opts) {
+  t3_config_opts_t opts_copy;
   t3_config_t *config;
-  if ((config = t3_config_read_buffer(buffer, size, error, opts)) == NULL) {
+
+  PROBE(schema__load__start);
+  if ((config = t3_config_read_buffer(buffer, size, error, schema_opts(opts, &opts_copy))) ==
+      NULL) {
+    PROBE1(schema__load__done, 0);
     return NULL;
   }
   return handle_schema_validation(config, error, opts);
 }
 
+t3_config_expr_t *t3_config_expr_compile(const char *text, const t3_config_schema_t *schema,
+                                         const char *type, int *error) {
+  const t3_config_t *schema_part = (const t3_config_t *)schema;
+  expr_node_t *expr;
+
+  /* Expressions are evaluated on sections, so the type must be a section type. */
+  if (text == NULL || (type != NULL && schema == NULL) ||
+      (type != NULL && resolve_type(type, t3_config_get(schema_part, "types"), &schema_part) !=
+                           T3_CONFIG_SECTION)) {
+    if (error != NULL) {
+      *error = T3_ERR_BAD_ARG;
+    }
+    return NULL;
+  }
+
+  if ((expr = _t3_config_parse_expr(text, error)) == NULL) {
+    return NULL;
+  }
+  if (schema != NULL && !_t3_config_validate_expr(expr, schema_part, (const t3_config_t *)schema)) {
+    _t3_config_delete_expr(expr);
+    if (error != NULL) {
+      *error = T3_ERR_INVALID_CONSTRAINT;
+    }
+    return NULL;
+  }
+  return (t3_config_expr_t *)expr;
+}
+
 void t3_config_delete_schema(t3_config_schema_t *schema) {
   t3_config_delete((t3_config_t *)schema);
 }
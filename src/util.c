@@ -16,24 +16,91 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #ifdef USE_XLOCALE_H
 #include <xlocale.h>
 #endif
+#include "hash.h"
 #include "util.h"
 
-#ifndef HAS_STRDUP
-/** strdup implementation if none is provided by the environment. */
+static void *default_allocate(size_t size, void *data) {
+  (void)data;
+  return malloc(size);
+}
+
+static void *default_reallocate(void *ptr, size_t size, void *data) {
+  (void)data;
+  return realloc(ptr, size);
+}
+
+static void default_release(void *ptr, void *data) {
+  (void)data;
+  free(ptr);
+}
+
+static t3_config_allocator_t allocator = {default_allocate, default_reallocate, default_release,
+                                          NULL};
+
+void t3_config_set_allocator(const t3_config_allocator_t *new_allocator) {
+  if (new_allocator == NULL) {
+    allocator.allocate = default_allocate;
+    allocator.reallocate = default_reallocate;
+    allocator.release = default_release;
+    allocator.data = NULL;
+  } else {
+    allocator = *new_allocator;
+  }
+}
+
+void *_t3_config_mem_alloc(size_t size) { return allocator.allocate(size, allocator.data); }
+
+void *_t3_config_mem_calloc(size_t count, size_t size) {
+  void *result;
+
+  if (size != 0 && count > SIZE_MAX / size) {
+    return NULL;
+  }
+  if ((result = allocator.allocate(count * size, allocator.data)) != NULL) {
+    memset(result, 0, count * size);
+  }
+  return result;
+}
+
+void *_t3_config_mem_realloc(void *ptr, size_t size) {
+  return allocator.reallocate(ptr, size, allocator.data);
+}
+
+void _t3_config_mem_free(void *ptr) {
+  if (ptr != NULL) {
+    allocator.release(ptr, allocator.data);
+  }
+}
+
+/** strdup implementation, using the configured allocator. */
 char *_t3_config_strdup(const char *str) {
   char *result;
   size_t len = strlen(str) + 1;
 
-  if ((result = malloc(len)) == NULL) {
+  if ((result = _t3_config_mem_alloc(len)) == NULL) {
     return NULL;
   }
   memcpy(result, str, len);
   return result;
 }
+
+/** Get the time in seconds since an arbitrary starting point, for measuring durations. */
+double _t3_config_time(void) {
+  clock_t ticks;
+#ifdef CLOCK_MONOTONIC
+  struct timespec now;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &now) == 0) {
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+  }
 #endif
+  ticks = clock();
+  return (double)ticks / CLOCKS_PER_SEC;
+}
 
 void _t3_unescape(char *dest, const char *src) {
   size_t i, j;
@@ -205,20 +272,281 @@ t3_config_type_t _t3_config_str2type(const char *name) {
   return T3_CONFIG_NONE;
 }
 
-file_name_t *_t3_config_ref_file_name(const t3_config_t *config) {
-  if (config == NULL || config->file_name == NULL) {
+/* The file names of the included files of all existing configs. Items store an index into this
+   table rather than a pointer, which keeps them small. As items do not refer to the config they
+   are part of, and can be moved from one config to another, the table is shared by all configs.
+   Each item holds a reference to its file name, and names are removed when the last item referring
+   to them is deleted. The indices of removed names are reused, so the table only fills up if 65535
+   distinct names are in use at the same time.
+
+   The table is stored in chunks, such that entries never move and can be read without locking.
+   Index 0 means that an item has no file name. */
+#define FILE_NAME_CHUNK_SIZE 256
+
+typedef struct {
+  /* The number of references. Accessed atomically, as the items referring to the name may be
+     copied and deleted in different threads. */
+  int count;
+  uint32_t hash;
+  char name[1];
+} file_name_t;
+
+static file_name_t **file_name_chunks[(UINT16_MAX + 1) / FILE_NAME_CHUNK_SIZE];
+/* The lowest index which has never been used, and the number of names in the table. */
+static unsigned file_name_end = 1, file_name_count;
+
+/* Hash table used to find the index of a file name, which is only accessed with the lock held. */
+typedef struct {
+  uint32_t hash;
+  /* The index in the file table, or 0 for an empty slot. */
+  uint16_t index;
+} file_name_slot_t;
+
+static file_name_slot_t *file_name_slots;
+static size_t file_name_mask;
+
+#ifdef __GNUC__
+static char file_name_lock;
+#endif
+
+#define FILE_NAME(index) \
+  file_name_chunks[(index) / FILE_NAME_CHUNK_SIZE][(index) % FILE_NAME_CHUNK_SIZE]
+
+/* Adding and removing file names is serialized with a spin lock, as it happens only once per
+   included file. Without the GCC atomic builtins there is no lock, and configs which include files
+   can only be used from a single thread at a time (see t3_config_get_file_name). */
+static void lock_file_names(void) {
+#ifdef __GNUC__
+  while (__atomic_test_and_set(&file_name_lock, __ATOMIC_ACQUIRE)) {
+  }
+#endif
+}
+
+static void unlock_file_names(void) {
+#ifdef __GNUC__
+  __atomic_clear(&file_name_lock, __ATOMIC_RELEASE);
+#endif
+}
+
+/** Double the size of the file name hash table. */
+static t3_bool grow_file_name_slots(void) {
+  size_t size = file_name_slots == NULL ? 16 : 2 * (file_name_mask + 1), i, j;
+  file_name_slot_t *slots;
+
+  if ((slots = _t3_config_mem_calloc(size, sizeof(file_name_slot_t))) == NULL) {
+    return t3_false;
+  }
+  for (i = 0; file_name_slots != NULL && i <= file_name_mask; i++) {
+    if (file_name_slots[i].index == 0) {
+      continue;
+    }
+    for (j = file_name_slots[i].hash & (size - 1); slots[j].index != 0; j = (j + 1) & (size - 1)) {
+    }
+    slots[j] = file_name_slots[i];
+  }
+  _t3_config_mem_free(file_name_slots);
+  file_name_slots = slots;
+  file_name_mask = size - 1;
+  return t3_true;
+}
+
+/** Find an index which is not in use, preferring one that has never been used.
+    @return The index, or 0 if all indices are in use.
+*/
+static unsigned free_file_index(void) {
+  unsigned i;
+
+  if (file_name_end <= UINT16_MAX) {
+    return file_name_end;
+  }
+  for (i = 1; i <= UINT16_MAX; i++) {
+    if (FILE_NAME(i) == NULL) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+/** Retrieve the index of @p file_name in the file table, adding it if it is not present yet.
+    @param file_name The file name to look up.
+    @param index The location to store the index of @p file_name.
+    @retval ::T3_ERR_SUCCESS on success.
+    @retval ::T3_ERR_OUT_OF_MEMORY if memory is exhausted.
+    @retval ::T3_ERR_TOO_MANY_FILES if the table already contains the maximum number of names.
+
+    On success, a reference to the name is added, which must be released with
+    _t3_config_release_file_name.
+*/
+int _t3_config_intern_file_name(const char *file_name, uint16_t *index) {
+  file_name_t ***chunk, *record;
+  size_t length = strlen(file_name), i;
+  uint32_t hash = _t3_config_hash_string(file_name, length);
+  unsigned new_index;
+  int error = T3_ERR_OUT_OF_MEMORY;
+
+  lock_file_names();
+  /* Keep the load factor at or below 0.5, even after adding the name, to keep the probe sequences
+     short. */
+  if ((file_name_slots == NULL || 2 * (file_name_count + 1) > file_name_mask + 1) &&
+      !grow_file_name_slots()) {
+    goto end;
+  }
+  for (i = hash & file_name_mask; file_name_slots[i].index != 0; i = (i + 1) & file_name_mask) {
+    record = FILE_NAME(file_name_slots[i].index);
+    if (record->hash == hash && strcmp(record->name, file_name) == 0) {
+      ATOMIC_FETCH_ADD(record->count, 1);
+      *index = file_name_slots[i].index;
+      error = T3_ERR_SUCCESS;
+      goto end;
+    }
+  }
+
+  if ((new_index = free_file_index()) == 0) {
+    error = T3_ERR_TOO_MANY_FILES;
+    goto end;
+  }
+  chunk = &file_name_chunks[new_index / FILE_NAME_CHUNK_SIZE];
+  if (*chunk == NULL &&
+      (*chunk = _t3_config_mem_calloc(FILE_NAME_CHUNK_SIZE, sizeof(file_name_t *))) == NULL) {
+    goto end;
+  }
+  if ((record = _t3_config_mem_alloc(offsetof(file_name_t, name) + length + 1)) == NULL) {
+    goto end;
+  }
+  record->count = 1;
+  record->hash = hash;
+  memcpy(record->name, file_name, length + 1);
+  FILE_NAME(new_index) = record;
+  if (new_index == file_name_end) {
+    file_name_end++;
+  }
+  file_name_count++;
+  file_name_slots[i].hash = hash;
+  file_name_slots[i].index = (uint16_t)new_index;
+  *index = (uint16_t)new_index;
+  error = T3_ERR_SUCCESS;
+
+end:
+  unlock_file_names();
+  return error;
+}
+
+/** Retrieve the index of @p file_name in the file table, without adding a reference to it.
+    @return The index, or 0 if @p file_name is not in the table.
+*/
+uint16_t _t3_config_find_file_name(const char *file_name) {
+  uint32_t hash = _t3_config_hash_string(file_name, strlen(file_name));
+  uint16_t index = 0;
+  size_t i;
+
+  lock_file_names();
+  for (i = hash & file_name_mask; file_name_slots != NULL && file_name_slots[i].index != 0;
+       i = (i + 1) & file_name_mask) {
+    if (file_name_slots[i].hash == hash &&
+        strcmp(FILE_NAME(file_name_slots[i].index)->name, file_name) == 0) {
+      index = file_name_slots[i].index;
+      break;
+    }
+  }
+  unlock_file_names();
+  return index;
+}
+
+/** Add a reference to the file name with index @p index, which is already referred to. */
+void _t3_config_ref_file_name(uint16_t index) {
+  if (index != 0) {
+    ATOMIC_FETCH_ADD(FILE_NAME(index)->count, 1);
+  }
+}
+
+/** Remove the file name with index @p index from the table, if it is no longer referred to. */
+static void remove_file_name(uint16_t index) {
+  file_name_t *record = FILE_NAME(index);
+  size_t i, j, k;
+
+  /* Another thread may have found the name again, or removed it already, before the lock was
+     taken. */
+  if (record == NULL || ATOMIC_LOAD(record->count) != 0) {
+    return;
+  }
+
+  for (i = record->hash & file_name_mask; file_name_slots[i].index != index;
+       i = (i + 1) & file_name_mask) {
+  }
+  /* Move later entries of the probe sequence into the emptied slot where needed, such that they
+     can still be found. */
+  for (j = (i + 1) & file_name_mask; file_name_slots[j].index != 0; j = (j + 1) & file_name_mask) {
+    k = file_name_slots[j].hash & file_name_mask;
+    if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j)) {
+      file_name_slots[i] = file_name_slots[j];
+      i = j;
+    }
+  }
+  file_name_slots[i].index = 0;
+  FILE_NAME(index) = NULL;
+  _t3_config_mem_free(record);
+
+  /* Release all memory when the last name is removed. */
+  if (--file_name_count == 0) {
+    for (i = 0; i < sizeof(file_name_chunks) / sizeof(file_name_chunks[0]); i++) {
+      _t3_config_mem_free(file_name_chunks[i]);
+      file_name_chunks[i] = NULL;
+    }
+    _t3_config_mem_free(file_name_slots);
+    file_name_slots = NULL;
+    file_name_end = 1;
+  }
+}
+
+/** Release a reference to the file name with index @p index. */
+void _t3_config_release_file_name(uint16_t index) {
+  if (index == 0 || ATOMIC_FETCH_ADD(FILE_NAME(index)->count, -1) != 1) {
+    return;
+  }
+  lock_file_names();
+  remove_file_name(index);
+  unlock_file_names();
+}
+
+const char *_t3_config_file_name(uint16_t index) {
+  return index == 0 ? NULL : FILE_NAME(index)->name;
+}
+
+/** Allocate a new string record, containing a copy of @p str. */
+char *_t3_config_new_string(const char *str) {
+  size_t length = strlen(str);
+  shared_string_t *record;
+
+  if ((record = _t3_config_mem_alloc(STRING_RECORD_SIZE(length))) == NULL) {
     return NULL;
   }
-  config->file_name->count++;
-  return config->file_name;
+  record->count = 1;
+  record->hash = _t3_config_hash_string(str, length);
+  record->length = (uint32_t)length;
+  memcpy(record->str, str, length + 1);
+  return record->str;
+}
+
+/** Add a reference to the string record for @p str.
+    @return @p str, or a copy of it if the record is not reference counted. The copy may be
+        @c NULL if memory is exhausted.
+*/
+char *_t3_config_ref_string(char *str) {
+  if (str == NULL) {
+    return NULL;
+  }
+  if (STRING_RECORD(str)->count < 0) {
+    return _t3_config_new_string(str);
+  }
+  ATOMIC_FETCH_ADD(STRING_RECORD(str)->count, 1);
+  return str;
 }
 
-void _t3_config_unref_file_name(const t3_config_t *config) {
-  if (config == NULL || config->file_name == NULL) {
+void _t3_config_release_string(char *str) {
+  if (str == NULL || STRING_RECORD(str)->count < 0) {
     return;
   }
-  if (--config->file_name->count == 0) {
-    free(config->file_name->file_name);
-    free(config->file_name);
+  if (ATOMIC_FETCH_ADD(STRING_RECORD(str)->count, -1) == 1) {
+    _t3_config_mem_free(STRING_RECORD(str));
   }
 }
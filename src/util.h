@@ -17,16 +17,24 @@
 #include "config_api.h"
 #include "config_internal.h"
 
-#ifdef HAS_STRDUP
-#include <string.h>
-#define _t3_config_strdup strdup
-#else
+#include <stddef.h>
+
+T3_CONFIG_LOCAL void *_t3_config_mem_alloc(size_t size);
+T3_CONFIG_LOCAL void *_t3_config_mem_calloc(size_t count, size_t size);
+T3_CONFIG_LOCAL void *_t3_config_mem_realloc(void *ptr, size_t size);
+T3_CONFIG_LOCAL void _t3_config_mem_free(void *ptr);
 T3_CONFIG_LOCAL char *_t3_config_strdup(const char *str);
-#endif
+T3_CONFIG_LOCAL double _t3_config_time(void);
 
 T3_CONFIG_LOCAL void _t3_unescape(char *dest, const char *src);
 T3_CONFIG_LOCAL double _t3_config_strtod(char *text);
 T3_CONFIG_LOCAL t3_config_type_t _t3_config_str2type(const char *name);
-T3_CONFIG_LOCAL file_name_t *_t3_config_ref_file_name(const t3_config_t *config);
-T3_CONFIG_LOCAL void _t3_config_unref_file_name(const t3_config_t *config);
+T3_CONFIG_LOCAL int _t3_config_intern_file_name(const char *file_name, uint16_t *index);
+T3_CONFIG_LOCAL uint16_t _t3_config_find_file_name(const char *file_name);
+T3_CONFIG_LOCAL void _t3_config_ref_file_name(uint16_t index);
+T3_CONFIG_LOCAL void _t3_config_release_file_name(uint16_t index);
+T3_CONFIG_LOCAL const char *_t3_config_file_name(uint16_t index);
+T3_CONFIG_LOCAL char *_t3_config_new_string(const char *str);
+T3_CONFIG_LOCAL char *_t3_config_ref_string(char *str);
+T3_CONFIG_LOCAL void _t3_config_release_string(char *str);
 #endif
@@ -167,7 +167,7 @@ static void write_value(t3_config_t *config, FILE *file, int indent) {
       write_number(file, config->value.number);
       break;
     case T3_CONFIG_STRING:
-      write_string(file, config->value.string);
+      write_string(file, STRING_VALUE(config));
       break;
     case T3_CONFIG_LIST:
     case T3_CONFIG_PLIST:
@@ -23,6 +23,7 @@
 #endif
 
 #include "config.h"
+#include "probes.h"
 #include "util.h"
 
 #ifdef NO_XDG
@@ -152,8 +153,8 @@ char *t3_config_xdg_get_path(t3_config_xdg_dirs_t xdg_dir, const char *program_d
       dir = pw_entry.pw_dir;
     }
 
-    if ((pathname = malloc(strlen(dir) + 1 + strlen(xdg_dirs[xdg_dir].homedir_relative) + 1)) ==
-        NULL) {
+    if ((pathname = _t3_config_mem_alloc(strlen(dir) + 1 +
+                                         strlen(xdg_dirs[xdg_dir].homedir_relative) + 1)) == NULL) {
       return NULL;
     }
     strcpy(pathname, dir);
@@ -169,8 +170,8 @@ char *t3_config_xdg_get_path(t3_config_xdg_dirs_t xdg_dir, const char *program_d
     extra_size += 1 + strlen(program_dir);
   }
 
-  if ((tmp = realloc(pathname, strlen(pathname) + extra_size + 1)) == NULL) {
-    free(pathname);
+  if ((tmp = _t3_config_mem_realloc(pathname, strlen(pathname) + extra_size + 1)) == NULL) {
+    _t3_config_mem_free(pathname);
     return NULL;
   }
   pathname = tmp;
@@ -201,7 +202,7 @@ FILE *t3_config_xdg_open_read(t3_config_xdg_dirs_t xdg_dir, const char *program_
   strcat(pathname, file_name);
 
   result = fopen(pathname, "r");
-  free(pathname);
+  _t3_config_mem_free(pathname);
   return result;
 }
 
@@ -221,7 +222,7 @@ t3_config_write_file_t *t3_config_xdg_open_write(t3_config_xdg_dirs_t xdg_dir,
   }
 
   if (!make_dirs(pathname)) {
-    free(pathname);
+    _t3_config_mem_free(pathname);
     return NULL;
   }
 
@@ -229,15 +230,15 @@ t3_config_write_file_t *t3_config_xdg_open_write(t3_config_xdg_dirs_t xdg_dir,
   strcat(pathname, file_name);
   strcat(pathname, "XXXXXX");
   if ((fd = mkstemp(pathname)) < 0) {
-    free(pathname);
+    _t3_config_mem_free(pathname);
     return NULL;
   }
 
-  if ((result = malloc(sizeof(t3_config_write_file_t))) == NULL ||
+  if ((result = _t3_config_mem_alloc(sizeof(t3_config_write_file_t))) == NULL ||
       (result->file = fdopen(fd, "w")) == NULL) {
     close(fd);
     unlink(pathname);
-    free(pathname);
+    _t3_config_mem_free(pathname);
     return NULL;
   }
   result->pathname = pathname;
@@ -271,14 +272,14 @@ t3_config_write_file_t *t3_config_open_write(const char *file_name) {
     }
   }
 
-  if ((pathname = malloc(strlen(file_name) + 1 + 7)) == NULL) {
+  if ((pathname = _t3_config_mem_alloc(strlen(file_name) + 1 + 7)) == NULL) {
     return NULL;
   }
   memcpy(pathname, file_name, length);
   pathname[length] = 0;
 
   if (length > 0 && !make_dirs(pathname)) {
-    free(pathname);
+    _t3_config_mem_free(pathname);
     return NULL;
   }
 
@@ -289,15 +290,15 @@ t3_config_write_file_t *t3_config_open_write(const char *file_name) {
   strcat(pathname, dirsep == NULL ? file_name : dirsep + 1);
   strcat(pathname, "XXXXXX");
   if ((fd = mkstemp(pathname)) < 0) {
-    free(pathname);
+    _t3_config_mem_free(pathname);
     return NULL;
   }
 
-  if ((result = malloc(sizeof(t3_config_write_file_t))) == NULL ||
+  if ((result = _t3_config_mem_alloc(sizeof(t3_config_write_file_t))) == NULL ||
       (result->file = fdopen(fd, "w")) == NULL) {
     close(fd);
     unlink(pathname);
-    free(pathname);
+    _t3_config_mem_free(pathname);
     return NULL;
   }
   result->pathname = pathname;
@@ -318,14 +319,15 @@ t3_bool t3_config_close_write(t3_config_write_file_t *file, t3_bool cancel_renam
       fclose(file->file);
     }
     unlink(file->pathname);
-    free(file->pathname);
-    free(file);
+    _t3_config_mem_free(file->pathname);
+    _t3_config_mem_free(file);
     return t3_true;
   }
 
   if (!file->closed) {
     /* Make sure the data has hit the disk. */
     fflush(file->file);
+    PROBE1(write__fsync, file->pathname);
     fsync(fileno(file->file));
     fclose(file->file);
     file->closed = t3_true;
@@ -336,8 +338,8 @@ t3_bool t3_config_close_write(t3_config_write_file_t *file, t3_bool cancel_renam
       return t3_false;
     }
     unlink(file->pathname);
-    free(file->pathname);
-    free(file);
+    _t3_config_mem_free(file->pathname);
+    _t3_config_mem_free(file);
     return t3_false;
   }
 
@@ -356,11 +358,12 @@ t3_bool t3_config_close_write(t3_config_write_file_t *file, t3_bool cancel_renam
   }
 
   rename_result = rename(file->pathname, target_path);
-  free(target_path);
+  PROBE2(write__rename, target_path, rename_result);
+  _t3_config_mem_free(target_path);
 
   if (rename_result == 0) {
-    free(file->pathname);
-    free(file);
+    _t3_config_mem_free(file->pathname);
+    _t3_config_mem_free(file);
     return t3_true;
   }
 
@@ -368,8 +371,8 @@ t3_bool t3_config_close_write(t3_config_write_file_t *file, t3_bool cancel_renam
     return t3_false;
   }
   unlink(file->pathname);
-  free(file->pathname);
-  free(file);
+  _t3_config_mem_free(file->pathname);
+  _t3_config_mem_free(file);
   return t3_false;
 }
 
@@ -0,0 +1,1326 @@
+/* Copyright (C) 2026 G.P. Halkes
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 3, as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Tests of the library API which are not easily expressed as config files and expected output. */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "t3config/config.h"
+
+static size_t failed;
+
+/* Statistics of the allocator installed for all tests. If fail_after is not negative, it is the
+   number of allocations that succeed before all further allocations fail. */
+static struct {
+  long live, total, fail_after;
+} allocations = {0, 0, -1};
+
+/* The number of allocations which are never released, because they hold the names of the files of
+   an image loaded with t3_config_load_static. */
+static long retained_allocations;
+
+#define CHECK(x)                                                  \
+  do {                                                            \
+    if (!(x)) {                                                   \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); \
+      failed++;                                                   \
+    }                                                             \
+  } while (0)
+
+static t3_bool allocation_fails(void) {
+  if (allocations.fail_after == 0) {
+    return t3_true;
+  }
+  if (allocations.fail_after > 0) {
+    allocations.fail_after--;
+  }
+  allocations.total++;
+  return t3_false;
+}
+
+static void *counting_allocate(size_t size, void *data) {
+  (void)data;
+  if (allocation_fails()) {
+    return NULL;
+  }
+  allocations.live++;
+  return malloc(size);
+}
+
+static void *counting_reallocate(void *ptr, size_t size, void *data) {
+  (void)data;
+  if (allocation_fails()) {
+    return NULL;
+  }
+  if (ptr == NULL) {
+    allocations.live++;
+  }
+  return realloc(ptr, size);
+}
+
+static void counting_release(void *ptr, void *data) {
+  (void)data;
+  allocations.live--;
+  free(ptr);
+}
+
+static const t3_config_allocator_t counting_allocator = {counting_allocate, counting_reallocate,
+                                                         counting_release, NULL};
+
+static t3_config_schema_t *read_schema(const char *text) {
+  t3_config_error_t error;
+  t3_config_schema_t *schema = t3_config_read_schema_buffer(text, strlen(text), &error, NULL);
+
+  if (schema == NULL) {
+    printf("Could not read schema: %s at line %d\n", t3_config_strerror(error.error),
+           error.line_number);
+    exit(EXIT_FAILURE);
+  }
+  return schema;
+}
+
+static t3_config_t *read_config(const char *text) {
+  t3_config_error_t error;
+  t3_config_t *config = t3_config_read_buffer(text, strlen(text), &error, NULL);
+
+  if (config == NULL) {
+    printf("Could not read config: %s at line %d\n", t3_config_strerror(error.error),
+           error.line_number);
+    exit(EXIT_FAILURE);
+  }
+  return config;
+}
+
+/*============================ Allocator ============================*/
+
+static void test_allocator(void) {
+  static const char text[] =
+      "a {\n b = \"a string too long to be stored in the item\"\n c = ( 1, 2 )\n}\n";
+  t3_config_t *config, *frozen;
+  long live = allocations.live, total = allocations.total, n;
+  int error;
+  char *str;
+
+  /* All memory, including memory returned to the caller, comes from the allocator. */
+  config = read_config(text);
+  CHECK(allocations.total > total && allocations.live > live);
+  str = t3_config_take_string(t3_config_get(t3_config_get(config, "a"), "b"));
+  CHECK(str != NULL && strcmp(str, "a string too long to be stored in the item") == 0);
+  counting_release(str, NULL);
+
+  /* Each failing allocation is reported, and all memory allocated before it is released. */
+  live = allocations.live;
+  for (n = 0;; n++) {
+    allocations.fail_after = n;
+    error = T3_ERR_SUCCESS;
+    frozen = t3_config_freeze(config, &error);
+    allocations.fail_after = -1;
+    if (frozen != NULL) {
+      break;
+    }
+    CHECK(error == T3_ERR_OUT_OF_MEMORY);
+    CHECK(allocations.live == live);
+  }
+  CHECK(n > 0);
+  t3_config_delete(frozen);
+  CHECK(allocations.live == live);
+
+  t3_config_delete(config);
+}
+
+/*============================ Freezing ============================*/
+
+/** Check that all items of the config built by test_freeze can be found in @p frozen. */
+static void check_frozen(const t3_config_t *frozen, const t3_config_t *config) {
+  char name[16];
+  int i;
+
+  CHECK(t3_config_equal(frozen, config));
+  for (i = 0; i < 200; i++) {
+    sprintf(name, "key%d", i);
+    CHECK(t3_config_get_int(t3_config_get(frozen, name)) == i);
+  }
+  CHECK(t3_config_get(frozen, "key200") == NULL);
+  CHECK(t3_config_get(frozen, "") == NULL);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(frozen, "section"), "x")) == 1);
+}
+
+static void test_freeze(void) {
+  t3_config_t *config = t3_config_new(), *frozen, *copy;
+  long total, needed, n, fallbacks = 0;
+  char name[16];
+  int i, error;
+
+  for (i = 0; i < 200; i++) {
+    sprintf(name, "key%d", i);
+    CHECK(t3_config_add_int(config, name, i) == T3_ERR_SUCCESS);
+  }
+  CHECK(t3_config_add_int(t3_config_add_section(config, "section", NULL), "x", 1) ==
+        T3_ERR_SUCCESS);
+
+  total = allocations.total;
+  frozen = t3_config_freeze(config, &error);
+  needed = allocations.total - total;
+  CHECK(frozen != NULL);
+  if (frozen == NULL) {
+    t3_config_delete(config);
+    return;
+  }
+  check_frozen(frozen, config);
+
+  /* Frozen configs can not be modified, but copies of them can. */
+  CHECK(t3_config_add_int(frozen, "key0", 1) == T3_ERR_BAD_ARG);
+  CHECK(t3_config_unlink(frozen, "key0") == NULL);
+  CHECK(t3_config_get_mutable(frozen, "section") == NULL);
+  t3_config_delete(t3_config_get(frozen, "section"));
+  copy = t3_config_clone(frozen, NULL);
+  CHECK(copy != NULL && t3_config_add_int(copy, "key0", 1) == T3_ERR_SUCCESS);
+  CHECK(t3_config_get_int(t3_config_get(frozen, "key0")) == 0);
+  t3_config_delete(copy);
+  t3_config_delete(frozen);
+
+  /* If there is no memory to build the perfect hash of a section, it is searched linearly. */
+  for (n = 0; n < needed; n++) {
+    allocations.fail_after = n;
+    frozen = t3_config_freeze(config, NULL);
+    allocations.fail_after = -1;
+    if (frozen != NULL) {
+      fallbacks++;
+      check_frozen(frozen, config);
+      t3_config_delete(frozen);
+    }
+  }
+  CHECK(fallbacks > 0);
+
+  t3_config_delete(config);
+}
+
+/*============================ File names ============================*/
+
+static FILE *open_include(const char *name, void *data) {
+  FILE *file = tmpfile();
+
+  (void)data;
+  if (file != NULL) {
+    fputs(strcmp(name, "first") == 0 ? "a = 1\n" : "b = 2\n", file);
+    rewind(file);
+  }
+  return file;
+}
+
+/** Read a config which includes the files "first" and "second", provided by open_include. */
+static t3_config_t *read_with_includes(void) {
+  static const char text[] = "%include = \"first\"\ns {\n %include = \"second\"\n}\nc = 3\n";
+  t3_config_error_t error;
+  t3_config_opts_t opts;
+  t3_config_t *config;
+
+  opts.flags = T3_CONFIG_INCLUDE_USER;
+  opts.include_callback.user.open = open_include;
+  opts.include_callback.user.data = NULL;
+  if ((config = t3_config_read_buffer(text, sizeof(text) - 1, &error, &opts)) == NULL) {
+    printf("Could not read config: %s at line %d\n", t3_config_strerror(error.error),
+           error.line_number);
+    exit(EXIT_FAILURE);
+  }
+  return config;
+}
+
+static void test_file_names(void) {
+  long live = allocations.live;
+  t3_config_t *config = read_with_includes(), *again = read_with_includes(), *copy;
+  const char *first;
+
+  first = t3_config_get_file_name(t3_config_get(config, "a"));
+  CHECK(first != NULL && strcmp(first, "first") == 0);
+  CHECK(strcmp(t3_config_get_file_name(t3_config_get(t3_config_get(config, "s"), "b")),
+               "second") == 0);
+  CHECK(t3_config_get_file_name(t3_config_get(config, "c")) == NULL);
+  /* Each name is stored once, and found again when it is read again. */
+  CHECK(t3_config_get_file_name(t3_config_get(again, "a")) == first);
+
+  /* The names remain as long as any item read from the file exists. */
+  t3_config_delete(again);
+  copy = t3_config_clone(t3_config_get(config, "a"), NULL);
+  t3_config_delete(config);
+  CHECK(copy != NULL && strcmp(t3_config_get_file_name(copy), "first") == 0);
+  t3_config_delete(copy);
+  CHECK(allocations.live == live);
+}
+
+/*============================ Images ============================*/
+
+/* Images must be aligned to 8 bytes to be used by t3_config_load_static. */
+typedef union {
+  char data[4096];
+  uint64_t align;
+} image_buffer_t;
+
+/** Write @p config as an image to @p buffer, and return the size of the image. */
+static size_t write_image(const t3_config_t *config, image_buffer_t *buffer) {
+  FILE *file = tmpfile();
+  size_t size = 0;
+
+  CHECK(file != NULL);
+  if (file == NULL) {
+    return 0;
+  }
+  CHECK(t3_config_write_image(config, file) == T3_ERR_SUCCESS);
+  if (ftell(file) > 0 && (size_t)ftell(file) <= sizeof(buffer->data)) {
+    size = (size_t)ftell(file);
+    rewind(file);
+    CHECK(fread(buffer->data, 1, size, file) == size);
+  }
+  fclose(file);
+  CHECK(size > 0);
+  return size;
+}
+
+static void check_image_contents(const t3_config_t *image, const t3_config_t *config) {
+  CHECK(t3_config_equal(image, config));
+  CHECK(t3_config_hash(image) == t3_config_hash(config));
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(image, "s"), "b")) == 2);
+  CHECK(strcmp(t3_config_get_file_name(t3_config_get(image, "a")), "first") == 0);
+  CHECK(t3_config_get_file_name(t3_config_get(image, "a")) ==
+        t3_config_get_file_name(t3_config_get(config, "a")));
+  CHECK(t3_config_add_int((t3_config_t *)image, "d", 4) != T3_ERR_SUCCESS);
+}
+
+static void test_image(void) {
+  static image_buffer_t buffer;
+  t3_config_t *config = read_with_includes(), *image;
+  size_t size = write_image(config, &buffer), i;
+  int error, bit;
+
+  if (size == 0) {
+    t3_config_delete(config);
+    return;
+  }
+  image = t3_config_read_image_buffer(buffer.data, size, &error);
+  CHECK(image != NULL);
+  if (image != NULL) {
+    check_image_contents(image, config);
+    t3_config_delete(image);
+  }
+
+  /* A truncated image is always detected. A corrupted image is either detected, or results in
+     a config which can be used safely. */
+  for (i = 0; i < size; i++) {
+    CHECK(t3_config_read_image_buffer(buffer.data, i, &error) == NULL &&
+          error == T3_ERR_INVALID_IMAGE);
+  }
+  for (i = 0; i < size; i++) {
+    for (bit = 0; bit < 8; bit++) {
+      buffer.data[i] ^= (char)(1 << bit);
+      if ((image = t3_config_read_image_buffer(buffer.data, size, &error)) != NULL) {
+        t3_config_hash(image);
+        t3_config_get(t3_config_get(image, "s"), "b");
+        t3_config_delete(image);
+      } else {
+        CHECK(error == T3_ERR_INVALID_IMAGE);
+      }
+      buffer.data[i] ^= (char)(1 << bit);
+    }
+  }
+  t3_config_delete(config);
+}
+
+static void test_load_static(void) {
+  static image_buffer_t buffer, corrupted;
+  long live = allocations.live, total;
+  t3_config_t *config = read_with_includes(), *image;
+  size_t size = write_image(config, &buffer), offset;
+  int error;
+  char flags;
+
+  if (size == 0) {
+    t3_config_delete(config);
+    return;
+  }
+  memcpy(corrupted.data, buffer.data, size);
+
+  CHECK(t3_config_load_static(buffer.data + 1, size - 1, &error) == NULL &&
+        error == T3_ERR_BAD_ARG);
+
+  /* The image is converted in place, without using the allocator. */
+  total = allocations.total;
+  image = t3_config_load_static(buffer.data, size, &error);
+  CHECK(allocations.total == total);
+  CHECK(image != NULL);
+  if (image == NULL) {
+    t3_config_delete(config);
+    return;
+  }
+  CHECK((char *)image > buffer.data && (char *)image < buffer.data + size);
+  check_image_contents(image, config);
+  t3_config_delete(image);
+  CHECK(t3_config_load_static(buffer.data, size, &error) == image);
+  CHECK(t3_config_get_int(t3_config_get(image, "c")) == 3);
+  /* A converted image is no longer a valid image for the other functions. */
+  CHECK(t3_config_read_image_buffer(buffer.data, size, &error) == NULL);
+
+  /* An image with invalid flags in the root item is rejected, and stays rejected. */
+  offset = (size_t)((char *)image - buffer.data) + 1;
+  flags = corrupted.data[offset];
+  corrupted.data[offset] = (char)0xff;
+  CHECK(t3_config_load_static(corrupted.data, size, &error) == NULL &&
+        error == T3_ERR_INVALID_IMAGE);
+  corrupted.data[offset] = flags;
+  CHECK(t3_config_load_static(corrupted.data, size, &error) == NULL &&
+        error == T3_ERR_INVALID_IMAGE);
+
+  /* Only the file names of the loaded image remain: two name records, the hash table and a chunk
+     of the file table. */
+  t3_config_delete(config);
+  retained_allocations = allocations.live - live;
+  CHECK(retained_allocations == 4);
+}
+
+/*============================ Sharing ============================*/
+
+static void test_clone_sharing(void) {
+  static const char text[] =
+      "a {\n b {\n c = 1\n }\n x = 2\n}\nd = ( 3, \"a string too long for an item\" )\n";
+  t3_config_t *config = read_config(text), *copy, *a, *b;
+
+  /* Items shared with a clone belong to the config they were cloned from. Modifying them copies
+     the path to them first, such that the clone keeps the original items. */
+  copy = t3_config_clone(config, NULL);
+  CHECK(copy != NULL);
+  a = t3_config_get(config, "a");
+  CHECK(t3_config_add_int(a, "y", 5) == T3_ERR_SUCCESS);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(config, "a"), "y")) == 5);
+  CHECK(t3_config_get(t3_config_get(copy, "a"), "y") == NULL);
+  b = t3_config_get(t3_config_get(config, "a"), "b");
+  CHECK(t3_config_add_int(b, "y", 6) == T3_ERR_SUCCESS);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(t3_config_get(config, "a"), "b"), "y")) ==
+        6);
+  CHECK(t3_config_get(t3_config_get(t3_config_get(copy, "a"), "b"), "y") == NULL);
+  b = t3_config_get(config, "d");
+  t3_config_erase_from_list(b, t3_config_get(b, NULL));
+  CHECK(t3_config_get_length(t3_config_get(config, "d")) == 1);
+  CHECK(t3_config_get_length(t3_config_get(copy, "d")) == 2);
+
+  /* The original items now only belong to the clone, and are modified through it with
+     t3_config_get_mutable. */
+  CHECK(t3_config_get(copy, "a") == a);
+  CHECK(t3_config_add_int(a, "z", 1) == T3_ERR_BAD_ARG);
+  CHECK(t3_config_unlink(a, "x") == NULL);
+  a = t3_config_get_mutable(copy, "a");
+  b = t3_config_get_mutable(a, "b");
+  CHECK(b != NULL && t3_config_add_int(b, "z", 1) == T3_ERR_SUCCESS);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(t3_config_get(copy, "a"), "b"), "z")) ==
+        1);
+  CHECK(t3_config_get(t3_config_get(t3_config_get(config, "a"), "b"), "z") == NULL);
+  t3_config_delete(copy);
+  t3_config_delete(config);
+
+  /* A clone remains intact when the original is deleted. */
+  config = read_config(text);
+  copy = t3_config_clone(config, NULL);
+  t3_config_delete(config);
+  config = read_config(text);
+  CHECK(copy != NULL && t3_config_equal(copy, config));
+  t3_config_delete(config);
+  CHECK(t3_config_add_int(t3_config_get_mutable(copy, "a"), "y", 5) == T3_ERR_SUCCESS);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(copy, "a"), "y")) == 5);
+  t3_config_delete(copy);
+}
+
+static void test_dedup(void) {
+  static const char text[] =
+      "e1 { method = \"GET with a long name\"; limits { rate = 100; burst = 5 }; "
+      "tags = ( \"a string too long for an item\", yes ) }; "
+      "e2 { method = \"GET with a long name\"; limits { rate = 100; burst = 5 }; "
+      "tags = ( \"a string too long for an item\", yes ) }\n"
+      "e3 { method = \"POST with a long name\"; limits { rate = 100; burst = 5 }; "
+      "tags = ( \"a string too long for an item\", yes ) }\n"
+      "z1 = 0.0\nz2 = -0.0\n";
+  t3_config_t *config = read_config(text), *original = read_config(text), *e1, *e2, *tags, *copy;
+  t3_config_opts_t opts;
+  long live, n;
+  char *str;
+
+  CHECK(t3_config_dedup(NULL) == T3_ERR_BAD_ARG);
+  CHECK(t3_config_dedup(config) == T3_ERR_SUCCESS);
+  CHECK(t3_config_equal(config, original));
+  CHECK(t3_config_hash(config) == t3_config_hash(original));
+  CHECK(t3_config_get_number(t3_config_get(config, "z2")) == 0.0);
+
+  /* Identical strings are stored once, as are identical sections and lists without sections or
+     lists in them, but only if they were read from the same location. */
+  e1 = t3_config_get(config, "e1");
+  e2 = t3_config_get(config, "e2");
+  CHECK(t3_config_get_string(t3_config_get(e1, "method")) ==
+        t3_config_get_string(t3_config_get(e2, "method")));
+  CHECK(t3_config_get(e1, NULL) != t3_config_get(e2, NULL));
+  CHECK(t3_config_get(t3_config_get(e1, "limits"), NULL) ==
+        t3_config_get(t3_config_get(e2, "limits"), NULL));
+  CHECK(t3_config_get(t3_config_get(e1, "tags"), NULL) ==
+        t3_config_get(t3_config_get(e2, "tags"), NULL));
+  CHECK(t3_config_get(t3_config_get(e1, "limits"), NULL) !=
+        t3_config_get(t3_config_get(t3_config_get(config, "e3"), "limits"), NULL));
+  CHECK(t3_config_get_line_number(
+            t3_config_get(t3_config_get(t3_config_get(config, "e3"), "limits"), "rate")) == 2);
+  CHECK(t3_config_dedup(config) == T3_ERR_SUCCESS);
+  CHECK(t3_config_equal(config, original));
+
+  /* Adding or removing items copies the shared items first. */
+  CHECK(t3_config_add_int(t3_config_get(e1, "limits"), "rate", 7) == T3_ERR_SUCCESS);
+  t3_config_erase(t3_config_get(e2, "limits"), "burst");
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(e1, "limits"), "rate")) == 7);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(e1, "limits"), "burst")) == 5);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(e2, "limits"), "rate")) == 100);
+  CHECK(t3_config_get(t3_config_get(e2, "limits"), "burst") == NULL);
+
+  /* The shared items themselves must be retrieved with t3_config_get_mutable. */
+  tags = t3_config_get(e1, "tags");
+  CHECK(t3_config_take_string(t3_config_get(tags, NULL)) == NULL);
+  str = t3_config_take_string(t3_config_get_mutable(tags, NULL));
+  CHECK(str != NULL && strcmp(str, "a string too long for an item") == 0);
+  counting_release(str, NULL);
+  CHECK(strcmp(t3_config_get_string(t3_config_get(t3_config_get(e2, "tags"), NULL)),
+               "a string too long for an item") == 0);
+
+  /* Deduplicating part of a clone copies the path to it first. */
+  copy = t3_config_clone(config, NULL);
+  CHECK(copy != NULL && t3_config_dedup(t3_config_get_mutable(copy, "e2")) == T3_ERR_SUCCESS);
+  CHECK(t3_config_dedup(copy) == T3_ERR_SUCCESS && t3_config_equal(copy, config));
+  t3_config_delete(copy);
+
+  /* Running out of memory leaves the contents unchanged. */
+  t3_config_delete(config);
+  live = allocations.live;
+  for (n = 0;; n++) {
+    config = read_config(text);
+    allocations.fail_after = n;
+    if (t3_config_dedup(config) == T3_ERR_SUCCESS) {
+      allocations.fail_after = -1;
+      t3_config_delete(config);
+      break;
+    }
+    allocations.fail_after = -1;
+    CHECK(t3_config_equal(config, original));
+    t3_config_delete(config);
+    CHECK(allocations.live == live);
+  }
+  CHECK(n > 0);
+
+  /* Configs read with T3_CONFIG_DEDUP can be modified as usual. */
+  opts.flags = T3_CONFIG_DEDUP;
+  config = t3_config_read_buffer(text, sizeof(text) - 1, NULL, &opts);
+  CHECK(config != NULL && t3_config_equal(config, original));
+  e1 = t3_config_get(config, "e1");
+  e2 = t3_config_get(config, "e2");
+  CHECK(t3_config_add_int(t3_config_get(e2, "limits"), "burst", 6) == T3_ERR_SUCCESS);
+  tags = t3_config_get(e1, "tags");
+  t3_config_erase_from_list(tags, t3_config_get(tags, NULL));
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(e1, "limits"), "burst")) == 5);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(e2, "limits"), "burst")) == 6);
+  CHECK(t3_config_get_length(t3_config_get(e1, "tags")) == 1);
+  CHECK(t3_config_get_length(t3_config_get(e2, "tags")) == 2);
+  t3_config_delete(config);
+
+  t3_config_delete(original);
+}
+
+/*============================ Paths ============================*/
+
+static void check_paths(const t3_config_t *config) {
+  static const char *const found[][2] = {
+      {"a/b/c", "abc"},     {"/a/b/c", "abc"},    {"l[0]/name", "zero"},
+      {"l[2]/name", "two"}, {"m[1][0]", "inner"},
+  };
+  static const char *const missing[] = {"a/b/x", "a/b/c/d", "l[3]", "l/name", "a[0]", "m[0][0]"};
+  static const char *const malformed[] = {"a//b", "a/", "[1]", "a[", "a[x]", "a[1", "a b", "a[1]x"};
+  t3_config_path_t *path;
+  size_t i;
+  int error;
+
+  for (i = 0; i < sizeof(found) / sizeof(found[0]); i++) {
+    path = t3_config_path_compile(found[i][0], NULL);
+    CHECK(path != NULL && strcmp(t3_config_get_string(t3_config_get_path(config, path)),
+                                 found[i][1]) == 0);
+    t3_config_path_delete(path);
+  }
+  for (i = 0; i < sizeof(missing) / sizeof(missing[0]); i++) {
+    path = t3_config_path_compile(missing[i], NULL);
+    CHECK(path != NULL && t3_config_get_path(config, path) == NULL);
+    t3_config_path_delete(path);
+  }
+  for (i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) {
+    error = T3_ERR_SUCCESS;
+    CHECK(t3_config_path_compile(malformed[i], &error) == NULL && error == T3_ERR_PARSE_ERROR);
+  }
+  CHECK(t3_config_path_compile("l[99999999999999999999999]", &error) == NULL &&
+        error == T3_ERR_OUT_OF_RANGE);
+  CHECK(t3_config_path_compile(NULL, &error) == NULL && error == T3_ERR_BAD_ARG);
+
+  path = t3_config_path_compile("", NULL);
+  CHECK(path != NULL && t3_config_get_path(config, path) == config);
+  t3_config_path_delete(path);
+}
+
+static void test_paths(void) {
+  t3_config_t *config, *frozen;
+
+  config = read_config(
+      "a {\n b {\n c = \"abc\"\n }\n}\n"
+      "l = ( { name = \"zero\" }, { }, { name = \"two\" } )\nm = ( 1, ( \"inner\" ) )\n");
+  check_paths(config);
+  /* Frozen configs are searched differently, so the paths are checked again. */
+  frozen = t3_config_freeze(config, NULL);
+  CHECK(frozen != NULL);
+  if (frozen != NULL) {
+    check_paths(frozen);
+    t3_config_delete(frozen);
+  }
+  t3_config_delete(config);
+}
+
+/*============================ Queries ============================*/
+
+/** Append the string value, the value of the key "name", or the name of @p item to the buffer
+    @p data. */
+static void append_name(const t3_config_t *item, void *data) {
+  const char *name = t3_config_get_string(item);
+
+  if (name == NULL) {
+    name = t3_config_get_string(t3_config_get(item, "name"));
+  }
+  if (name == NULL) {
+    name = t3_config_get_name(item) == NULL ? "?" : t3_config_get_name(item);
+  }
+  strcat(data, name);
+  strcat(data, ",");
+}
+
+static void check_queries(const t3_config_t *config) {
+  static const char *const queries[][2] = {
+      {"svc/backends/*[weight > 10]", "b2,b3,"},
+      {"/svc/backends/*[weight > /min]/name", "b3,"},
+      {"svc/backends/*[name = \"b1\" | weight = 0]/weight", "weight,weight,"},
+      {"svc/backends[3]", "b3,"},
+      {"svc/backends/*/tags[0]", "b0,b1,b2,b3,"},
+      {"svc/backends/*[weight > 10][0]", ""},
+      {"*/backends[1]/name", "b1,"},
+      {"sec/*", "a,bb,"},
+      {"nope/*", ""},
+      {"", "?,"},
+  };
+  t3_config_query_t *query;
+  char result[100];
+  size_t i;
+  long total;
+
+  for (i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+    query = t3_config_query_compile(queries[i][0], NULL);
+    CHECK(query != NULL);
+    if (query == NULL) {
+      continue;
+    }
+    result[0] = 0;
+    /* Running a query does not allocate memory. */
+    total = allocations.total;
+    CHECK(t3_config_query_run(query, config, append_name, result) == T3_ERR_SUCCESS);
+    CHECK(allocations.total == total);
+    if (strcmp(result, queries[i][1]) != 0) {
+      printf("Query %s returned %s instead of %s\n", queries[i][0], result, queries[i][1]);
+      failed++;
+    }
+    t3_config_query_delete(query);
+  }
+}
+
+static void test_queries(void) {
+  static const char *const malformed[] = {"a//b", "a/", "[1]", "a[", "*[ ']' ", "a b", "**"};
+  t3_config_t *config, *frozen;
+  t3_config_query_t *query;
+  long live, n;
+  size_t i;
+  int error;
+
+  config = read_config(
+      "min = 25\nsvc {\n backends = (\n"
+      "  { name = \"b0\"\n weight = 0\n tags = ( \"b0\" ) },\n"
+      "  { name = \"b1\"\n weight = 10\n tags = ( \"b1\" ) },\n"
+      "  { name = \"b2\"\n weight = 20\n tags = ( \"b2\" ) },\n"
+      "  { name = \"b3\"\n weight = 30\n tags = ( \"b3\" ) },\n"
+      "  { }\n )\n}\nsec {\n a = 1\n bb = 2\n}\n");
+  check_queries(config);
+  /* Frozen configs are searched differently, so the queries are checked again. */
+  frozen = t3_config_freeze(config, NULL);
+  CHECK(frozen != NULL);
+  if (frozen != NULL) {
+    check_queries(frozen);
+    t3_config_delete(frozen);
+  }
+
+  for (i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) {
+    error = T3_ERR_SUCCESS;
+    CHECK(t3_config_query_compile(malformed[i], &error) == NULL && error == T3_ERR_PARSE_ERROR);
+  }
+  CHECK(t3_config_query_compile("a/*[99999999999999999999999]", &error) == NULL &&
+        error == T3_ERR_OUT_OF_RANGE);
+  CHECK(t3_config_query_compile(NULL, &error) == NULL && error == T3_ERR_BAD_ARG);
+  query = t3_config_query_compile("*", NULL);
+  CHECK(t3_config_query_run(query, NULL, append_name, NULL) == T3_ERR_BAD_ARG);
+  CHECK(t3_config_query_run(query, config, NULL, NULL) == T3_ERR_BAD_ARG);
+  t3_config_query_delete(query);
+
+  /* Each failing allocation is reported, and all memory allocated before it is released. */
+  live = allocations.live;
+  for (n = 0;; n++) {
+    allocations.fail_after = n;
+    error = T3_ERR_SUCCESS;
+    query = t3_config_query_compile("svc/backends/*[weight > /min]/name", &error);
+    allocations.fail_after = -1;
+    if (query != NULL) {
+      break;
+    }
+    CHECK(error == T3_ERR_OUT_OF_MEMORY);
+    CHECK(allocations.live == live);
+  }
+  t3_config_query_delete(query);
+
+  t3_config_delete(config);
+}
+
+/*============================ Expressions ============================*/
+
+static void test_expressions(void) {
+  t3_config_schema_t *schema;
+  t3_config_t *config, *root;
+  t3_config_expr_t *expr;
+  int error;
+
+  config = read_config("weight = 50\nname = \"b1\"\n");
+  root = read_config("min = 40\n");
+
+  /* Without a schema, any expression is accepted, and missing keys make comparisons false. */
+  expr = t3_config_expr_compile("weight > 10 & name = \"b1\"", NULL, NULL, &error);
+  CHECK(expr != NULL && t3_config_expr_eval(expr, config, NULL));
+  t3_config_expr_delete(expr);
+  expr = t3_config_expr_compile("weight > /min", NULL, NULL, &error);
+  CHECK(expr != NULL && t3_config_expr_eval(expr, config, root));
+  CHECK(!t3_config_expr_eval(expr, config, NULL));
+  t3_config_expr_delete(expr);
+  expr = t3_config_expr_compile("bogus > 10", NULL, NULL, &error);
+  CHECK(expr != NULL && !t3_config_expr_eval(expr, config, NULL));
+  CHECK(!t3_config_expr_eval(NULL, config, NULL) && !t3_config_expr_eval(expr, NULL, NULL));
+  t3_config_expr_delete(expr);
+  t3_config_expr_delete(NULL);
+  CHECK(t3_config_expr_compile("weight >", NULL, NULL, &error) == NULL &&
+        error == T3_ERR_PARSE_ERROR);
+  CHECK(t3_config_expr_compile(NULL, NULL, NULL, &error) == NULL && error == T3_ERR_BAD_ARG);
+
+  /* With a schema, names must be allowed keys and compared values must have compatible types. */
+  schema = read_schema(
+      "allowed-keys { weight { type = \"int\" }\n name { type = \"string\" } }\n"
+      "types {\n backend { type = \"section\"\n allowed-keys { port { type = \"int\" } } }\n"
+      " alias { type = \"backend\" }\n count { type = \"int\" }\n}\n");
+  expr = t3_config_expr_compile("weight > 10", schema, NULL, &error);
+  CHECK(expr != NULL && t3_config_expr_eval(expr, config, NULL));
+  t3_config_expr_delete(expr);
+  expr = t3_config_expr_compile("port > 10", schema, "alias", &error);
+  CHECK(expr != NULL);
+  t3_config_expr_delete(expr);
+  CHECK(t3_config_expr_compile("bogus > 10", schema, NULL, &error) == NULL &&
+        error == T3_ERR_INVALID_CONSTRAINT);
+  CHECK(t3_config_expr_compile("name > 10", schema, NULL, &error) == NULL &&
+        error == T3_ERR_INVALID_CONSTRAINT);
+  CHECK(t3_config_expr_compile("weight > 10", schema, "backend", &error) == NULL &&
+        error == T3_ERR_INVALID_CONSTRAINT);
+  CHECK(t3_config_expr_compile("weight > 10", schema, "count", &error) == NULL &&
+        error == T3_ERR_BAD_ARG);
+  CHECK(t3_config_expr_compile("weight > 10", schema, "missing", &error) == NULL &&
+        error == T3_ERR_BAD_ARG);
+  CHECK(t3_config_expr_compile("weight > 10", NULL, "backend", &error) == NULL &&
+        error == T3_ERR_BAD_ARG);
+
+  t3_config_delete_schema(schema);
+  t3_config_delete(root);
+  t3_config_delete(config);
+}
+
+/*============================ Binding ============================*/
+
+typedef struct {
+  int64_t port, retries;
+  double timeout;
+  const char *host, *user;
+  t3_bool debug;
+  const t3_config_t *db, *list;
+  int64_t wrong_type;
+} bind_result_t;
+
+static const t3_config_binding_t bindings[] = {
+    {"server/port", T3_CONFIG_INT, offsetof(bind_result_t, port), T3_CONFIG_BIND_REQUIRED, {0}},
+    {"server/timeout", T3_CONFIG_NUMBER, offsetof(bind_result_t, timeout), 0, {0}},
+    {"server/host", T3_CONFIG_STRING, offsetof(bind_result_t, host), 0, {0}},
+    {"server/retries", T3_CONFIG_INT, offsetof(bind_result_t, retries), 0, {0}},
+    {"debug", T3_CONFIG_BOOL, offsetof(bind_result_t, debug), 0, {0}},
+    {"db", T3_CONFIG_SECTION, offsetof(bind_result_t, db), 0, {0}},
+    {"list", T3_CONFIG_LIST, offsetof(bind_result_t, list), 0, {0}},
+    {"server/user", T3_CONFIG_STRING, offsetof(bind_result_t, user), T3_CONFIG_BIND_REQUIRED,
+     {0}},
+    {"server/host", T3_CONFIG_INT, offsetof(bind_result_t, wrong_type), 0, {0}},
+    {"debug/x", T3_CONFIG_INT, offsetof(bind_result_t, wrong_type), 0, {0}},
+};
+
+#define BINDING_COUNT (sizeof(bindings) / sizeof(bindings[0]))
+
+static void check_bind(const t3_config_t *config) {
+  t3_config_binding_t defaults[BINDING_COUNT], invalid[2];
+  int status[BINDING_COUNT + 1];
+  bind_result_t result;
+  size_t i;
+
+  memcpy(defaults, bindings, sizeof(bindings));
+  defaults[3].dflt.integer = 3;
+  memset(&result, 0, sizeof(result));
+  result.user = "untouched";
+  result.wrong_type = -1;
+  for (i = 0; i < BINDING_COUNT + 1; i++) {
+    status[i] = 1;
+  }
+
+  /* All bindings are filled, except for the failing ones, which are reported in order. */
+  CHECK(t3_config_bind(config, defaults, BINDING_COUNT, &result, status) == T3_ERR_MISSING_KEY);
+  CHECK(result.port == 8080 && result.timeout == 2.0 && strcmp(result.host, "localhost") == 0);
+  CHECK(result.retries == 3 && result.debug);
+  CHECK(result.db == t3_config_get(config, "db") && result.list == t3_config_get(config, "list"));
+  CHECK(strcmp(result.user, "untouched") == 0 && result.wrong_type == -1);
+  for (i = 0; i < 7; i++) {
+    CHECK(status[i] == T3_ERR_SUCCESS);
+  }
+  CHECK(status[7] == T3_ERR_MISSING_KEY);
+  CHECK(status[8] == T3_ERR_INVALID_KEY_TYPE);
+  CHECK(status[9] == T3_ERR_INVALID_KEY_TYPE);
+  CHECK(status[BINDING_COUNT] == 1);
+  CHECK(t3_config_bind(config, defaults + 8, 2, &result, NULL) == T3_ERR_INVALID_KEY_TYPE);
+  CHECK(t3_config_bind(config, defaults, 7, &result, NULL) == T3_ERR_SUCCESS);
+
+  /* An invalid path only fails its own binding. */
+  memcpy(invalid, bindings, sizeof(invalid));
+  invalid[1].path = "db//name";
+  result.port = 0;
+  CHECK(t3_config_bind(config, invalid, 2, &result, status) == T3_ERR_BAD_ARG);
+  CHECK(status[0] == T3_ERR_SUCCESS && status[1] == T3_ERR_BAD_ARG && result.port == 8080);
+
+  /* Invalid arguments and allocation failures are reported without modifying the result or
+     status. */
+  status[0] = 1;
+  result.port = 0;
+  CHECK(t3_config_bind(t3_config_get(config, "list"), bindings, 1, &result, status) ==
+        T3_ERR_BAD_ARG);
+  CHECK(t3_config_bind(NULL, bindings, 1, &result, status) == T3_ERR_BAD_ARG);
+  allocations.fail_after = 0;
+  CHECK(t3_config_bind(config, bindings, 1, &result, status) == T3_ERR_OUT_OF_MEMORY);
+  allocations.fail_after = -1;
+  CHECK(status[0] == 1 && result.port == 0);
+}
+
+static void test_bind(void) {
+  t3_config_t *config, *frozen;
+
+  config = read_config(
+      "server {\n port = 8080\n timeout = 2\n host = \"localhost\"\n}\ndebug = yes\n"
+      "db {\n name = \"x\"\n}\nlist = ( 1, 2 )\n");
+  check_bind(config);
+  /* Frozen configs look up names differently, so the bindings are checked again. */
+  frozen = t3_config_freeze(config, NULL);
+  CHECK(frozen != NULL);
+  if (frozen != NULL) {
+    check_bind(frozen);
+    t3_config_delete(frozen);
+  }
+  t3_config_delete(config);
+}
+
+/*============================ Overlays ============================*/
+
+static void count_item(const t3_config_t *item, void *data) {
+  (void)item;
+  (*(int *)data)++;
+}
+
+static void test_overlay(void) {
+  t3_config_t *base, *top, *flat, *section;
+  t3_config_overlay_t *overlay;
+  long total;
+  int count = 0;
+
+  base = read_config("a {\n b = 1\n c = 2\n}\nd {\n e = 3\n}\nf = 4\ng {\n h = 9\n}\n");
+  top = read_config("a {\n b = 5\n}\nd = 6\n");
+  overlay = t3_config_overlay_new();
+  CHECK(overlay != NULL);
+  CHECK(t3_config_overlay_push(overlay, base) == T3_ERR_SUCCESS);
+  CHECK(t3_config_overlay_push(overlay, top) == T3_ERR_SUCCESS);
+
+  /* Lookups stop at the highest layer defining the path, and do not allocate memory. */
+  total = allocations.total;
+  CHECK(t3_config_get_int(t3_config_overlay_get(overlay, "a/b")) == 5);
+  CHECK(t3_config_get_int(t3_config_overlay_get(overlay, "a/c")) == 2);
+  CHECK(t3_config_get_int(t3_config_overlay_get(overlay, "f")) == 4);
+  CHECK(t3_config_overlay_get(overlay, "a/x") == NULL);
+  CHECK(t3_config_overlay_get(overlay, NULL) == top);
+  /* A value in a higher layer hides the sections below it. */
+  CHECK(t3_config_get_int(t3_config_overlay_get(overlay, "d")) == 6);
+  CHECK(t3_config_overlay_get(overlay, "d/e") == NULL);
+  /* Allocation failures are not mistaken for missing items. */
+  allocations.fail_after = 0;
+  CHECK(t3_config_get_int(t3_config_overlay_get(overlay, "a/c")) == 2);
+  allocations.fail_after = -1;
+  CHECK(allocations.total == total);
+
+  CHECK(t3_config_overlay_iterate(overlay, "a", count_item, &count) == T3_ERR_SUCCESS);
+  CHECK(count == 2);
+
+  /* The flattened config does not share items with the layers, which remain modifiable. */
+  flat = t3_config_overlay_flatten(overlay, NULL);
+  CHECK(flat != NULL);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(flat, "a"), "b")) == 5);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(flat, "a"), "c")) == 2);
+  CHECK(t3_config_get_int(t3_config_get(flat, "d")) == 6);
+  CHECK(t3_config_get_int(t3_config_get(flat, "f")) == 4);
+  section = t3_config_get(top, "a");
+  CHECK(t3_config_add_int(section, "b", 7) == T3_ERR_SUCCESS);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(flat, "a"), "b")) == 5);
+  section = t3_config_get(flat, "a");
+  CHECK(t3_config_add_int(section, "c", 8) == T3_ERR_SUCCESS);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(base, "a"), "c")) == 2);
+  /* Sections which are not combined are copied as well. */
+  section = t3_config_get(base, "g");
+  CHECK(t3_config_add_int(section, "h", 10) == T3_ERR_SUCCESS);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(flat, "g"), "h")) == 9);
+
+  t3_config_delete(flat);
+  t3_config_overlay_delete(overlay);
+  t3_config_delete(top);
+  t3_config_delete(base);
+}
+
+/*============================ Merging ============================*/
+
+/** Merge two configs with @p flags, and check that the result equals the config in @p expected. */
+static t3_bool merge_matches(int flags, const char *expected) {
+  t3_config_t *dest = read_config("a {\n b = 1\n c = 2\n}\nl = ( 1, 2 )\n%p = 1\nk = 1\n");
+  t3_config_t *src = read_config("a {\n b = 3\n}\nl = ( 3 )\n%p = 2\nk = 2\nn = 4\n");
+  t3_config_t *result = read_config(expected);
+  t3_bool matches;
+
+  matches = t3_config_merge(dest, src, flags) == T3_ERR_SUCCESS && t3_config_equal(dest, result);
+  t3_config_delete(result);
+  t3_config_delete(dest);
+  return matches;
+}
+
+static void test_merge(void) {
+  t3_config_t *dest, *src;
+
+  CHECK(merge_matches(0, "a {\n b = 3\n c = 2\n}\nl = ( 3 )\n%p = 1\n%p = 2\nk = 2\nn = 4\n"));
+  CHECK(merge_matches(T3_CONFIG_MERGE_KEEP_EXISTING,
+                      "a {\n b = 1\n c = 2\n}\nl = ( 1, 2 )\n%p = 1\n%p = 2\nk = 1\nn = 4\n"));
+  CHECK(merge_matches(T3_CONFIG_MERGE_REPLACE_SECTIONS,
+                      "a {\n b = 3\n}\nl = ( 3 )\n%p = 1\n%p = 2\nk = 2\nn = 4\n"));
+  CHECK(merge_matches(T3_CONFIG_MERGE_APPEND_LISTS,
+                      "a {\n b = 3\n c = 2\n}\nl = ( 1, 2, 3 )\n%p = 1\n%p = 2\nk = 2\nn = 4\n"));
+  CHECK(merge_matches(T3_CONFIG_MERGE_REPLACE_PLISTS,
+                      "a {\n b = 3\n c = 2\n}\nl = ( 3 )\n%p = 2\nk = 2\nn = 4\n"));
+
+  /* The merged config must not be part of another config. */
+  dest = read_config("a {\n b = 1\n}\n");
+  src = read_config("a {\n b = 2\n}\n");
+  CHECK(t3_config_merge(dest, t3_config_get(src, "a"), 0) == T3_ERR_BAD_ARG);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_get(dest, "a"), "b")) == 1);
+  t3_config_delete(src);
+  t3_config_delete(dest);
+}
+
+/*============================ Patches ============================*/
+
+static void test_patch(void) {
+  static const char old_text[] =
+      "a {\n b = 1\n c {\n d = 2\n }\n}\ne = ( 1, 2 )\nf = \"removed\"\n";
+  static const char new_text[] =
+      "a {\n b = 5\n c {\n g = yes\n }\n}\ne = ( 1, 3 )\nh = \"added\"\n";
+  t3_config_t *old_config = read_config(old_text), *new_config = read_config(new_text), *patch;
+  t3_config_t *expected;
+
+  /* Applying the differences to the old config results in the new config. */
+  patch = t3_config_diff(old_config, new_config, NULL);
+  CHECK(patch != NULL);
+  CHECK(t3_config_get_length(t3_config_get(patch, "changes")) == 6);
+  CHECK(t3_config_apply_patch(old_config, patch) == T3_ERR_SUCCESS);
+  CHECK(t3_config_equal(old_config, new_config));
+
+  /* The patch holds copies of the values, which do not change along with the new config. */
+  CHECK(t3_config_add_int(t3_config_get(new_config, "e"), NULL, 4) == T3_ERR_SUCCESS);
+  t3_config_delete(old_config);
+  old_config = read_config(old_text);
+  expected = read_config(new_text);
+  CHECK(t3_config_apply_patch(old_config, patch) == T3_ERR_SUCCESS);
+  CHECK(t3_config_equal(old_config, expected));
+  t3_config_delete(expected);
+  t3_config_delete(patch);
+  t3_config_delete(new_config);
+  t3_config_delete(old_config);
+
+  /* Applying a patch stops at the first change that can not be applied, leaving the preceding
+     changes applied. */
+  patch = read_config(
+      "changes = (\n{\n op = \"add\"\n path = \"x\"\n value = 1\n},\n"
+      "{\n op = \"remove\"\n path = \"missing\"\n},\n"
+      "{\n op = \"add\"\n path = \"y\"\n value = 2\n}\n)\n");
+  old_config = read_config(old_text);
+  CHECK(t3_config_apply_patch(old_config, patch) == T3_ERR_BAD_ARG);
+  CHECK(t3_config_get_int(t3_config_get(old_config, "x")) == 1);
+  CHECK(t3_config_get(old_config, "y") == NULL);
+  t3_config_delete(patch);
+  t3_config_delete(old_config);
+}
+
+/*============================ Hashing ============================*/
+
+static void test_written_hash(void) {
+  t3_config_t *config, *reread;
+  t3_config_error_t error;
+  FILE *file = tmpfile();
+
+  CHECK(file != NULL);
+  if (file == NULL) {
+    return;
+  }
+  config = read_config(
+      "a {\n b = \"some longer string\"\n c = ( 1, 2.5, yes, { d = -3 } )\n}\ne = 1\n");
+  CHECK(t3_config_write_file(config, file) == T3_ERR_SUCCESS);
+  rewind(file);
+  /* A config read back from its written form is equal to the original and has the same hash. */
+  reread = t3_config_read_file(file, &error, NULL);
+  fclose(file);
+  CHECK(reread != NULL && t3_config_equal(config, reread));
+  CHECK(t3_config_hash(config) == t3_config_hash(reread));
+  CHECK(t3_config_add_int(reread, "e", 2) == T3_ERR_SUCCESS && !t3_config_equal(config, reread));
+  t3_config_delete(reread);
+  t3_config_delete(config);
+}
+
+static void test_hash_invalidation(void) {
+  t3_config_t *config, *copy, *b;
+  uint64_t hash;
+
+  config = read_config("a {\n b {\n c = 1\n }\n}\nd = ( 1, 2 )\n");
+  hash = t3_config_hash(config);
+  CHECK(t3_config_hash(config) == hash);
+
+  /* Modifying an item deep in the config changes the hashes of all sections above it. */
+  b = t3_config_get(t3_config_get(config, "a"), "b");
+  CHECK(t3_config_add_int(b, "c", 2) == T3_ERR_SUCCESS);
+  CHECK(t3_config_hash(config) != hash);
+  CHECK(t3_config_add_int(b, "c", 1) == T3_ERR_SUCCESS);
+  CHECK(t3_config_hash(config) == hash);
+
+  /* A copy has the same hash, until either is modified. */
+  copy = t3_config_clone(config, NULL);
+  CHECK(copy != NULL && t3_config_hash(copy) == hash && t3_config_equal(copy, config));
+  b = t3_config_get_mutable(t3_config_get_mutable(copy, "a"), "b");
+  CHECK(b != NULL && t3_config_add_int(b, "c", 3) == T3_ERR_SUCCESS);
+  CHECK(t3_config_hash(copy) != hash);
+  CHECK(t3_config_hash(config) == hash);
+  CHECK(!t3_config_equal(copy, config));
+
+  /* Changing the list type changes the hash as well. */
+  CHECK(t3_config_set_list_type(t3_config_get(config, "d"), T3_CONFIG_PLIST) == T3_ERR_SUCCESS);
+  CHECK(t3_config_hash(config) != hash);
+
+  t3_config_delete(copy);
+  t3_config_delete(config);
+}
+
+static void test_frozen_hash(void) {
+  t3_config_t *config, *frozen, *loaded, *thawed;
+  uint64_t hash;
+  FILE *file;
+
+  config = read_config("a {\n b = \"some longer string\"\n c = ( 1, 2.5, yes )\n}\nd = 1\n");
+  /* The hashes of frozen configs are computed while freezing, without hashing the original. */
+  frozen = t3_config_freeze(config, NULL);
+  CHECK(frozen != NULL);
+  hash = t3_config_hash(config);
+  CHECK(t3_config_hash(frozen) == hash);
+  CHECK(t3_config_hash(t3_config_get(frozen, "a")) == t3_config_hash(t3_config_get(config, "a")));
+  CHECK(t3_config_equal(frozen, config));
+
+  /* Images keep the hashes. */
+  file = tmpfile();
+  CHECK(file != NULL);
+  if (file != NULL) {
+    CHECK(t3_config_write_image(frozen, file) == T3_ERR_SUCCESS);
+    rewind(file);
+    loaded = t3_config_read_image(file, NULL);
+    CHECK(loaded != NULL && t3_config_hash(loaded) == hash);
+    t3_config_delete(loaded);
+    fclose(file);
+  }
+
+  /* A modifiable copy of a frozen config starts with the same hash. */
+  thawed = t3_config_clone(frozen, NULL);
+  CHECK(thawed != NULL && t3_config_hash(thawed) == hash);
+  CHECK(t3_config_add_int(thawed, "d", 2) == T3_ERR_SUCCESS);
+  CHECK(t3_config_hash(thawed) != hash);
+
+  t3_config_delete(thawed);
+  t3_config_delete(frozen);
+  t3_config_delete(config);
+}
+
+/*============================ Lookup handles ============================*/
+
+static void test_lookup_invalidation(void) {
+  t3_config_t *config, *copy, *a, *c;
+  t3_config_lookup_t *lookup_b, *lookup_d;
+
+  config = read_config("a {\n b = 1\n}\nc {\n d = 2\n}\n");
+  a = t3_config_get(config, "a");
+  c = t3_config_get(config, "c");
+  lookup_b = t3_config_lookup_new("a/b", NULL);
+  lookup_d = t3_config_lookup_new("d", NULL);
+  CHECK(lookup_b != NULL && lookup_d != NULL);
+
+  CHECK(t3_config_get_int(t3_config_lookup(lookup_b, config)) == 1);
+  CHECK(t3_config_get_int(t3_config_lookup(lookup_d, c)) == 2);
+
+  /* Replacing the value of an item below the config must be seen. */
+  CHECK(t3_config_add_int(a, "b", 3) == T3_ERR_SUCCESS);
+  CHECK(t3_config_get_int(t3_config_lookup(lookup_b, config)) == 3);
+
+  /* Modifications elsewhere in the tree do not affect the result. */
+  CHECK(t3_config_add_int(config, "e", 4) == T3_ERR_SUCCESS);
+  CHECK(t3_config_lookup(lookup_d, c) == t3_config_get(c, "d"));
+
+  /* Erasing the item and adding it again, possibly at the same address. */
+  t3_config_erase(c, "d");
+  CHECK(t3_config_lookup(lookup_d, c) == NULL);
+  CHECK(t3_config_add_int(c, "d", 5) == T3_ERR_SUCCESS);
+  CHECK(t3_config_get_int(t3_config_lookup(lookup_d, c)) == 5);
+
+  /* After unsharing, the copy has its own items, which the lookup must return. */
+  copy = t3_config_clone(config, NULL);
+  CHECK(copy != NULL);
+  CHECK(t3_config_lookup(lookup_b, copy) == t3_config_lookup(lookup_b, config));
+  a = t3_config_get_mutable(copy, "a");
+  CHECK(a != NULL && t3_config_add_int(a, "b", 6) == T3_ERR_SUCCESS);
+  CHECK(t3_config_get_int(t3_config_lookup(lookup_b, copy)) == 6);
+  CHECK(t3_config_get_int(t3_config_lookup(lookup_b, config)) == 3);
+
+  /* A new config allocated in place of a deleted one has a different generation. */
+  t3_config_delete(copy);
+  copy = read_config("a {\n b = 7\n}\n");
+  CHECK(t3_config_get_int(t3_config_lookup(lookup_b, copy)) == 7);
+
+  t3_config_lookup_delete(lookup_b);
+  t3_config_lookup_delete(lookup_d);
+  t3_config_delete(copy);
+  t3_config_delete(config);
+}
+
+/*============================ Indices ============================*/
+
+static void test_index_invalidation(void) {
+  t3_config_t *config, *list, *item, *other;
+  t3_config_index_t *index;
+
+  config = read_config(
+      "servers = ( { name = \"x\"\n id = 1 }, { name = \"y\"\n id = 2 } )\n"
+      "other {\n z = 1\n}\n");
+  list = t3_config_get(config, "servers");
+  other = t3_config_get(config, "other");
+  index = t3_config_index_by(list, "name", NULL);
+  CHECK(index != NULL);
+
+  item = t3_config_index_get(index, "y");
+  CHECK(t3_config_get_int(t3_config_get(item, "id")) == 2);
+  CHECK(t3_config_index_get(index, "z") == NULL);
+  CHECK(t3_config_index_get_int(index, 1) == NULL);
+
+  /* Changing the key of an item below the list must be seen. */
+  CHECK(t3_config_add_string(item, "name", "z") == T3_ERR_SUCCESS);
+  CHECK(t3_config_index_get(index, "y") == NULL);
+  CHECK(t3_config_index_get(index, "z") == item);
+
+  /* So must adding an item to the list itself. */
+  item = t3_config_add_section(list, NULL, NULL);
+  CHECK(item != NULL && t3_config_add_string(item, "name", "w") == T3_ERR_SUCCESS);
+  CHECK(t3_config_index_get(index, "w") == item);
+
+  /* Modifications outside the list leave the results as they are. */
+  CHECK(t3_config_add_int(other, "z", 2) == T3_ERR_SUCCESS);
+  CHECK(t3_config_index_get(index, "x") == t3_config_get(list, NULL));
+
+  /* Items are found by the first key value, and integer keys are found separately. */
+  CHECK(t3_config_add_string(item, "name", "x") == T3_ERR_SUCCESS);
+  CHECK(t3_config_index_get(index, "x") == t3_config_get(list, NULL));
+  t3_config_index_delete(index);
+  index = t3_config_index_by(list, "id", NULL);
+  CHECK(index != NULL);
+  CHECK(t3_config_get_int(t3_config_get(t3_config_index_get_int(index, 2), "id")) == 2);
+  CHECK(t3_config_index_get(index, "2") == NULL);
+
+  t3_config_index_delete(index);
+  t3_config_delete(config);
+}
+
+/*============================ Memory usage ============================*/
+
+static t3_bool memory_total_matches(const t3_config_memory_t *usage) {
+  return usage->total_bytes == usage->item_bytes + usage->name_bytes + usage->string_bytes +
+                                   usage->expression_bytes + usage->index_bytes;
+}
+
+static void test_memory_usage(void) {
+  static const char long_string[] = "a string too long to be stored in the item";
+  t3_config_t *config, *copy, *frozen;
+  t3_config_memory_t usage, copy_usage, frozen_usage;
+  char name[16];
+  int i;
+
+  config = read_config(
+      "a = \"a string too long to be stored in the item\"\nb = \"short\"\n"
+      "c { x = 1 }; d { x = 1 }\n");
+  CHECK(t3_config_memory_usage(config, &usage) == T3_ERR_SUCCESS);
+  /* The top-level section, a, b, c, d and the two items named x. */
+  CHECK(usage.items == 7);
+  CHECK(usage.item_bytes % usage.items == 0 && usage.item_bytes / usage.items >= 32);
+  /* Sharing, hashing and cached lookups do not make the items larger than 40 bytes on 64-bit
+     platforms. */
+  CHECK(sizeof(void *) != 8 || usage.item_bytes / usage.items == 40);
+  CHECK(usage.string_bytes == sizeof(long_string));
+  CHECK(usage.name_bytes >= 6 * 2);
+  CHECK(usage.expression_bytes == 0 && usage.index_bytes == 0);
+  CHECK(memory_total_matches(&usage));
+  CHECK(t3_config_memory_usage(NULL, &usage) == T3_ERR_BAD_ARG);
+  CHECK(t3_config_memory_usage(config, NULL) == T3_ERR_BAD_ARG);
+
+  /* Shared items are counted once. */
+  copy = t3_config_clone(config, NULL);
+  CHECK(copy != NULL && t3_config_memory_usage(copy, &copy_usage) == T3_ERR_SUCCESS);
+  CHECK(copy_usage.items == usage.items && copy_usage.total_bytes == usage.total_bytes);
+  t3_config_delete(copy);
+  CHECK(t3_config_dedup(config) == T3_ERR_SUCCESS);
+  CHECK(t3_config_memory_usage(config, &copy_usage) == T3_ERR_SUCCESS);
+  CHECK(copy_usage.items == usage.items - 1 && copy_usage.total_bytes < usage.total_bytes);
+  t3_config_delete(config);
+
+  /* Frozen configs use indices for large sections. */
+  config = t3_config_new();
+  for (i = 0; i < 100; i++) {
+    sprintf(name, "key%d", i);
+    CHECK(t3_config_add_int(config, name, i) == T3_ERR_SUCCESS);
+  }
+  frozen = t3_config_freeze(config, NULL);
+  CHECK(t3_config_memory_usage(config, &usage) == T3_ERR_SUCCESS && usage.items == 101);
+  CHECK(frozen != NULL && t3_config_memory_usage(frozen, &frozen_usage) == T3_ERR_SUCCESS);
+  CHECK(frozen_usage.items == usage.items && frozen_usage.index_bytes > 100 * sizeof(uint32_t));
+  CHECK(memory_total_matches(&frozen_usage));
+  t3_config_delete(frozen);
+  t3_config_delete(config);
+}
+
+static void test_schema_memory_usage(void) {
+  t3_config_schema_t *plain, *constrained, *described;
+  t3_config_memory_t plain_usage, constrained_usage, described_usage;
+
+  plain = read_schema("allowed-keys { a { type = \"int\" } }\n");
+  constrained = read_schema(
+      "allowed-keys { a { type = \"int\" } }\n"
+      "%constraint = \"a < 5\"\n");
+  described = read_schema(
+      "allowed-keys { a { type = \"int\" } }\n"
+      "%constraint = \"{a is too large} a < 5\"\n");
+
+  CHECK(t3_config_schema_memory_usage(plain, &plain_usage) == T3_ERR_SUCCESS);
+  CHECK(t3_config_schema_memory_usage(constrained, &constrained_usage) == T3_ERR_SUCCESS);
+  CHECK(t3_config_schema_memory_usage(described, &described_usage) == T3_ERR_SUCCESS);
+
+  CHECK(plain_usage.expression_bytes == 0);
+  /* The constraint consists of at least the top node, the comparison, its two operands and the
+     description. */
+  CHECK(constrained_usage.expression_bytes > 5 * sizeof(void *));
+  /* Without a description, the text of the constraint is used as its description. */
+  CHECK(described_usage.expression_bytes - constrained_usage.expression_bytes ==
+        strlen("a is too large") - strlen("a < 5"));
+  CHECK(described_usage.total_bytes > described_usage.expression_bytes);
+
+  t3_config_delete_schema(plain);
+  t3_config_delete_schema(constrained);
+  t3_config_delete_schema(described);
+}
+
+static const struct {
+  const char *name;
+  void (*test)(void);
+} tests[] = {
+    {"allocator", test_allocator},
+    {"freeze", test_freeze},
+    {"file names", test_file_names},
+    {"image", test_image},
+    {"load static", test_load_static},
+    {"clone sharing", test_clone_sharing},
+    {"dedup", test_dedup},
+    {"paths", test_paths},
+    {"queries", test_queries},
+    {"expressions", test_expressions},
+    {"bind", test_bind},
+    {"overlay", test_overlay},
+    {"merge", test_merge},
+    {"patch", test_patch},
+    {"written hash", test_written_hash},
+    {"hash invalidation", test_hash_invalidation},
+    {"frozen hash", test_frozen_hash},
+    {"lookup invalidation", test_lookup_invalidation},
+    {"index invalidation", test_index_invalidation},
+    {"memory usage", test_memory_usage},
+    {"schema memory usage", test_schema_memory_usage},
+};
+
+int main(int argc, char *argv[]) {
+  size_t i, previous;
+
+  (void)argc;
+  (void)argv;
+
+  /* The allocator must be set before anything is allocated, so it is used for all tests. */
+  t3_config_set_allocator(&counting_allocator);
+
+  for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+    previous = failed;
+    tests[i].test();
+    if (failed != previous) {
+      printf("Test '%s' failed\n", tests[i].name);
+    }
+  }
+  if (allocations.live != retained_allocations) {
+    printf("%ld allocations were not released\n", allocations.live - retained_allocations);
+    failed++;
+  }
+  if (failed != 0) {
+    fprintf(stderr, "%zd checks failed\n", failed);
+    return EXIT_FAILURE;
+  }
+  fprintf(stderr, "Testsuite passed correctly\n");
+  return EXIT_SUCCESS;
+}
@@ -1,6 +1,6 @@
 #!/bin/bash
 
-for i in basic schema_base schema pathcleanse ; do
+for i in basic schema_base schema pathcleanse api ; do
 	echo "Running testsuite $i"
 	(
 		cd $i